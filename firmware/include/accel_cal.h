@@ -0,0 +1,97 @@
+#pragma once
+// accel_cal.h : multi-orientation accelerometer calibration
+// - Model: a = M (u - b), u the uncalibrated reading (g), b the zero-g offset
+//   (g), M symmetric: scale on the diagonal, cross-axis terms off it. At rest
+//   |a| = 1 in every orientation, i.e. u lies on the ellipsoid
+//   (u - b)' M'M (u - b) = 1
+// - The ellipsoid is fitted linearly as a quadric D(u) . v = 1 with
+//   D = [x2, y2, z2, 2yz, 2xz, 2xy, 2x, 2y, 2z]; each sample adds D D' and D
+//   to the normal-equation sums, so no samples are kept, only one 9x9 sum
+//   for the accepted poses and one for the pose being captured
+// - The diagonal model (6 terms) is the same system without the cross
+//   columns: six face-down poses are enough for it; the cross terms also need
+//   poses tilted between every pair of axes and are refused without them
+// - A capture is only merged if the device was still (per-axis std dev under
+//   TL_ACAL_STILL_G) and it is at least TL_ACAL_MIN_POSE_DEG away from every
+//   accepted pose, so a repeated pose cannot dominate the fit
+// - Plain C++ (no Arduino headers): main.cpp feeds it from the sense task and
+//   the solver is verified on synthetic data on the host
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// Calibration terms applied in the acquisition path (ImuBus::setAccelTrim)
+struct AccelTrim {
+  float m[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };   // row-major, symmetric
+  float b[3] = { 0, 0, 0 };                     // g
+  bool cross = false;                           // off-diagonal terms fitted
+  bool valid = false;                           // false: identity, not calibrated
+};
+
+class AccelCalibrator {
+public:
+  enum State : uint8_t { IDLE, COLLECTING, CAPTURING };
+  enum Capture : uint8_t { CAP_NONE, CAP_ACCEPTED, CAP_MOVING, CAP_DUPLICATE, CAP_FULL };
+  enum Error : uint8_t { OK, FEW_POSES, SINGULAR, NEED_TILT, NOT_ELLIPSOID, IMPLAUSIBLE };
+
+  struct Pose {
+    float u[3];      // mean uncalibrated reading, g
+    float sd;        // largest per-axis std dev, g
+    uint16_t n;      // samples
+  };
+
+  struct Result {
+    AccelTrim trim;
+    Error error = OK;
+    float rmsG = 0;  // |a| - 1 over the accepted pose means, after correction
+    float maxG = 0;
+    float rmsRawG = 0;   // the same before correction
+  };
+
+  // Discard everything and collect for device imu
+  void start(uint8_t imu);
+  void cancel() { _state = IDLE; }
+  // Arm a capture of n samples; false unless COLLECTING with room for a pose
+  bool capture(uint16_t n = TL_ACAL_POSE_SAMPLES);
+  // One uncalibrated sample (g); ignored unless CAPTURING
+  void push(float x, float y, float z);
+  // Fit the accepted poses; cross adds the off-diagonal terms
+  Result solve(bool cross) const;
+
+  static const char* errorName(Error e);
+  static const char* captureName(Capture c);
+  static uint8_t params(bool cross) { return cross ? 9 : 6; }
+
+  State state() const { return _state; }
+  uint8_t imu() const { return _imu; }
+  uint16_t captured() const { return _stage.n; }
+  uint16_t target() const { return _target; }
+  Capture lastCapture() const { return _last; }
+  uint8_t poseCount() const { return _poses; }
+  const Pose& pose(uint8_t i) const { return _pose[i]; }
+  uint8_t faces() const;   // bit per face covered: +X -X +Y -Y +Z -Z
+  uint32_t samples() const { return _sum.n; }
+
+private:
+  struct Sums {
+    double s[9][9];  // upper triangle of sum D D'
+    double r[9];     // sum D
+    uint32_t n;
+    void clear();
+    void add(const double d[9]);
+    void merge(const Sums& o);
+  };
+
+  void finishCapture();
+
+  State _state = IDLE;
+  Capture _last = CAP_NONE;
+  uint8_t _imu = 0;
+  uint8_t _poses = 0;
+  uint16_t _target = 0;
+  Sums _sum = {}, _stage = {};
+  double _mean[3] = {}, _m2[3] = {};   // Welford over the capture, for the stillness test
+  Pose _pose[TL_ACAL_MAX_POSES] = {};
+};
@@ -0,0 +1,50 @@
+#pragma once
+// acq_profile.h : named acquisition profiles (sensor registers + derived filters)
+// - A profile holds the MPU's DLPF, SMPLRT_DIV and full-scale ranges, the
+//   coefficients the sense task derives its values with (level EMA and peak
+//   decay time constants, accel deadband), the active publish rate and the
+//   poll period the UI falls back to
+// - Presets: "general" is the config.h defaults on the library's register
+//   setup (DLPF off, +-250 deg/s, +-2 g), what every unit ran before profiles;
+//   "parked" filters hard and publishes slowly for leveling; "towing" widens
+//   the ranges, keeps more bandwidth and holds peaks longer
+// - /profile picks a preset and may override single values; acqProfileError()
+//   checks the result before main.cpp applies it (under StateLock, between two
+//   sense ticks) and persists it
+// - The sense tick stays at TL_SAMPLE_HZ in every profile: the spectrum, sway
+//   bank and recorder are built on that rate. SMPLRT_DIV only sets how often
+//   the MPU refreshes its output registers, which must keep up with the tick
+// - Plain C++ (no Arduino headers): presets and checks run on the host
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+struct AcqProfile {
+  char name[12];             // preset it was built from
+  // MPU registers; ranges use MPU6050_light's setGyroConfig/setAccConfig numbering
+  uint8_t dlpf;              // CONFIG DLPF_CFG 0..6 (acqDlpfHz)
+  uint8_t smplrtDiv;         // output rate = gyro rate / (1 + div) (acqOutputHz)
+  uint8_t gyroRange;         // 0..3: +-250/500/1000/2000 deg/s
+  uint8_t accRange;          // 0..3: +-2/4/8/16 g
+  // Derived values
+  uint16_t levelAvgTauMs;    // level gauge EMA
+  uint16_t accelPeakTauMs;   // peak-hold decay
+  uint16_t rollPeakTauMs;
+  float accelDeadbandG;      // per axis, after gravity removal
+  uint8_t publishHz;         // frame rate while ACTIVE (power_policy.h)
+  uint16_t uiPollMs;         // UI poll period when it cannot stream and has no ?ms=
+};
+
+extern const AcqProfile kAcqPresets[];
+extern const uint8_t kAcqPresetCount;
+
+const AcqProfile* acqPreset(const char* name);   // nullptr if there is none by that name
+const char* acqProfileError(const AcqProfile& p); // nullptr if p can be applied
+
+float acqDlpfHz(uint8_t dlpf);                    // accel bandwidth
+float acqOutputHz(const AcqProfile& p);           // output register refresh rate
+uint32_t acqSettleMs(const AcqProfile& p);        // after a register change, until samples are valid
+inline uint8_t acqAccRangeG(uint8_t r) { return (uint8_t)(2u << r); }
+inline uint16_t acqGyroRangeDps(uint8_t r) { return (uint16_t)(250u << r); }
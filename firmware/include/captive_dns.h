@@ -0,0 +1,52 @@
+#pragma once
+// captive_dns.h : wildcard captive-portal DNS in its own task
+// - Blocks in recvfrom() on UDP/53 (no polling); pinned to TL_NET_CORE
+// - Every A/ANY query is answered with the AP IP from a prebuilt answer
+//   record; TL_DOMAIN gets TL_DNS_OWN_TTL_SECONDS, anything else (probe hosts)
+//   TL_DNS_TTL_SECONDS. Other types get an empty NOERROR reply
+// - Per-client token bucket (TL_DNS_RL_QPS / TL_DNS_RL_BURST): excess queries
+//   are dropped so a phone's probe storm costs no more than its allowance
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#include "config.h"
+#include "task_load.h"
+
+class CaptiveDns {
+public:
+  struct Stats {
+    uint32_t queries = 0;      // datagrams received
+    uint32_t answered = 0;     // replies carrying an A record
+    uint32_t empty = 0;        // NOERROR replies without answers (AAAA, HTTPS, ...)
+    uint32_t ownDomain = 0;    // queries for TL_DOMAIN
+    uint32_t rateLimited = 0;  // dropped by the per-client limiter
+    uint32_t malformed = 0;    // not a standard single-question query
+  };
+
+  bool begin(IPAddress ip);   // binds UDP/53 and starts the task (once)
+  void setIP(IPAddress ip);   // AP restarted: answer with the new address
+
+  const Stats& stats() const { return _stats; }
+  TaskLoad& load() { return _load; }
+
+private:
+  struct Bucket { uint32_t addr; uint32_t lastMs; float tokens; };
+
+  static void taskEntry(void* arg);
+  void run();
+  bool admit(uint32_t addr, uint32_t nowMs);
+  size_t answer(uint8_t* pkt, size_t len, size_t cap);
+
+  // Answer record appended after the echoed question:
+  // name ptr C00C, type A, class IN, TTL, rdlength 4, address
+  static constexpr size_t kAnswerLen = 16;
+  void buildAnswer(uint8_t* rec, uint32_t ttl, IPAddress ip);
+
+  int _fd = -1;
+  uint8_t _ansOwn[kAnswerLen] = {};
+  uint8_t _ansOther[kAnswerLen] = {};
+  Bucket _buckets[TL_DNS_RL_CLIENTS] = {};
+  Stats _stats;
+  TaskLoad _load;
+};
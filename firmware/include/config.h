@@ -18,12 +18,49 @@
 #define TL_AP_GATEWAY            "192.168.4.1"
 #define TL_AP_NETMASK            "255.255.255.0"
 
-// DNS captive portal TTL (seconds)
+// DNS captive portal TTL (seconds) for probe/foreign names, and the longer TTL
+// handed out for TL_DOMAIN itself
 #define TL_DNS_TTL_SECONDS       1
+#define TL_DNS_OWN_TTL_SECONDS   300
+
+// Captive DNS per-client rate limit: sustained queries/s, burst size, and how
+// many client addresses are tracked at once
+#define TL_DNS_RL_QPS            20.0f
+#define TL_DNS_RL_BURST          40.0f
+#define TL_DNS_RL_CLIENTS        8
 
 // HTTP port for the built-in server
 #define TL_HTTP_PORT             80
 
+// Event-driven HTTP server: simultaneous connections, per-connection request
+// buffer (request line + headers + body, bytes) and idle timeout (ms)
+#define TL_HTTP_MAX_CLIENTS      8
+#define TL_HTTP_RX_BUF           1536
+#define TL_HTTP_IDLE_TIMEOUT_MS  5000
+
+// /stream subscriber with a frame pending that accepts no bytes for this long
+// (ms) is treated as gone and closed
+#define TL_HTTP_STREAM_STALL_MS  10000
+
+// Per-request scratch (request_arena.h): JSON documents, the serialized body
+// and the response head of the handler being run. Larger answers fall back to
+// the heap (overflows in /diag). Extra handler headers per response (bytes)
+#define TL_HTTP_ARENA_BYTES      8192
+#define TL_HTTP_EXTRA_HEADERS    256
+
+// Persistent connections for API routes: idle time allowed between requests
+// (ms) and requests served before the server closes the connection
+#define TL_HTTP_KEEPALIVE_IDLE_MS      15000
+#define TL_HTTP_KEEPALIVE_MAX_REQUESTS 200
+
+// Optional station mode (set via /station): joins the vehicle's Wi-Fi next to
+// the SoftAP and multicasts binary telemetry (telemetry_packet.h) there.
+// TTL 1 keeps frames on the local segment; rate is per-device configurable.
+#define TL_MCAST_GROUP           "239.255.76.76"
+#define TL_MCAST_PORT            47600
+#define TL_MCAST_TTL             1
+#define TL_MCAST_DEFAULT_HZ      20
+
 // SoftAP transmit power (see WiFi.h: WIFI_POWER_* constants)
 #define TL_AP_TX_POWER           WIFI_POWER_8_5dBm
 
@@ -31,10 +68,127 @@
 #define TL_DEFAULT_SSID          "TrailerLevel"
 #define TL_DEFAULT_PASSWORD      "password"
 
+// ----------------------- Firmware update ------------------------------------
+// POST /update streams an image into the inactive OTA slot of the core's
+// default.csv (two 1.25 MB app slots on 4 MB flash). Requests must carry
+// "Authorization: Bearer <TL_OTA_TOKEN>"; an empty token disables the
+// endpoint. A new image has TL_OTA_CONFIRM_MS of healthy running (sense task
+// ticking) to confirm itself, or the next reset rolls back to the old slot.
+// The sense task keeps its priority through an upload (it is alone on
+// TL_SENSE_CORE, so there is nothing to yield to); flash erases still stall
+// it, and the longest gap between its ticks is reported with the result.
+// The reboot follows a successful upload after TL_OTA_REBOOT_DELAY_MS
+#define TL_OTA_TOKEN             ""
+#define TL_OTA_CONFIRM_MS        30000
+#define TL_OTA_REBOOT_DELAY_MS   1000
+
+// ----------------------- Tasks & Cores ---------------------------------------
+// Sensing/processing runs alone on TL_SENSE_CORE at high priority; HTTP, DNS,
+// mDNS and Wi-Fi share TL_NET_CORE. Arduino loop() (housekeeping) and the
+// Wi-Fi event task follow ARDUINO_RUNNING_CORE / ARDUINO_EVENT_RUNNING_CORE in
+// platformio.ini, which must match TL_NET_CORE.
+#define TL_SENSE_CORE            1
+#define TL_NET_CORE              0
+
+// Stack sizes (bytes) and FreeRTOS priorities
+#define TL_SENSE_TASK_STACK      6144
+#define TL_SENSE_TASK_PRIO       5
+#define TL_HTTP_TASK_STACK       6144
+#define TL_HTTP_TASK_PRIO        2
+#define TL_DNS_TASK_STACK        3072
+#define TL_DNS_TASK_PRIO         1
+#define TL_LOOP_TASK_STACK       8192   // Arduino loop() task, priority 1
+
 // ----------------------- Sensors & UI ----------------------------------------
 // I2C pins for MPU-6050/6500/9250 family
 #define TL_I2C_SDA_PIN           13
 #define TL_I2C_SCL_PIN           12
+#define TL_I2C_CLOCK_HZ          400000
+
+// IMUs on that bus, read back to back every sample tick. Slot 0 is the primary
+// (front axle / hitch end, AD0 low) and drives the main gauges; slot 1 (rear
+// axle, AD0 high) is optional and adds per-axle and frame-twist readings.
+#define TL_IMU_MAX               2
+#define TL_IMU_ADDRS             { 0x68, 0x69 }
+
+// Fixed sampling rate (Hz): the IMU is read and EMA/peaks advance on this clock,
+// independent of how many clients are polling
+#define TL_SAMPLE_HZ             100
+
+// Telemetry publish rate (Hz) of the "general" profile: each frame is
+// serialized once and shared by every /sensor poll and /stream subscriber
+#define TL_PUBLISH_HZ            10
+
+// Delta stream (/stream?enc=delta, frame_delta.h): keyframe interval (ms),
+// most fields a frame may carry, the largest encoded frame (bytes), and the
+// sway amplitude (g) under which sway_hz is noise and sent as 0
+#define TL_STREAM_KEY_MS         30000
+#define TL_STREAM_MAX_FIELDS     64
+#define TL_STREAM_FRAME_MAX      2048
+#define TL_STREAM_SWAY_FLOOR_G   0.005f
+
+// ----------------------- Power ----------------------------------------------
+// Presence-driven policy (power_policy.h). With no AP client, /stream
+// subscriber, station link or HTTP request for TL_PWR_IDLE_AFTER_MS the CPU
+// runs at TL_PWR_IDLE_MHZ (>= 80 while Wi-Fi is up), frames are published at
+// TL_PWR_IDLE_PUBLISH_HZ and loop() wakes every TL_PWR_IDLE_LOOP_MS. Sampling
+// stays at TL_SAMPLE_HZ; IDLE is refused if the sense task would need more
+// than TL_PWR_SENSE_MAX_PCT of its core at the idle clock.
+#define TL_PWR_ACTIVE_MHZ        240
+#define TL_PWR_IDLE_MHZ          80
+#define TL_PWR_IDLE_AFTER_MS     30000
+#define TL_PWR_IDLE_PUBLISH_HZ   1
+#define TL_PWR_ACTIVE_LOOP_MS    20
+#define TL_PWR_IDLE_LOOP_MS      200
+#define TL_PWR_SENSE_MAX_PCT     40.0f
+
+// Spectrum analysis (/spectrum, sway metric): FFT window in samples (power of
+// two; 512 at 100 Hz = 5.1 s, 0.2 Hz bins), recompute rate (Hz) and the band
+// searched for the dominant lateral sway peak
+#define TL_FFT_N                 512
+#define TL_SPECTRUM_HZ           2
+#define TL_SWAY_MIN_HZ           0.3f
+#define TL_SWAY_MAX_HZ           3.0f
+
+// Sway alert (Goertzel bank on yaw rate and lateral accel): band and number of
+// bins, resonator time constant (s, sets bin width ~1/(pi*tau) Hz), input DC
+// blocker time constant (s), default thresholds (amplitude; /sway overrides,
+// persisted), hold time (ms) before raising or clearing, and log length
+#define TL_SWAY_ALERT_MIN_HZ     0.5f
+#define TL_SWAY_ALERT_MAX_HZ     1.5f
+#define TL_SWAY_ALERT_BINS       9
+#define TL_SWAY_ALERT_TAU_S      3.0f
+#define TL_SWAY_ALERT_DC_TAU_S   10.0f
+#define TL_SWAY_ALERT_YAW_DPS    4.0f
+#define TL_SWAY_ALERT_LAT_G      0.05f
+#define TL_SWAY_ALERT_HOLD_MS    1500
+#define TL_SWAY_ALERT_LOG_LEN    16
+
+// Flight recorder (PSRAM): ring length, seconds kept before and after a
+// trigger, and the default gravity-free accel trigger (g; POST /recorder
+// overrides, persisted). Ring must exceed pre + post so the capture can be
+// copied off the ring while it keeps running
+#define TL_REC_RING_S            60
+#define TL_REC_PRE_S             20
+#define TL_REC_POST_S            10
+#define TL_REC_TRIG_ACCEL_G      0.6f
+
+// Accelerometer calibration (/calibrate/accel, accel_cal.h): samples per
+// pose (at TL_SAMPLE_HZ), largest per-axis std dev (g) for a pose to count as
+// still, minimum angle (deg) between poses, pose limit, and the plausibility
+// limits a fit must meet before it is applied: zero-g offset (g) and scale
+// error (fraction) per axis
+#define TL_ACAL_POSE_SAMPLES     200
+#define TL_ACAL_STILL_G          0.02f
+#define TL_ACAL_MIN_POSE_DEG     20.0f
+#define TL_ACAL_MAX_POSES        16
+#define TL_ACAL_MAX_OFFSET_G     0.3f
+#define TL_ACAL_MAX_SCALE_ERR    0.15f
+
+// Acquisition profiles (acq_profile.h, /profile): MPU filter/ranges and the
+// derived values below switch at runtime and persist. The TL_* defaults here
+// are the "general" profile; TL_ACQ_PROFILE is the one a fresh unit starts in
+#define TL_ACQ_PROFILE           "general"
 
 // Running average time constant (ms) for Leveling gauge (EMA - display only)
 #define TL_LEVEL_AVG_TAU_MS      600
@@ -45,7 +199,7 @@
 // Per-axis deadband after gravity removal (in g). Lower = more sensitive.
 #define TL_ACCEL_DEADBAND_G      0.0f
 
-// Default UI polling period hint (ms) – UI can override via ?ms=
+// Default UI polling period hint (ms, /profile ui_poll_ms) – UI can override via ?ms=
 #define TL_UI_DEFAULT_POLL_MS    200
 
 // ----------------------- Peak-Hold (Decay) -----------------------------------
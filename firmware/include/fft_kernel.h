@@ -0,0 +1,62 @@
+#pragma once
+// fft_kernel.h : portable radix-2 complex FFT and real-pair split
+// - Plain C++ (no Arduino headers); used on the host and as the fallback when
+//   esp-dsp is not available (spectrum.cpp)
+// - Data is interleaved re/im floats, n a power of two, transformed in place
+// - Two real signals ride one complex transform (x in re, y in im);
+//   fftSplitPair() recovers |X[k]| and |Y[k]| for k = 0..n/2
+
+#include <stddef.h>
+#include <math.h>
+
+// tw: n floats, cos/-sin pairs for k = 0..n/2-1
+inline void fftTwiddles(float* tw, size_t n) {
+  for (size_t k = 0; k < n / 2; ++k) {
+    const double a = 2.0 * M_PI * (double)k / (double)n;
+    tw[2 * k] = (float)cos(a);
+    tw[2 * k + 1] = (float)-sin(a);
+  }
+}
+
+inline void fftBitReverse(float* d, size_t n) {
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      float t = d[2 * i]; d[2 * i] = d[2 * j]; d[2 * j] = t;
+      t = d[2 * i + 1]; d[2 * i + 1] = d[2 * j + 1]; d[2 * j + 1] = t;
+    }
+  }
+}
+
+// Iterative decimation in time; expects bit-reversed input order
+inline void fftRadix2(float* d, size_t n, const float* tw) {
+  for (size_t len = 2; len <= n; len <<= 1) {
+    const size_t half = len >> 1, step = n / len;
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t k = 0; k < half; ++k) {
+        const float wr = tw[2 * k * step], wi = tw[2 * k * step + 1];
+        float* a = d + 2 * (i + k);
+        float* b = d + 2 * (i + k + half);
+        const float tr = b[0] * wr - b[1] * wi;
+        const float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr; b[1] = a[1] - ti;
+        a[0] += tr;       a[1] += ti;
+      }
+    }
+  }
+}
+
+// Magnitudes of the two real spectra packed in one complex FFT result:
+// X = (Z[k] + conj(Z[n-k])) / 2, Y = (Z[k] - conj(Z[n-k])) / 2j
+inline void fftSplitPair(const float* z, size_t n, float* magX, float* magY) {
+  for (size_t k = 0; k <= n / 2; ++k) {
+    const size_t m = (n - k) & (n - 1);
+    const float ar = z[2 * k], ai = z[2 * k + 1], br = z[2 * m], bi = z[2 * m + 1];
+    const float xr = 0.5f * (ar + br), xi = 0.5f * (ai - bi);
+    const float yr = 0.5f * (ai + bi), yi = 0.5f * (br - ar);
+    if (magX) magX[k] = sqrtf(xr * xr + xi * xi);
+    if (magY) magY[k] = sqrtf(yr * yr + yi * yi);
+  }
+}
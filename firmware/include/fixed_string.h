@@ -0,0 +1,89 @@
+#pragma once
+// fixed_string.h : fixed-capacity, NUL-terminated string with inline storage
+// - Replaces Arduino String where the bound is known (SSIDs, passwords, URLs,
+//   hints, small responses): no heap, copyable, safe to keep in globals shared
+//   between tasks under StateLock
+// - Writes past N characters are cut and truncated() reports it, so input
+//   validation can reject over-long values instead of silently storing a prefix
+// - Plain C++ (no Arduino headers)
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+template <size_t N>
+class FixedString {
+public:
+  FixedString() { _s[0] = 0; }
+  FixedString(const char* s) { assign(s); }
+
+  FixedString& assign(const char* s, size_t n) { clear(); return append(s, n); }
+  FixedString& assign(const char* s) { return assign(s, s ? strlen(s) : 0); }
+  FixedString& operator=(const char* s) { return assign(s); }
+
+  FixedString& append(const char* s, size_t n) {
+    if (n > N - _len) { n = N - _len; _truncated = true; }
+    memcpy(_s + _len, s, n);
+    _len += n; _s[_len] = 0;
+    return *this;
+  }
+  FixedString& append(const char* s) { return append(s, s ? strlen(s) : 0); }
+  FixedString& append(char c) { return append(&c, 1); }
+  FixedString& appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list ap; va_start(ap, fmt);
+    const int n = vsnprintf(_s + _len, N - _len + 1, fmt, ap);
+    va_end(ap);
+    if (n < 0) { _s[_len] = 0; return *this; }
+    if ((size_t)n > N - _len) { _len = N; _truncated = true; } else _len += n;
+    return *this;
+  }
+  // Inserts s at the front; the tail is cut if it no longer fits
+  FixedString& prepend(const char* s, size_t n) {
+    if (n > N) { n = N; _truncated = true; }
+    size_t keep = _len;
+    if (keep > N - n) { keep = N - n; _truncated = true; }
+    memmove(_s + n, _s, keep);
+    memcpy(_s, s, n);
+    _len = n + keep; _s[_len] = 0;
+    return *this;
+  }
+
+  void clear() { _len = 0; _s[0] = 0; _truncated = false; }
+  void trim() {
+    size_t b = 0, e = _len;
+    while (b < e && isspace((unsigned char)_s[b])) ++b;
+    while (e > b && isspace((unsigned char)_s[e - 1])) --e;
+    memmove(_s, _s + b, e - b);
+    _len = e - b; _s[_len] = 0;
+  }
+  // assign() of s less its leading/trailing blanks: the bound applies to what
+  // is kept, so padding cannot make a value that fits read as truncated
+  FixedString& assignTrimmed(const char* s) {
+    if (!s) return assign(s);
+    size_t n = strlen(s);
+    while (n && isspace((unsigned char)*s)) { ++s; --n; }
+    while (n && isspace((unsigned char)s[n - 1])) --n;
+    return assign(s, n);
+  }
+  void toUpperCase() { for (size_t i = 0; i < _len; ++i) _s[i] = (char)toupper((unsigned char)_s[i]); }
+  void toLowerCase() { for (size_t i = 0; i < _len; ++i) _s[i] = (char)tolower((unsigned char)_s[i]); }
+
+  const char* c_str() const { return _s; }
+  size_t length() const { return _len; }
+  bool empty() const { return _len == 0; }
+  bool truncated() const { return _truncated; }
+  char operator[](size_t i) const { return _s[i]; }
+  static constexpr size_t capacity() { return N; }
+
+  bool operator==(const char* s) const { return s && !strcmp(_s, s); }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  template <size_t M> bool operator==(const FixedString<M>& o) const { return !strcmp(_s, o.c_str()); }
+  template <size_t M> bool operator!=(const FixedString<M>& o) const { return !(*this == o); }
+
+private:
+  char _s[N + 1];
+  size_t _len = 0;
+  bool _truncated = false;
+};
@@ -0,0 +1,111 @@
+#pragma once
+// flight_recorder.h : PSRAM pre-trigger recorder of full-rate raw IMU samples
+// - The sense task appends every sample (register counts of every IMU plus a
+//   timestamp) to a TL_REC_RING_S second ring in PSRAM; the normal-path cost
+//   is one 28-byte store and a compare
+// - Triggers: gravity-free accel magnitude crossing the threshold, sway alert raised, or
+//   manual (requestTrigger()). The window is TL_REC_PRE_S seconds before the
+//   trigger and TL_REC_POST_S after it; triggers during a capture are counted
+//   and ignored
+// - Once the post window is in, service() (loop task, TL_NET_CORE) copies it
+//   into a refcounted PSRAM capture while the ring keeps running; the newest
+//   capture stays downloadable until the next one replaces it
+// - Capture layout (little endian, no padding; N = TL_IMU_MAX), read by
+//   tools/rec_dump:
+//
+//  off  type     field (RecHeader, 32 + 8N bytes)
+//    0  char[4]  magic "TLFR"
+//    4  u16      version, u16 sampleSize (4 + 12N)
+//    8  u32      count, triggerIndex, triggerMs
+//   20  u16      sampleHz, u8 kind, u8 imuMask
+//   24  f32      value, accLsbPerG[N], gyroLsbPerDps[N]
+//       u32      reserved
+//  then count x RecSample: u32 us, i16 raw[N][6] (ax ay az gx gy gz counts)
+// - Without PSRAM begin() fails and record() does nothing
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "config.h"
+#include "imu_bus.h"
+#include "shared_frame.h"
+
+struct RecSample {                    // 28 bytes
+  uint32_t us;                        // micros() at the primary IMU read
+  int16_t raw[TL_IMU_MAX][6];         // accel xyz, gyro xyz counts per IMU (0: absent)
+};
+
+struct RecHeader {                    // 48 bytes
+  char magic[4];                      // "TLFR"
+  uint16_t version;                   // 1
+  uint16_t sampleSize;                // sizeof(RecSample)
+  uint32_t count;                     // samples that follow
+  uint32_t triggerIndex;              // sample index of the trigger
+  uint32_t triggerMs;                 // device uptime at the trigger
+  uint16_t sampleHz;
+  uint8_t kind;                       // FlightRecorder::Kind
+  uint8_t imuMask;                    // bit i: IMU i present
+  float value;                        // accel trigger: magnitude in g
+  float accLsbPerG[TL_IMU_MAX];       // count scales at the trigger
+  float gyroLsbPerDps[TL_IMU_MAX];
+  uint32_t reserved;
+};
+
+class FlightRecorder {
+public:
+  enum Kind : uint8_t { NONE = 0, ACCEL = 1, SWAY = 2, MANUAL = 3 };
+
+  struct Stats {
+    uint32_t triggers = 0;     // captures started
+    uint32_t ignored = 0;      // triggers while a capture was in progress
+    uint32_t captures = 0;     // windows frozen and published
+    uint32_t lost = 0;         // windows overwritten before service() copied them / no memory
+    uint32_t samples = 0;      // record() calls
+    uint64_t cycles = 0;       // CPU cycles spent in record()
+    uint32_t maxCycles = 0;
+  };
+
+  bool begin();
+  bool enabled() const { return _ring != nullptr; }
+
+  // Sense task, once per sample
+  void record(const ImuBus& bus, float accelMagG, bool swayRaised, uint32_t nowMs);
+
+  // Any task
+  void requestTrigger() { _manual.store(true, std::memory_order_relaxed); }
+  void setAccelThreshold(float g) { _accelG = g; }
+  float accelThreshold() const { return _accelG; }
+  bool capturing() const { return _state.load(std::memory_order_acquire) != ARMED; }
+  uint32_t written() const { return _written; }
+  SharedFrame* acquireCapture() { return _capture.acquire(); }   // caller unrefs
+  const Stats& stats() const { return _stats; }
+
+  // Loop task: freezes a completed window
+  void service();
+
+  static constexpr uint32_t kRingLen = TL_REC_RING_S * TL_SAMPLE_HZ;
+  static constexpr uint32_t kPreLen = TL_REC_PRE_S * TL_SAMPLE_HZ;
+  static constexpr uint32_t kPostLen = TL_REC_POST_S * TL_SAMPLE_HZ;
+
+private:
+  enum State : uint8_t { ARMED, CAPTURING, READY };
+  static_assert(sizeof(RecSample) == 4 + 12 * TL_IMU_MAX, "RecSample must stay packed");
+  static_assert(sizeof(RecHeader) == 32 + 8 * TL_IMU_MAX, "RecHeader layout is the file format");
+  static_assert(kPreLen + kPostLen < kRingLen, "ring must hold pre + post with slack for service()");
+
+  void start(Kind kind, float value, const ImuBus& bus, uint32_t nowMs);
+
+  RecSample* _ring = nullptr;
+  uint32_t _written = 0;              // samples ever recorded (ring index = _written % kRingLen)
+  std::atomic<uint8_t> _state{ARMED};
+  std::atomic<bool> _manual{false};
+  volatile float _accelG = TL_REC_TRIG_ACCEL_G;
+  bool _accelHigh = false;
+
+  // Set by start()/record() on the sense task, read by service() once READY
+  RecHeader _hdr = {};
+  uint32_t _winStart = 0, _winEnd = 0;   // absolute sample numbers [start, end)
+
+  FrameSlot _capture;
+  Stats _stats;
+};
@@ -0,0 +1,74 @@
+#pragma once
+// frame_delta.h : keyframe + delta encoding of the telemetry stream
+// - A frame is a vector of numeric fields, each with a quantum (step) and a
+//   deadband. A keyframe carries every field's name, step and quantized
+//   value; a delta carries only the fields whose quantized value has moved at
+//   least the deadband away from the keyframe's, as the change in steps
+// - Deltas are relative to the last keyframe, never to each other, so a
+//   client that misses deltas (the SSE fan-out drops frames for a slow
+//   subscriber) decodes the next one exactly. A delta naming a keyframe the
+//   client does not hold is its cue to resync: /stream?enc=delta opens every
+//   subscription with the latest keyframe
+// - Keyframes only rebase the deltas (resync comes from the subscription),
+//   so they are rare: every keyMs of device time, and whenever the field
+//   count changes (second IMU found or lost) or a frame did not fit
+// - Wire format, JSON so the UI takes it with JSON.parse:
+//     keyframe  {"seq":S,"key":S,"t_us":T,"pub_us":P,"fields":[...],"step":[...],"q":[...]}
+//     delta     [S,S-K,(T-Tk)/1000,P-T,i,dq,i,dq,...]
+//   K and Tk are the keyframe's seq and t_us (frame time in ms after it),
+//   i a field index, dq the change since the keyframe in steps. A delta with
+//   nothing past its deadband is the four header numbers, under 20 bytes
+// - A decoded value is (q + dq) * step; it stays within the deadband of the
+//   device's value (within step / 2 for deadband <= step)
+// - Plain C++ (no Arduino headers): main.cpp feeds it from the sense task and
+//   it is measured on sensor traces on the host
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+struct StreamField {
+  const char* name;   // path in the /sensor document: "a.b" is member b of object a, "a.1.b" of element 1 of array a
+  float step;         // quantum, in the field's unit
+  float deadband;     // changes since the keyframe smaller than this are not sent
+};
+
+class DeltaEncoder {
+public:
+  struct Stats {
+    uint32_t keys = 0;
+    uint32_t deltas = 0;
+    uint32_t still = 0;        // deltas with no field past its deadband
+    uint32_t overflows = 0;    // frames that did not fit the caller's buffer
+    uint64_t keyBytes = 0, deltaBytes = 0;
+    uint16_t maxDelta = 0;     // largest delta, bytes
+  };
+
+  DeltaEncoder(const StreamField* fields, uint8_t count, uint32_t keyMs = TL_STREAM_KEY_MS);
+
+  // Encodes the first n fields of v (fields beyond n are absent from the
+  // document). Writes the NUL-terminated frame to out and returns its
+  // length; 0 if it did not fit in cap (the next frame is a keyframe).
+  size_t encode(const float* v, uint8_t n, uint32_t seq, int64_t tUs, int64_t pubUs, char* out, size_t cap);
+
+  void requestKey() { _needKey = true; }
+  bool lastWasKey() const { return _lastKey; }
+  const Stats& stats() const { return _stats; }
+  uint8_t fieldCount() const { return _count; }
+
+private:
+  size_t keyframe(const int32_t* q, uint8_t n, uint32_t seq, int64_t tUs, int64_t pubUs, char* out, size_t cap);
+  size_t delta(const int32_t* q, uint32_t seq, int64_t tUs, int64_t pubUs, char* out, size_t cap);
+
+  const StreamField* _f;
+  uint8_t _count;
+  uint32_t _keyMs;
+  bool _needKey = true, _lastKey = false;
+  uint8_t _n = 0;                            // fields in the current keyframe
+  uint32_t _keySeq = 0;
+  int64_t _keyUs = 0;
+  int32_t _keyQ[TL_STREAM_MAX_FIELDS] = {};  // the keyframe, in steps
+  int32_t _dbq[TL_STREAM_MAX_FIELDS] = {};   // deadbands, in steps (>= 1)
+  Stats _stats;
+};
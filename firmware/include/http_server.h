@@ -0,0 +1,164 @@
+#pragma once
+// http_server.h : event-driven, multi-connection HTTP/1.x server on lwIP sockets
+// - One FreeRTOS task (pinned to TL_NET_CORE) multiplexes the listen socket and up to TL_HTTP_MAX_CLIENTS
+//   connections with select(); a slow or idle client never blocks the others
+// - Routes come from a constexpr perfect-hash table (route_table.h); handlers
+//   use a WebServer-like request API (findArg/sendHeader/send)
+// - ROUTE_CORS routes get CORS headers on every response, and OPTIONS preflight
+//   is answered from the route's method mask without a handler
+// - HEAD is served by a route that takes GET: the handler sees HTTP_GET and
+//   answers as usual, and only the head goes out (Content-Length of the GET
+//   body); a HEAD on an event stream gets the head and a close
+// - ROUTE_KEEPALIVE routes answer HTTP/1.1 persistent connections
+//   (idle TL_HTTP_KEEPALIVE_IDLE_MS, at most TL_HTTP_KEEPALIVE_MAX_REQUESTS);
+//   pipelined requests are answered in order from the buffered bytes
+// - ROUTE_UPLOAD routes take bodies of any size: once the headers are in, the
+//   route's upload handler sees START, then one WRITE per received chunk (at
+//   most TL_HTTP_RX_BUF minus the head) and END, after which the route handler
+//   answers as usual. Answering from START or WRITE refuses the rest of the
+//   body; a dropped or timed-out connection gets ABORTED (no request context)
+// - Handlers run one at a time on the server task; the request context below is
+//   only valid inside a handler
+// - Telemetry fan-out: sendFrame() answers a poll with a SharedFrame, and
+//   beginStream() turns the connection into an SSE subscriber that receives
+//   every frame passed to broadcast() on its channel (kChannels encodings of
+//   the same telemetry); each frame is serialized once, per-client cost is
+//   only the socket write. A slow subscriber skips frames, but a queued
+//   keyframe is never replaced by a non-key frame that depends on it; one
+//   that takes no bytes for TL_HTTP_STREAM_STALL_MS (gone without a FIN) is
+//   closed so it does not hold a connection slot
+// - Request memory: handlers allocate from a per-request arena (arena(); reset
+//   before every dispatch); headers and bodies are copied and query arguments
+//   decoded there, not into String. A response still unsent when its handler returns keeps only its
+//   remaining bytes, moved to the heap (arenaSpills)
+
+#include <Arduino.h>
+#include <HTTP_Method.h>
+#include <functional>
+
+#include "config.h"
+#include "fixed_string.h"
+#include "request_arena.h"
+#include "route_table.h"
+#include "shared_frame.h"
+#include "task_load.h"
+
+class HttpServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef const Route* (*RouteLookup)(const char* path);
+  static constexpr uint8_t kChannels = 2;   // stream channels (broadcast / beginStream)
+
+  struct Stats {
+    uint32_t accepted = 0;      // connections accepted
+    uint32_t requests = 0;      // requests dispatched
+    uint32_t notFound = 0;      // requests that fell through to onNotFound
+    uint32_t badRequests = 0;   // malformed / oversized requests
+    uint32_t preflights = 0;    // OPTIONS answered from the route table
+    uint64_t dispatchCycles = 0;// CPU cycles spent in route lookup (avg: / requests)
+    uint32_t timeouts = 0;      // connections closed for inactivity
+    uint16_t active = 0;        // connections currently open
+    uint16_t peakActive = 0;    // highest simultaneous connection count
+    uint32_t lastUs = 0;        // service time of the last request (first byte in -> last byte out)
+    uint32_t maxUs = 0;         // worst service time since boot
+    uint64_t sumUs = 0;         // for the average: sumUs / requests
+    uint32_t reused = 0;        // requests served on an already-used connection
+    uint32_t pipelined = 0;     // requests already buffered when the previous response finished
+    uint32_t kaIdleClosed = 0;  // persistent connections closed after TL_HTTP_KEEPALIVE_IDLE_MS
+    uint32_t kaMaxClosed = 0;   // persistent connections closed at TL_HTTP_KEEPALIVE_MAX_REQUESTS
+    uint16_t subscribers = 0;   // open SSE streams
+    uint32_t streamFrames = 0;  // frames written to subscribers
+    uint32_t streamSkips = 0;   // frames superseded before a slow subscriber took them
+    uint32_t keyHolds = 0;      // ... of those, non-key frames dropped to keep a queued keyframe
+    uint32_t streamStalls = 0;  // subscribers closed after TL_HTTP_STREAM_STALL_MS without write progress
+    uint32_t arenaSpills = 0;   // responses whose unsent bytes outlived the handler (moved to the heap)
+    uint32_t uploads = 0;       // ROUTE_UPLOAD bodies started
+    uint32_t uploadAborts = 0;  // ... that ended with the connection closed mid-body
+  };
+
+  struct Upload {
+    enum Status : uint8_t { START, WRITE, END, ABORTED };
+    Status status = START;
+    const uint8_t* buf = nullptr;   // WRITE: this chunk
+    size_t len = 0;
+    size_t received = 0;            // body bytes so far, this chunk included
+    size_t total = 0;               // Content-Length
+  };
+
+  explicit HttpServer(uint16_t port);
+
+  void setRoutes(RouteLookup lookup);
+  void onNotFound(THandlerFunction fn);   // unknown path or method not in the route's mask
+  bool begin();                 // binds the socket and starts the server task
+
+  // ---- Request context (valid inside a handler) ----
+  HTTPMethod method() const;   // HTTP_GET for a HEAD request
+  const char* uri() const;
+  bool hasArg(const char* name) const;
+  // Query argument, percent-decoded into the request arena and NUL-terminated
+  // (len optional); false if absent, or if the arena is full (counted there)
+  bool findArg(const char* name, const char** val, size_t* len = nullptr);
+  const char* body() const;             // request body in place (not NUL-terminated), or nullptr
+  size_t bodyLen() const;
+  bool header(const char* name, const char** val, size_t* len) const;   // request header, case-insensitive name
+  const Upload& upload() const { return _upload; }                       // inside a ROUTE_UPLOAD upload handler
+  RequestArena& arena() { return _arena; }   // handler scratch, dropped after the handler returns
+
+  void sendHeader(const char* name, const char* value, bool first = false);
+  void send(int code, const char* contentType = nullptr, const char* content = "");
+  void send(int code, const char* contentType, const char* content, size_t len);  // copied unless it is arena memory
+  void send_P(int code, const char* contentType, PGM_P content);
+  void sendFrame(int code, const char* contentType, SharedFrame* frame);  // takes the caller's reference
+  void beginStream(SharedFrame* first = nullptr, uint8_t channel = 0);      // text/event-stream subscriber
+
+  // Queue a frame for every subscriber of channel (any task). Takes the caller's reference.
+  void broadcast(SharedFrame* frame, uint8_t channel = 0);
+
+  const Stats& stats() const { return _stats; }
+  TaskLoad& load() { return _load; }
+
+private:
+  struct Conn;
+
+  static void taskEntry(void* arg);
+  void run();
+  void acceptClients();
+  void onReadable(Conn& c);
+  void onWritable(Conn& c);
+  bool parseRequest(Conn& c);
+  bool parseHead(Conn& c, char* hdrEnd, int connHdr);
+  const Route* uploadRoute(const Conn& c) const;
+  void beginUpload(Conn& c, const Route* r, size_t headLen, size_t contentLen);
+  void onUploadData(Conn& c);
+  void uploadEvent(Conn& c, Upload::Status status, const uint8_t* buf, size_t len);
+  void serve(Conn& c);
+  void dispatch(Conn& c);
+  void beginResponse(int code, const char* contentType, size_t len);
+  template <size_t N> void appendPolicyHeaders(FixedString<N>& head);
+  void setHead(Conn& c, const char* head, size_t len);
+  void detach(Conn& c);
+  void endResponse(Conn& c);
+  void closeConn(Conn& c);
+  void fanOut();
+  void startFrame(Conn& c, SharedFrame* f);
+  void wake();
+  bool rawArg(const char* name, const char** val, size_t* len) const;   // query value as sent
+
+  uint16_t _port;
+  int _listenFd = -1;
+  int _wakeFd = -1;              // loopback UDP socket: broadcast() pokes select()
+  uint16_t _wakePort = 0;
+  FrameSlot _bcast[kChannels];   // newest frame per channel waiting for fan-out
+  RouteLookup _lookup = nullptr;
+  const Route* _route = nullptr; // route of the request being answered (CORS policy)
+  THandlerFunction _notFound;
+  Conn* _conns = nullptr;
+  Conn* _cur = nullptr;          // connection whose handler is running
+  FixedString<TL_HTTP_EXTRA_HEADERS> _pendingHeaders;   // sendHeader() accumulator for the current response
+  FixedString<TL_HTTP_EXTRA_HEADERS + 384> _head;        // head under construction
+  alignas(8) uint8_t _arenaBuf[TL_HTTP_ARENA_BYTES];
+  RequestArena _arena{_arenaBuf, sizeof(_arenaBuf)};
+  Upload _upload;
+  Stats _stats;
+  TaskLoad _load;
+};
@@ -0,0 +1,83 @@
+#pragma once
+// imu_bus.h : MPU-6050/6500 devices sharing one I2C bus
+// - Up to TL_IMU_MAX devices (TL_IMU_ADDRS); a device that does not answer at
+//   begin() is skipped and its slot stays absent
+// - acquire() reads every present device back to back, one 14-byte burst each
+//   (accel, temperature, gyro), so all devices are sampled within a fraction of
+//   a millisecond on the same TL_SAMPLE_HZ tick
+// - Full-scale factors are read from the config registers at begin() and
+//   after configure(), not per sample
+// - configure() rewrites DLPF, sample rate divider and ranges between two
+//   acquisitions; a device then skips its bursts for the settle time, so no
+//   sample pairs counts from the old setup with the new scale
+// - Accel calibration terms (accel_cal.h) are folded into the scale once, so a
+//   sample costs one 3x3 multiply-add on the counts: a = G raw - o with
+//   G = M / LSB-per-g and o = M b
+// - Per-device read time, skew from the first device of the cycle and error
+//   counts are kept for /diag
+// - Not thread-safe: callers serialize access (StateLock in main.cpp)
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "accel_cal.h"
+#include "config.h"
+
+struct ImuSample {
+  float ax = 0, ay = 0, az = 0;   // g, sensor frame
+  float gx = 0, gy = 0, gz = 0;   // deg/s, sensor frame
+  int16_t raw[6] = {};            // register counts: accel xyz, gyro xyz
+  uint32_t us = 0;                // micros() at the start of the burst
+  bool ok = false;                // this cycle's burst succeeded; false: the values are an older burst's, not to be used
+};
+
+class ImuBus {
+public:
+  struct Device {
+    uint8_t addr = 0;
+    bool present = false;
+    float accLsbPerG = 16384.0f;
+    float gyroLsbPerDps = 131.0f;
+    AccelTrim trim;                                  // identity until calibrated
+    float accGain[9] = { 1 / 16384.0f, 0, 0, 0, 1 / 16384.0f, 0, 0, 0, 1 / 16384.0f };
+    float accOffset[3] = { 0, 0, 0 };                // g, trim folded into the scale
+    ImuSample sample;
+    uint32_t reads = 0;        // bursts attempted
+    uint32_t errors = 0;       // bursts that NACKed or came back short
+    uint32_t lastReadUs = 0;   // duration of the last burst
+    uint32_t maxReadUs = 0;    // worst burst since boot
+    uint32_t skewUs = 0;       // start offset from the first device of the cycle
+    uint32_t settleUntilUs = 0;
+    bool settling = false;     // bursts skipped after configure() (sample.ok false)
+  };
+
+  explicit ImuBus(TwoWire& wire) : _wire(wire) {}
+
+  uint8_t begin();                    // probes TL_IMU_ADDRS; returns devices found
+  void acquire();                     // one burst per present device, back to back
+  bool readOne(uint8_t i);            // single device, outside the acquisition cycle
+  void setAccelTrim(uint8_t i, const AccelTrim& t);   // AccelTrim{} restores the plain scale
+  // Every present device: CONFIG DLPF_CFG, SMPLRT_DIV and the gyro/accel
+  // ranges (MPU6050_light numbering); scales re-read, trim refolded. False if
+  // a device did not take it (its scale still matches its registers)
+  bool configure(uint8_t dlpf, uint8_t smplrtDiv, uint8_t gyroRange, uint8_t accRange, uint32_t settleMs);
+
+  bool present(uint8_t i) const { return i < TL_IMU_MAX && _dev[i].present; }
+  uint8_t found() const { return _found; }
+  // Out of range reads as an absent device that never sampled
+  const Device& device(uint8_t i) const { static const Device kNone; return i < TL_IMU_MAX ? _dev[i] : kNone; }
+  const ImuSample& sample(uint8_t i) const { return device(i).sample; }
+  uint32_t lastCycleUs() const { return _lastCycleUs; }
+  uint32_t maxCycleUs() const { return _maxCycleUs; }
+
+private:
+  bool burst(Device& d);
+  bool readReg(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len);
+  bool readScales(Device& d);
+  static void foldTrim(Device& d);
+
+  TwoWire& _wire;
+  Device _dev[TL_IMU_MAX];
+  uint8_t _found = 0;
+  uint32_t _lastCycleUs = 0, _maxCycleUs = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+// mcast_telemetry.h : binary telemetry by UDP multicast on the station interface
+// - One non-blocking datagram per frame to TL_MCAST_GROUP:TL_MCAST_PORT, TTL
+//   TL_MCAST_TTL; cost is the same for one listener or fifty
+// - Only sends while the station link has an address (setInterface()), so the
+//   SoftAP side never carries the traffic
+// - due() rate-gates the caller's tick; the rate changes at runtime (/station)
+// - send() is called from the sense task, setInterface() from the Wi-Fi event task
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <atomic>
+
+#include "config.h"
+#include "telemetry_packet.h"
+
+class McastTelemetry {
+public:
+  struct Stats {
+    uint32_t sent = 0;      // datagrams handed to lwIP
+    uint32_t errors = 0;    // sendto() failures (no buffer, link dropped, ...)
+    uint32_t linkUps = 0;   // station address acquired
+  };
+
+  bool begin();                        // creates the socket (once)
+  void setInterface(IPAddress ip);     // station address; 0.0.0.0 stops sending
+  void setRate(uint16_t hz);           // clamped to 1..TL_SAMPLE_HZ
+  uint16_t rate() const { return _rateHz; }
+  bool up() const { return _up.load(std::memory_order_relaxed); }
+
+  bool due(uint32_t nowMs);            // true once per 1/rate while up
+  void send(const TelemetryPacket& pkt);
+
+  const Stats& stats() const { return _stats; }
+
+private:
+  int _fd = -1;
+  uint32_t _group = 0;            // TL_MCAST_GROUP, network order
+  std::atomic<bool> _up{false};
+  volatile uint16_t _rateHz = TL_MCAST_DEFAULT_HZ;
+  uint32_t _nextMs = 0;
+  Stats _stats;
+};
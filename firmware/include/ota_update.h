@@ -0,0 +1,68 @@
+#pragma once
+// ota_update.h : streamed firmware update into the inactive OTA slot
+// - begin() opens the next OTA partition for an image of known size and MD5;
+//   write() hands every received chunk straight to Update, which erases and
+//   programs the slot one 4 KB flash sector at a time: the image is never
+//   held in RAM, one sector at most
+// - end() checks the MD5 over the written image and only then makes the new
+//   slot the boot partition; a failed or aborted upload leaves the running
+//   firmware and the boot partition as they were
+// - Rollback: the new image boots pending verification (bootloader app
+//   rollback, armed by verifyRollbackLater() in main.cpp). service() marks it
+//   valid after TL_OTA_CONFIRM_MS of healthy running; a crash or reset before
+//   that boots the previous slot again
+// - Throughput and the time spent in flash writes are kept per upload for
+//   /update and /diag
+// - begin/write/end/abort run on the HTTP task; service() runs in loop() and
+//   only acts on a finished upload
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "fixed_string.h"
+
+class OtaUpdate {
+public:
+  enum State : uint8_t { IDLE, RECEIVING, REBOOTING };
+  enum Begin : uint8_t { BEGUN, BUSY, NO_SLOT, TOO_LARGE, BAD_MD5, FLASH_ERROR };
+
+  struct Result {
+    bool ok = false;
+    uint32_t size = 0;        // Content-Length of the image
+    uint32_t bytes = 0;       // received and written
+    uint32_t ms = 0;          // begin() to end()/abort()
+    uint32_t flashMs = 0;     // inside Update (sector erase + program)
+    FixedString<47> error;    // empty when ok
+    float kibPerS() const { return ms ? (float)bytes / 1.024f / (float)ms : 0.0f; }
+  };
+
+  struct Stats {
+    uint32_t attempts = 0;    // begin() calls that opened the slot
+    uint32_t ok = 0;
+    uint32_t failed = 0;      // write/MD5 errors and aborted uploads
+  };
+
+  Begin begin(size_t size, const char* md5hex);
+  bool write(const uint8_t* buf, size_t len);
+  bool end();                              // verify, switch boot slot, schedule the reboot
+  void abort(const char* why);
+  void service(uint32_t nowMs, bool healthy);
+
+  State state() const { return _state; }
+  bool receiving() const { return _state == RECEIVING; }
+  const Result& last() const { return _last; }   // the upload in progress while receiving
+  const Stats& stats() const { return _stats; }
+  static const char* running();                  // label of the running app slot
+  static const char* imageState();               // "valid", "pending_verify", ... of the running slot
+  static const char* rolledBackFrom();           // slot the bootloader rejected, or nullptr
+  static size_t slotSize();                      // capacity of the slot the next image goes to
+
+private:
+  void fail(const char* why);
+
+  volatile State _state = IDLE;
+  bool _confirmed = false;
+  uint32_t _startMs = 0, _flashUs = 0, _rebootAtMs = 0;
+  Result _last;
+  Stats _stats;
+};
@@ -0,0 +1,77 @@
+#pragma once
+// power_policy.h : presence-driven CPU clock and work policy
+// - ACTIVE while anyone could be looking: an AP client, an SSE subscriber, a
+//   station link (multicast listeners) or an HTTP request within the last
+//   idleAfterMs; IDLE after idleAfterMs without any of them
+// - IDLE drops the CPU to idleMhz, publishes frames at idlePublishHz and lets
+//   loop() sleep longer; sampling itself never slows down
+// - IDLE is refused while the sense task's load, scaled to the idle clock,
+//   would exceed senseMaxPct of its core, so the sample rate is never at risk
+// - Any presence returns to ACTIVE on the same update (no hold-off)
+// - Plain C++: main.cpp gathers the inputs and applies the decision, so the
+//   policy runs unchanged on the host
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+class PowerPolicy {
+public:
+  enum Mode : uint8_t { ACTIVE, IDLE };
+
+  struct Config {
+    uint16_t activeMhz = TL_PWR_ACTIVE_MHZ;
+    uint16_t idleMhz = TL_PWR_IDLE_MHZ;
+    uint32_t idleAfterMs = TL_PWR_IDLE_AFTER_MS;
+    uint8_t activePublishHz = TL_PUBLISH_HZ;
+    uint8_t idlePublishHz = TL_PWR_IDLE_PUBLISH_HZ;
+    uint16_t activeLoopMs = TL_PWR_ACTIVE_LOOP_MS;
+    uint16_t idleLoopMs = TL_PWR_IDLE_LOOP_MS;
+    float senseMaxPct = TL_PWR_SENSE_MAX_PCT;
+  };
+
+  struct Inputs {
+    uint8_t apClients = 0;       // stations associated with the SoftAP
+    uint16_t subscribers = 0;    // open /stream connections
+    bool stationLinked = false;  // on the vehicle network (multicast going out)
+    uint32_t requests = 0;       // HTTP requests served since boot (any change = activity)
+    float sensePct = 0;          // sense task load at cpuMhz, % of its core
+    uint16_t cpuMhz = 0;         // clock the load was measured at
+  };
+
+  struct Decision {
+    Mode mode = ACTIVE;
+    uint16_t cpuMhz = TL_PWR_ACTIVE_MHZ;
+    uint8_t publishHz = TL_PUBLISH_HZ;
+    uint16_t loopMs = TL_PWR_ACTIVE_LOOP_MS;
+  };
+
+  struct Stats {
+    uint32_t toIdle = 0, toActive = 0;   // transitions
+    uint32_t refused = 0;                // IDLE denied by sense load
+    uint64_t idleMs = 0, activeMs = 0;   // time per mode (as of the last update)
+  };
+
+  PowerPolicy() = default;
+  explicit PowerPolicy(const Config& c) : _cfg(c) {}
+
+  const Decision& update(const Inputs& in, uint32_t nowMs);
+  void setActivePublishHz(uint8_t hz);   // acquisition profile; applies at once while ACTIVE
+
+  const Decision& decision() const { return _dec; }
+  uint32_t sinceMs() const { return _sinceMs; }      // uptime of the last mode change
+  uint32_t lastSeenMs() const { return _seenMs; }    // last time presence was observed
+  const Config& config() const { return _cfg; }
+  const Stats& stats() const { return _stats; }
+
+private:
+  void enter(Mode m, uint32_t nowMs);
+
+  Config _cfg;
+  Decision _dec;
+  Stats _stats;
+  bool _started = false;
+  uint32_t _requests = 0;
+  uint32_t _seenMs = 0, _sinceMs = 0, _lastMs = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+// request_arena.h : bump allocator for one HTTP request's scratch memory
+// - Handlers run one at a time on the server task; everything a handler
+//   builds (JSON documents, the serialized body, the response head) comes from
+//   here and the whole arena is dropped with one reset() before the next
+//   request, so the request path makes no heap calls and leaves no holes
+// - alloc() returns nullptr when full; callers fall back to the heap and the
+//   miss is counted (size TL_HTTP_ARENA_BYTES from /diag peak and overflows)
+// - Blocks carry their size so the newest one can grow in place (ArduinoJson
+//   string and pool growth) and older ones can be copied
+// - Plain C++ (no Arduino headers)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class RequestArena {
+public:
+  struct Stats {
+    uint32_t resets = 0;     // requests served from the arena
+    uint32_t overflows = 0;  // allocations that did not fit (served from the heap)
+    size_t peak = 0;         // most bytes used by one request
+  };
+
+  RequestArena(void* buf, size_t cap) : _buf((uint8_t*)buf), _cap(cap) {}
+
+  void* alloc(size_t n) {
+    const size_t at = _used + kHdr;
+    const size_t end = at + align(n);
+    if (end > _cap) { _stats.overflows++; return nullptr; }
+    setSize(at, n);
+    _last = at; _used = end;
+    return _buf + at;
+  }
+
+  // Resize a block from alloc(); nullptr (block untouched) if it cannot fit
+  void* realloc(void* p, size_t n) {
+    if (!p) return alloc(n);
+    const size_t at = (uint8_t*)p - _buf;
+    if (at == _last) {
+      if (at + align(n) > _cap) { _stats.overflows++; return nullptr; }
+      setSize(at, n); _used = at + align(n);
+      return p;
+    }
+    void* q = alloc(n);
+    if (q) memcpy(q, p, size(p) < n ? size(p) : n);
+    return q;
+  }
+
+  void* copy(const void* src, size_t n) {
+    void* p = alloc(n);
+    if (p) memcpy(p, src, n);
+    return p;
+  }
+
+  bool owns(const void* p) const { return p >= _buf && p < _buf + _cap; }
+  size_t size(const void* p) const { size_t n; memcpy(&n, (const uint8_t*)p - kHdr, sizeof(n)); return n; }
+  size_t used() const { return _used; }
+  size_t capacity() const { return _cap; }
+
+  void reset() {
+    if (_used > _stats.peak) _stats.peak = _used;
+    _used = 0; _last = SIZE_MAX;
+    _stats.resets++;
+  }
+
+  const Stats& stats() const { return _stats; }
+
+private:
+  static constexpr size_t kAlign = 8;
+  static constexpr size_t kHdr = kAlign;   // block size, keeps payloads aligned
+  static size_t align(size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+  void setSize(size_t at, size_t n) { memcpy(_buf + at - kHdr, &n, sizeof(n)); }
+
+  uint8_t* _buf;
+  size_t _cap;
+  size_t _used = 0;
+  size_t _last = SIZE_MAX;   // offset of the newest block
+  Stats _stats;
+};
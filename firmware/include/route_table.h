@@ -0,0 +1,84 @@
+#pragma once
+// route_table.h : compile-time perfect-hash route dispatch
+// - Routes are declared once as a constexpr table: path, allowed methods,
+//   handler, policy flags (CORS, keep-alive, streamed upload) and, for upload
+//   routes, the body handler; one entry per path
+// - makeDispatcher() searches, at compile time, for a hash seed that puts every
+//   path in its own slot; a lookup is then one hash of the request path, one
+//   slot read and one strcmp, whatever the table size
+// - A duplicate path makes the search fail, which the static_assert next to
+//   the table reports at build time
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <HTTP_Method.h>
+
+enum RouteFlags : uint8_t {
+  ROUTE_CORS      = 1 << 0,   // add CORS headers; OPTIONS preflight answered generically
+  ROUTE_KEEPALIVE = 1 << 1,   // allow persistent connections
+  ROUTE_UPLOAD    = 1 << 2,   // body streamed to Route::upload in chunks, never buffered whole
+};
+
+constexpr uint32_t methodBit(HTTPMethod m) { return 1u << ((uint32_t)m & 31u); }
+constexpr uint32_t METHODS_ANY = 0xFFFFFFFFu;
+
+struct Route {
+  const char* path;
+  uint32_t methods;     // methodBit() mask
+  void (*handler)();
+  uint8_t flags;        // RouteFlags
+  void (*upload)() = nullptr;   // ROUTE_UPLOAD: called per body chunk (HttpServer::upload())
+};
+
+// FNV-1a with a seed folded into the basis, plus a final mix for the low bits
+constexpr uint32_t routeHash(const char* s, uint32_t seed) {
+  uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+  while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h ^ (h >> 15);
+}
+
+constexpr size_t routeSlotsFor(size_t n) {
+  size_t s = 1;
+  while (s < n * 4) s <<= 1;   // load factor <= 1/4: a seed turns up within a few dozen tries
+  return s;
+}
+
+template <size_t N>
+struct RouteDispatcher {
+  static_assert(N > 0 && N < 127, "route table size must fit int8_t slots");
+  static constexpr size_t kSlots = routeSlotsFor(N);
+
+  const Route* routes = nullptr;
+  bool ok = false;                 // false: no perfect hash (duplicate path)
+  uint32_t seed = 0;
+  int8_t slot[kSlots] = {};
+
+  const Route* find(const char* path) const {
+    const int8_t i = slot[routeHash(path, seed) & (kSlots - 1)];
+    return (i >= 0 && !strcmp(routes[i].path, path)) ? &routes[i] : nullptr;
+  }
+};
+
+template <size_t N>
+constexpr RouteDispatcher<N> makeDispatcher(const Route (&routes)[N]) {
+  constexpr size_t S = RouteDispatcher<N>::kSlots;
+  RouteDispatcher<N> d{};
+  for (uint32_t seed = 0; seed < 4096; ++seed) {
+    bool used[S] = {};
+    bool ok = true;
+    for (size_t i = 0; i < N && ok; ++i) {
+      const size_t h = routeHash(routes[i].path, seed) & (S - 1);
+      ok = !used[h];
+      used[h] = true;
+    }
+    if (!ok) continue;
+    for (size_t k = 0; k < S; ++k) d.slot[k] = -1;
+    for (size_t i = 0; i < N; ++i) d.slot[routeHash(routes[i].path, seed) & (S - 1)] = (int8_t)i;
+    d.routes = routes;
+    d.ok = true;
+    d.seed = seed;
+    return d;
+  }
+  return d;
+}
@@ -0,0 +1,86 @@
+#pragma once
+// seqlock.h : single-writer snapshot published through a sequence lock
+// - write() copies a whole T into the slot readers are not directed to, then
+//   publishes it; the writer never waits for a reader
+// - read() copies the published slot and checks that slot's sequence count
+//   before and after: odd or changed means the writer came back round to it
+//   mid-copy and the copy is taken again. With two slots that needs two
+//   publishes within one copy, so at the sense rate a reader practically
+//   never retries
+// - The copy goes word by word through relaxed atomics between the fences,
+//   the data-race-free form of a seqlock (a plain memcpy racing the writer is
+//   undefined); T must be trivially copyable
+// - One writer task, any number of readers on either core
+// - Plain C++ (no Arduino headers): exercised with threads on the host
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <class T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock snapshots must be trivially copyable");
+
+public:
+  struct Stats {
+    uint32_t writes = 0;    // publishes since boot
+    uint32_t retries = 0;   // reader copies taken again (any reader)
+  };
+
+  // Writer only
+  void write(const T& v) {
+    uint32_t w[kWords];
+    w[kWords - 1] = 0;
+    memcpy(w, &v, sizeof(T));
+    const uint32_t n = _pub.load(std::memory_order_relaxed) + 1;
+    Slot& s = _slot[n & 1];
+    const uint32_t q = s.seq.load(std::memory_order_relaxed);
+    s.seq.store(q + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) s.data[i].store(w[i], std::memory_order_relaxed);
+    s.seq.store(q + 2, std::memory_order_release);
+    _pub.store(n, std::memory_order_release);
+  }
+
+  // Consistent copy of the latest publish; returns its number (0: nothing yet,
+  // out is then all zero bytes)
+  uint32_t read(T& out) const {
+    uint32_t w[kWords], n;
+    for (;;) {
+      n = _pub.load(std::memory_order_acquire);
+      const Slot& s = _slot[n & 1];
+      const uint32_t q = s.seq.load(std::memory_order_acquire);
+      if (!(q & 1)) {
+        for (size_t i = 0; i < kWords; i++) w[i] = s.data[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) == q) break;
+      }
+      _retries.fetch_add(1, std::memory_order_relaxed);
+    }
+    memcpy(&out, w, sizeof(T));
+    return n;
+  }
+
+  T read() const { T v; read(v); return v; }
+  uint32_t version() const { return _pub.load(std::memory_order_acquire); }
+
+  Stats stats() const {
+    Stats st;
+    st.writes = _pub.load(std::memory_order_relaxed);
+    st.retries = _retries.load(std::memory_order_relaxed);
+    return st;
+  }
+
+private:
+  static constexpr size_t kWords = (sizeof(T) + 3) / 4;
+  struct Slot {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> data[kWords] = {};
+  };
+
+  Slot _slot[2];
+  std::atomic<uint32_t> _pub{0};
+  mutable std::atomic<uint32_t> _retries{0};
+};
@@ -0,0 +1,81 @@
+#pragma once
+// shared_frame.h : reference-counted, serialize-once telemetry frame
+// - The sampler serializes each published frame exactly once into a SharedFrame
+// - Polling responses and every streaming subscriber send the same bytes; the
+//   buffer is freed when the last connection finishes writing it
+// - Layout is "data: <json>\n\n" so the SSE framing costs nothing extra;
+//   json()/jsonLen() give the bare document for plain GET responses
+// - The same refcounting serves binary downloads: json() is then just the
+//   payload and sse() is unused
+
+#include <Arduino.h>
+#include <atomic>
+#include <new>
+#include <freertos/FreeRTOS.h>
+
+struct SharedFrame {
+  uint32_t seq = 0;
+  size_t jsonLen = 0;
+  bool keyframe = false;   // later frames are relative to this one (frame_delta.h)
+
+  // Room for jsonCap bytes of JSON plus framing; starts with one reference.
+  // psram: large payloads (flight-recorder captures, any bytes) go to PSRAM.
+  static SharedFrame* create(size_t jsonCap, bool psram = false) {
+    const size_t bytes = sizeof(SharedFrame) + kPrefixLen + jsonCap + kSuffixLen + 1;
+    void* mem = psram ? ps_malloc(bytes) : malloc(bytes);
+    if (!mem) return nullptr;
+    SharedFrame* f = new (mem) SharedFrame();
+    memcpy(f->_buf, "data: ", kPrefixLen);
+    return f;
+  }
+
+  char* json() { return _buf + kPrefixLen; }
+  const char* json() const { return _buf + kPrefixLen; }
+  // Call once json() holds jsonLen bytes: appends the SSE terminator
+  void seal() { memcpy(_buf + kPrefixLen + jsonLen, "\n\n", kSuffixLen + 1); }
+  const char* sse() const { return _buf; }
+  size_t sseLen() const { return kPrefixLen + jsonLen + kSuffixLen; }
+
+  void ref() { _refs.fetch_add(1, std::memory_order_relaxed); }
+  void unref() {
+    if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) { this->~SharedFrame(); free(this); }
+  }
+
+private:
+  static constexpr size_t kPrefixLen = 6;   // "data: "
+  static constexpr size_t kSuffixLen = 2;   // "\n\n"
+  SharedFrame() : _refs(1) {}
+  ~SharedFrame() {}
+  std::atomic<int> _refs;
+  char _buf[1];
+};
+
+// Single-slot "latest frame" holder shared between the sampler and readers.
+class FrameSlot {
+public:
+  // Takes over the caller's reference; drops the one on the previous frame.
+  void publish(SharedFrame* f) {
+    portENTER_CRITICAL(&_mux);
+    SharedFrame* old = _cur; _cur = f;
+    portEXIT_CRITICAL(&_mux);
+    if (old) old->unref();
+  }
+  // Returns the latest frame with a reference the caller must unref(), or nullptr.
+  SharedFrame* acquire() {
+    portENTER_CRITICAL(&_mux);
+    SharedFrame* f = _cur; if (f) f->ref();
+    portEXIT_CRITICAL(&_mux);
+    return f;
+  }
+  // Hands the held frame (and its reference) to the caller, leaving the slot empty.
+  SharedFrame* take() {
+    portENTER_CRITICAL(&_mux);
+    SharedFrame* f = _cur; _cur = nullptr;
+    portEXIT_CRITICAL(&_mux);
+    return f;
+  }
+
+private:
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  SharedFrame* _cur = nullptr;
+};
@@ -0,0 +1,73 @@
+#pragma once
+// spectrum.h : windowed FFT of lateral accel, roll rate and yaw rate
+// - push() buffers one sample per channel every tick; every
+//   TL_SAMPLE_HZ / TL_SPECTRUM_HZ samples compute() transforms the last
+//   TL_FFT_N samples (mean removed, Hann window)
+// - Lateral accel and roll rate share one complex FFT (real-pair trick), yaw
+//   rate takes a second; esp-dsp does the transform on target, fft_kernel.h
+//   elsewhere
+// - Output: single-sided amplitude per bin (g or deg/s) and the dominant peak
+//   per channel; sway() is the lateral peak in TL_SWAY_MIN_HZ..TL_SWAY_MAX_HZ.
+//   Peaks are interpolated between bins and corrected for window scalloping
+// - push/compute/sway run on the sense task. Other tasks read the result
+//   between lockResult()/unlockResult(); compute() never waits for a reader,
+//   it retries on the next tick
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "config.h"
+
+class SpectrumAnalyzer {
+public:
+  enum Channel { LATERAL, ROLL_RATE, YAW_RATE, CHANNELS };
+  static constexpr size_t kBins = TL_FFT_N / 2 + 1;
+
+  struct Peak { float hz = 0, amp = 0; };
+  struct Stats {
+    uint32_t runs = 0;      // spectra computed
+    uint32_t lastUs = 0;    // cost of the last compute()
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;     // average: sumUs / runs
+    uint32_t deferred = 0;  // runs pushed to the next tick because a reader held the result
+  };
+
+  bool begin();
+  void push(float lateral, float rollRate, float yawRate);
+  bool due() const { return _filled >= TL_FFT_N && _sinceRun >= kHop; }
+  void compute();
+  Peak sway() const { return _sway; }
+
+  bool lockResult(uint32_t waitMs);
+  void unlockResult();
+  const float* bins(Channel c) const { return _amp[c]; }
+  Peak dominant(Channel c) const { return _dom[c]; }
+  uint32_t resultMs() const { return _resultMs; }   // 0 until the first spectrum
+
+  static float binHz() { return (float)TL_SAMPLE_HZ / (float)TL_FFT_N; }
+  static const char* kernel();
+  const Stats& stats() const { return _stats; }
+
+private:
+  static_assert((TL_FFT_N & (TL_FFT_N - 1)) == 0, "TL_FFT_N must be a power of two");
+  static constexpr uint32_t kHop = TL_SAMPLE_HZ / TL_SPECTRUM_HZ;
+
+  void loadPair(Channel re, Channel im);
+  void transform();
+  Peak findPeak(const float* amp, float minHz, float maxHz) const;
+
+  float _ring[CHANNELS][TL_FFT_N] = {};
+  size_t _head = 0, _filled = 0;
+  uint32_t _sinceRun = 0;
+
+  float _window[TL_FFT_N];
+  alignas(16) float _buf[2 * TL_FFT_N];   // interleaved complex work buffer
+  float _amp[CHANNELS][kBins] = {};
+  Peak _dom[CHANNELS];
+  Peak _sway;
+  uint32_t _resultMs = 0;
+
+  SemaphoreHandle_t _resultMutex = nullptr;
+  Stats _stats;
+};
@@ -0,0 +1,52 @@
+#pragma once
+// stream_fields.h : the fields of the delta stream (/stream?enc=delta)
+// - Each is one of the frame's numbers under its /sensor name, quantized to
+//   what the UI shows; main.cpp's streamValues() fills them in this order
+// - Deadbands sit above what a parked device reads as noise in the noisiest
+//   profile ("general", DLPF off, per frame: ~8 mg, 0.1 deg/s, 0.46 deg on
+//   the instantaneous angles, 0.04 deg on the averages; a delta compares two
+//   such samples) except on the averages, kept at 0.1 deg for leveling, which
+//   still cross it now and then. The other profiles filter harder and mostly
+//   send empty deltas
+// - The accel_backward/left/down mirrors are left out; the second-IMU fields
+//   come last and drop off the end without it
+// - Shared with the host test, which measures the encoding on this table
+
+#include <stdint.h>
+
+#include "config.h"
+#include "frame_delta.h"
+
+inline constexpr StreamField kStreamFields[] = {
+  { "pos_pitch_raw",        0.01f,  1.5f  }, { "pos_roll_raw",        0.01f, 1.5f  },
+  { "pos_pitch_calibrated", 0.01f,  1.5f  }, { "pos_roll_calibrated", 0.01f, 1.5f  },
+  { "pos_pitch_avg",        0.01f,  0.1f  }, { "pos_roll_avg",        0.01f, 0.1f  },
+  { "pitch_rate",           0.01f,  0.5f  }, { "roll_rate",           0.01f, 0.5f  },
+  { "avg_tau_ms",           1.0f,   1.0f  },
+  { "accel_x_raw",          0.001f, 0.05f }, { "accel_y_raw",         0.001f, 0.05f }, { "accel_z_raw", 0.001f, 0.05f },
+  { "gyro_x_raw",           0.01f,  0.5f  }, { "gyro_y_raw",          0.01f, 0.5f  }, { "gyro_z_raw",  0.01f,  0.5f  },
+  { "accel_forward",        0.001f, 0.05f }, { "accel_right",         0.001f, 0.05f }, { "accel_up",    0.001f, 0.05f },
+  { "accel_peak.up",        0.001f, 0.05f }, { "accel_peak.down",     0.001f, 0.05f },
+  { "accel_peak.left",      0.001f, 0.05f }, { "accel_peak.right",    0.001f, 0.05f },
+  { "gravity_forward",      0.001f, 0.05f }, { "gravity_right",       0.001f, 0.05f }, { "gravity_up",  0.001f, 0.05f },
+  { "gyro_pitchup",         0.01f,  0.5f  }, { "gyro_pitchdown",      0.01f, 0.5f  },
+  { "gyro_rollright",       0.01f,  0.5f  }, { "gyro_rollleft",       0.01f, 0.5f  },
+  { "gyro_turnright",       0.01f,  0.5f  }, { "gyro_turnleft",       0.01f, 0.5f  },
+  { "roll_peak.up",         0.01f,  0.5f  }, { "roll_peak.down",      0.01f, 0.5f  },
+  { "roll_peak.left",       0.01f,  0.5f  }, { "roll_peak.right",     0.01f, 0.5f  },
+  { "sway_hz",              0.01f,  0.05f }, { "sway_amp",            0.001f, 0.005f },
+  { "sway_alert.active",    1.0f,   1.0f  }, { "sway_alert.count",    1.0f,  1.0f  },
+  { "sway_alert.hz",        0.01f,  0.05f }, { "sway_alert.yaw_dps",  0.01f, 0.5f  },
+  { "sway_alert.lat_g",     0.001f, 0.005f },
+  { "imu_ok",               1.0f,   1.0f  },
+  // Second IMU
+  { "axles.0.pitch",        0.01f,  1.5f  }, { "axles.0.roll",        0.01f, 1.5f  },
+  { "axles.0.pitch_avg",    0.01f,  0.1f  }, { "axles.0.roll_avg",    0.01f, 0.1f  }, { "axles.0.ok", 1.0f, 1.0f },
+  { "axles.1.pitch",        0.01f,  1.5f  }, { "axles.1.roll",        0.01f, 1.5f  },
+  { "axles.1.pitch_avg",    0.01f,  0.1f  }, { "axles.1.roll_avg",    0.01f, 0.1f  }, { "axles.1.ok", 1.0f, 1.0f },
+  { "frame_twist",          0.01f,  1.5f  }, { "frame_twist_avg",     0.01f, 0.1f  },
+};
+inline constexpr uint8_t kStreamFieldCount = sizeof(kStreamFields) / sizeof(kStreamFields[0]);
+inline constexpr uint8_t kStreamRearFields = 12;   // the second-IMU block at the end
+static_assert(kStreamFieldCount <= TL_STREAM_MAX_FIELDS, "raise TL_STREAM_MAX_FIELDS");
+static_assert(TL_IMU_MAX == 2, "kStreamFields lists two axles");
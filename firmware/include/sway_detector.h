@@ -0,0 +1,71 @@
+#pragma once
+// sway_detector.h : always-on trailer sway detection with a streaming Goertzel bank
+// - TL_SWAY_ALERT_BINS leaky Goertzel resonators per channel spread over
+//   TL_SWAY_ALERT_MIN_HZ..TL_SWAY_ALERT_MAX_HZ, on yaw rate and lateral accel;
+//   every sample costs O(bins), no block buffering
+// - Each resonator is an exponentially windowed DFT bin (time constant
+//   TL_SWAY_ALERT_TAU_S); amplitude = 2 (1 - r) |z|, so a steady sinusoid reads
+//   its own amplitude. Inputs pass a slow DC blocker first (gyro bias, tilt)
+// - Alert when either channel's strongest bin stays at or above its threshold
+//   for holdMs; clears when both stay below 70 % of threshold for holdMs
+// - Raised/cleared alerts go to a small timestamped log (uptime ms)
+// - Not thread-safe: callers serialize access (StateLock in main.cpp)
+
+#include <Arduino.h>
+
+#include "config.h"
+
+class SwayDetector {
+public:
+  static constexpr int kBins = TL_SWAY_ALERT_BINS;
+  enum Channel { YAW, LATERAL, CHANNELS };
+
+  struct Config {
+    float yawDps = TL_SWAY_ALERT_YAW_DPS;   // yaw-rate amplitude threshold
+    float latG = TL_SWAY_ALERT_LAT_G;       // lateral-accel amplitude threshold
+    uint32_t holdMs = TL_SWAY_ALERT_HOLD_MS;
+  };
+  struct State {
+    bool active = false;
+    uint32_t sinceMs = 0;    // onset of the current alert
+    uint32_t alerts = 0;     // alerts raised since boot
+    float hz = 0;            // strongest yaw bin (lateral if yaw is quiet)
+    float yawDps = 0, latG = 0;
+  };
+  struct Event { uint32_t startMs = 0, endMs = 0; float hz = 0, yawDps = 0, latG = 0; };   // endMs 0: ongoing
+  struct Stats { uint32_t samples = 0; uint64_t cycles = 0; uint32_t maxCycles = 0; };
+
+  void begin(float sampleHz);
+  void push(float yawRate, float lateral, uint32_t nowMs);
+
+  void setConfig(const Config& c) { _cfg = c; }
+  const Config& config() const { return _cfg; }
+  const State& state() const { return _state; }
+  float binHz(int i) const { return _hz[i]; }
+  float amplitude(Channel c, int i) const;
+
+  size_t logCount() const { return _logLen; }
+  const Event& logAt(size_t i) const;      // 0 = oldest
+  const Stats& stats() const { return _stats; }
+
+private:
+  struct Resonator { float c = 0, r2 = 0; float y1 = 0, y2 = 0; };   // c = 2 r cos(w)
+
+  void detect(uint32_t nowMs);
+
+  Resonator _res[CHANNELS][kBins];
+  float _hz[kBins] = {};
+  float _r = 0, _ampScale = 0;
+  float _dc[CHANNELS] = {}, _dcAlpha = 0;
+  float _peak2[CHANNELS] = {};
+  int _peakBin[CHANNELS] = {};
+
+  Config _cfg;
+  State _state;
+  uint32_t _overSinceMs = 0, _underSinceMs = 0;
+  bool _over = false, _under = false;
+
+  Event _log[TL_SWAY_ALERT_LOG_LEN];
+  size_t _logHead = 0, _logLen = 0;
+  Stats _stats;
+};
@@ -0,0 +1,33 @@
+#pragma once
+// task_load.h : per-task CPU accounting without FreeRTOS run-time stats
+// - Each task brackets its work with micros() and calls add(); blocking time
+//   (select, vTaskDelayUntil, ...) is not counted
+// - windowPct() is called from /diag and reports busy time over the interval
+//   since its previous call; counters wrap every ~71 min, deltas stay correct
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct TaskLoad {
+  const char* name = "";
+  TaskHandle_t handle = nullptr;
+  int core = -1;
+  volatile uint32_t busyUs = 0;   // cumulative work time
+  volatile uint32_t maxUs = 0;    // longest single work slice
+
+  void add(uint32_t us) { busyUs += us; if (us > maxUs) maxUs = us; }
+
+  float windowPct() {
+    const uint32_t now = micros(), busy = busyUs;
+    const uint32_t wall = now - _lastWallUs, used = busy - _lastBusyUs;
+    _lastWallUs = now; _lastBusyUs = busy;
+    return wall ? 100.0f * (float)used / (float)wall : 0.0f;
+  }
+
+  // Bytes of stack never touched so far (ESP-IDF reports the high-water mark in bytes)
+  uint32_t stackFree() const { return handle ? (uint32_t)uxTaskGetStackHighWaterMark(handle) : 0; }
+
+private:
+  uint32_t _lastWallUs = 0, _lastBusyUs = 0;
+};
@@ -0,0 +1,70 @@
+#pragma once
+// telemetry_packet.h : compact binary telemetry frame (UDP multicast)
+// - Fixed 40-byte little-endian layout, independent of compiler packing;
+//   angles in 0.01 deg, accel in mg, rates in 0.01 deg/s, saturated to int16
+// - Plain C++ (no Arduino headers): shared by the firmware and tools/udp_rx
+//
+//  off  type  field
+//    0  u16   magic 'T','L'
+//    2  u8    version (kVersion)
+//    3  u8    flags (FLAG_*)
+//    4  u32   seq (gaps = loss)
+//    8  u32   device uptime, ms
+//   12  i16   pitch, roll, pitch_avg, roll_avg          (primary IMU)
+//   20  i16   accel forward, right, up                  (gravity removed)
+//   26  i16   rate pitch-up, roll-right, turn-right
+//   32  i16   rear pitch, rear roll, frame twist        (FLAG_REAR)
+//   38  u16   reserved (0)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+struct TelemetryPacket {
+  static constexpr size_t kLen = 40;
+  static constexpr uint8_t kMagic0 = 'T', kMagic1 = 'L';
+  static constexpr uint8_t kVersion = 1;
+  enum : uint8_t { FLAG_REAR = 1 << 0, FLAG_PRIMARY_OK = 1 << 1, FLAG_SWAY = 1 << 2 };
+
+  uint8_t flags = 0;
+  uint32_t seq = 0;
+  uint32_t ms = 0;
+  float pitch = 0, roll = 0, pitchAvg = 0, rollAvg = 0;   // deg
+  float accFwd = 0, accRight = 0, accUp = 0;              // g
+  float ratePitch = 0, rateRoll = 0, rateTurn = 0;        // deg/s
+  float rearPitch = 0, rearRoll = 0, twist = 0;           // deg
+
+  void encode(uint8_t* out) const {
+    out[0] = kMagic0; out[1] = kMagic1; out[2] = kVersion; out[3] = flags;
+    put32(out + 4, seq); put32(out + 8, ms);
+    const float v[13] = { pitch * 100, roll * 100, pitchAvg * 100, rollAvg * 100,
+                          accFwd * 1000, accRight * 1000, accUp * 1000,
+                          ratePitch * 100, rateRoll * 100, rateTurn * 100,
+                          rearPitch * 100, rearRoll * 100, twist * 100 };
+    for (int i = 0; i < 13; ++i) put16(out + 12 + 2 * i, (uint16_t)sat16(v[i]));
+    put16(out + 38, 0);
+  }
+
+  bool decode(const uint8_t* in, size_t len) {
+    if (len < kLen || in[0] != kMagic0 || in[1] != kMagic1 || in[2] != kVersion) return false;
+    flags = in[3]; seq = get32(in + 4); ms = get32(in + 8);
+    float* const dst[13] = { &pitch, &roll, &pitchAvg, &rollAvg, &accFwd, &accRight, &accUp,
+                             &ratePitch, &rateRoll, &rateTurn, &rearPitch, &rearRoll, &twist };
+    for (int i = 0; i < 13; ++i) {
+      const float scale = (i >= 4 && i <= 6) ? 1000.0f : 100.0f;
+      *dst[i] = (float)(int16_t)get16(in + 12 + 2 * i) / scale;
+    }
+    return true;
+  }
+
+private:
+  static int16_t sat16(float v) {
+    if (!isfinite(v)) return 0;
+    v = roundf(v);
+    return v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : (int16_t)v;
+  }
+  static void put16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+  static void put32(uint8_t* p, uint32_t v) { put16(p, v & 0xFFFF); put16(p + 2, v >> 16); }
+  static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+  static uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+};
@@ -29,6 +29,10 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
   button:hover { filter:brightness(1.2); }
   .btn-quiet { background:#0b0b0b; border-color:#2a2a2a; }
   canvas { width:100%; height:auto; display:block; background:#000; border-radius:10px; }
+  .dial { position:relative; background:#000; border-radius:10px; }
+  .dial canvas { position:relative; z-index:1; background:transparent; }
+  .dial canvas.layer { position:absolute; inset:0; width:100%; height:100%; z-index:0; pointer-events:none; }
+  .dial canvas.layer.over { z-index:2; }
   #status { font-size:12px; color:var(--muted); padding:4px 8px; border:1px solid #1a1a1a; border-radius:999px; }
   .modal-backdrop { position:fixed; inset:0; background:rgba(0,0,0,.6); display:none; align-items:center; justify-content:center; z-index:10; }
   .modal { width:min(92vw,480px); background:var(--card); border:1px solid var(--line); border-radius:12px; padding:14px; }
@@ -38,6 +42,10 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
   label { font-size:13px; color:var(--muted); }
   input,select { width:100%; padding:10px; border-radius:8px; border:1px solid #2a2a2a; background:#0b0b0b; color:var(--fg); font-size:14px; }
   .modal .actions { display:flex; justify-content:flex-end; gap:8px; margin-top:10px; }
+  #sway-alert { display:none; background:var(--red); color:var(--white); font-weight:600; border-radius:10px; padding:10px 12px; margin-bottom:12px; }
+  #lat-overlay { display:none; position:fixed; left:8px; bottom:calc(8px + env(safe-area-inset-bottom)); z-index:5; pointer-events:none;
+    font:11px/1.4 ui-monospace,Menlo,Consolas,monospace; color:var(--muted); white-space:pre;
+    background:rgba(0,0,0,.8); border:1px solid var(--line); border-radius:8px; padding:6px 8px; }
 </style>
 </head>
 <body>
@@ -45,11 +53,15 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
     <header>
       <h1>Trailer Level Dashboard</h1>
       <div class="header-actions">
+        <button id="btn-profile" class="btn-quiet">Profile: …</button>
         <button id="btn-wifi" class="btn-quiet">Wi-Fi</button>
+        <button id="btn-lat" class="btn-quiet">Stats</button>
         <span id="status">connecting...</span>
       </div>
     </header>
 
+    <div id="sway-alert">SWAY</div>
+    <div id="lat-overlay"></div>
     <div class="grid">
       <div id="card-level" class="card">
         <div class="row">
@@ -59,7 +71,7 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
             <button id="btn-lev-prec" class="btn-quiet">Precision: …</button>
           </div>
         </div>
-        <canvas id="cv-level" width="800" height="600"></canvas>
+        <div class="dial"><canvas id="cv-level" width="800" height="600"></canvas></div>
         <div class="sub" id="txt-level">pitch 0°, roll 0°</div>
       </div>
 
@@ -71,7 +83,7 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
             <button id="btn-mot-prec" class="btn-quiet">Accel: …</button>
           </div>
         </div>
-        <canvas id="cv-motion" width="800" height="600"></canvas>
+        <div class="dial"><canvas id="cv-motion" width="800" height="600"></canvas></div>
         <div class="sub" id="txt-motion">accel f/r/u: 0, 0, 0</div>
       </div>
 
@@ -82,7 +94,7 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
             <button id="btn-roll-prec" class="btn-quiet">Roll: …</button>
           </div>
         </div>
-        <canvas id="cv-roll" width="800" height="600"></canvas>
+        <div class="dial"><canvas id="cv-roll" width="800" height="600"></canvas></div>
         <div class="sub" id="txt-roll">gyro pitch/roll/turn: 0, 0, 0</div>
       </div>
     </div>
@@ -175,9 +187,25 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
     btnRol.textContent = `Roll: ±${ROLL_STEPS[rolIdx]}°/s`;
   }
   refreshPrecButtons();
-  btnLev.addEventListener("click", ()=>{ levIdx=(levIdx+1)%LEVEL_STEPS.length; localStorage.setItem('levIdx',levIdx); refreshPrecButtons(); });
-  btnMot.addEventListener("click", ()=>{ motIdx=(motIdx+1)%MOTION_STEPS.length; localStorage.setItem('motIdx',motIdx); refreshPrecButtons(); });
-  btnRol.addEventListener("click", ()=>{ rolIdx=(rolIdx+1)%ROLL_STEPS.length; localStorage.setItem('rolIdx',rolIdx); refreshPrecButtons(); });
+  btnLev.addEventListener("click", ()=>{ levIdx=(levIdx+1)%LEVEL_STEPS.length; localStorage.setItem('levIdx',levIdx); refreshPrecButtons(); schedule(); });
+  btnMot.addEventListener("click", ()=>{ motIdx=(motIdx+1)%MOTION_STEPS.length; localStorage.setItem('motIdx',motIdx); refreshPrecButtons(); schedule(); });
+  btnRol.addEventListener("click", ()=>{ rolIdx=(rolIdx+1)%ROLL_STEPS.length; localStorage.setItem('rolIdx',rolIdx); refreshPrecButtons(); schedule(); });
+
+  // Acquisition profile (/profile): the button steps through the presets
+  const btnProf = $("#btn-profile");
+  let profile = null;
+  function showProfile(j){ if (j && j.profile) { profile = j; btnProf.textContent = `Profile: ${j.profile.name}`; } }
+  async function getProfile(){ try { const r = await fetch("/profile"); if(!r.ok) throw 0; showProfile(await r.json()); } catch {} }
+  btnProf.addEventListener("click", async ()=>{
+    if (!profile) { await getProfile(); if (!profile) return; }
+    const ps = profile.presets, name = ps[(ps.indexOf(profile.profile.name) + 1) % ps.length];
+    try {
+      const r = await fetch("/profile", { method:"POST", headers:{ "Content-Type":"application/json" }, body: JSON.stringify({ name }) });
+      if (!r.ok) throw 0;
+      showProfile(await r.json()); statusEl.textContent = `profile ${name}`;
+    } catch { statusEl.textContent = "profile change failed"; }
+    setTimeout(()=>statusEl.textContent="ok", 1200);
+  });
 
   // Wi-Fi modal
   const wifiModal = $("#wifi-backdrop");
@@ -229,29 +257,71 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
   function norm01(v, fs){ return Math.min(1, Math.max(0, Math.abs(v) / fs)); }
   function mix3(a,b,t){ return Math.round(lerp(a,b,t)); }
 
-  // -------- Level gauge (avg for display only) --------------------------------
-  function drawLeveling(d){
-    const W = cvLevel._w, H = cvLevel._h, SCALE = totalScale();
-    const s = Math.min(W,H)*SCALE, cx=W/2, cy=H/2, R=s*0.35, fullDeg=LEVEL_STEPS[levIdx];
-    const pitch = (typeof d.pos_pitch_avg==="number")? d.pos_pitch_avg : (d.pos_pitch_calibrated||0);
-    const roll  = (typeof d.pos_roll_avg==="number") ? d.pos_roll_avg  : (d.pos_roll_calibrated ||0);
-
-    ctxL.clearRect(0,0,W,H);
+  // -------- Static layers ----------------------------------------------------
+  // Dial parts that depend only on canvas size and zoom live in their own
+  // canvas stacked under (or over) the live one, painted once per size; the
+  // browser composites them, so a live redraw never touches their pixels.
+  // ?redraw=all paints everything into the live canvas every time, for comparison.
+  const REDRAW_ALL = params.get('redraw') === 'all';
+  function dialLayer(ctx, cv, name, paint, over){
+    if (REDRAW_ALL) { ctx.save(); paint(ctx); ctx.restore(); return; }
+    const id = `${cv.width}x${cv.height}@${totalScale()}`;
+    const layers = cv._layers || (cv._layers = {});
+    let l = layers[name];
+    if (!l) {
+      l = layers[name] = document.createElement("canvas");
+      l.className = over ? "layer over" : "layer";
+      cv.parentNode.insertBefore(l, over ? cv.nextSibling : cv);
+    }
+    if (l._id === id) return;
+    l.width = cv.width; l.height = cv.height; l._id = id;
+    const g = l.getContext("2d"); g.setTransform(cv._dpr,0,0,cv._dpr,0,0);
+    paint(g);
+  }
 
+  // -------- Level gauge (avg for display only) --------------------------------
+  function levelInputs(d){
+    return {
+      pitch: (typeof d.pos_pitch_avg==="number")? d.pos_pitch_avg : (d.pos_pitch_calibrated||0),
+      roll:  (typeof d.pos_roll_avg==="number") ? d.pos_roll_avg  : (d.pos_roll_calibrated ||0),
+    };
+  }
+  function levelDial(g, s, cx, cy, R){
     // ring
-    ctxL.beginPath(); ctxL.arc(cx, cy, R, 0, Math.PI*2); ctxL.fillStyle="#001c0e"; ctxL.fill();
-    ctxL.strokeStyle="#1f1f1f"; ctxL.lineWidth=2; ctxL.stroke();
+    g.beginPath(); g.arc(cx, cy, R, 0, Math.PI*2); g.fillStyle="#001c0e"; g.fill();
+    g.strokeStyle="#1f1f1f"; g.lineWidth=2; g.stroke();
 
     // cross
-    ctxL.strokeStyle="rgba(255,255,255,0.25)"; ctxL.lineWidth=1;
-    ctxL.beginPath(); ctxL.moveTo(cx-R,cy); ctxL.lineTo(cx+R,cy); ctxL.stroke();
-    ctxL.beginPath(); ctxL.moveTo(cx,cy-R); ctxL.lineTo(cx,cy+R); ctxL.stroke();
+    g.strokeStyle="rgba(255,255,255,0.25)"; g.lineWidth=1;
+    g.beginPath(); g.moveTo(cx-R,cy); g.lineTo(cx+R,cy); g.stroke();
+    g.beginPath(); g.moveTo(cx,cy-R); g.lineTo(cx,cy+R); g.stroke();
 
     // "FWD" tag
-    ctxL.fillStyle="#00c853";
-    ctxL.font = Math.round(s*0.07)+"px system-ui, sans-serif";
-    ctxL.textAlign="center"; ctxL.textBaseline="bottom";
-    ctxL.fillText("FWD", cx, cy - R - s*0.08);
+    g.fillStyle="#00c853";
+    g.font = Math.round(s*0.07)+"px system-ui, sans-serif";
+    g.textAlign="center"; g.textBaseline="bottom";
+    g.fillText("FWD", cx, cy - R - s*0.08);
+  }
+  // The glowing dot, blurred once per size instead of on every draw
+  function dotSprite(r, dpr){
+    const key = `${r}@${dpr}`;
+    if (dotSprite.key !== key) {
+      const half = r + 12, c = document.createElement("canvas");
+      c.width = c.height = Math.ceil(half*2*dpr);
+      const g = c.getContext("2d"); g.setTransform(dpr,0,0,dpr,0,0);
+      g.beginPath(); g.arc(c.width/dpr/2, c.height/dpr/2, r, 0, Math.PI*2);
+      g.fillStyle="#ff1744"; g.shadowColor="#ff1744"; g.shadowBlur=8; g.fill();
+      dotSprite.canvas = c; dotSprite.key = key;
+    }
+    return dotSprite.canvas;
+  }
+  function drawLeveling(d){
+    const W = cvLevel._w, H = cvLevel._h, SCALE = totalScale();
+    const s = Math.min(W,H)*SCALE, cx=W/2, cy=H/2, R=s*0.35, fullDeg=LEVEL_STEPS[levIdx];
+    const { pitch, roll } = levelInputs(d);
+
+    ctxL.clearRect(0,0,W,H);
+    dialLayer(ctxL, cvLevel, "dial", (g)=>levelDial(g, s, cx, cy, R));
 
     // Labels (pitch/roll)
     ctxL.fillStyle="#ffffff"; ctxL.textAlign="center"; ctxL.textBaseline="middle";
@@ -285,8 +355,13 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
     const k = R*0.85 / fullDeg;
     let dx = clamp(roll*k, -R*0.85, R*0.85), dy = clamp(pitch*k, -R*0.85, R*0.85);
     const mag=Math.hypot(dx,dy); if (mag>R*0.85){ dx*= (R*0.85/mag); dy*= (R*0.85/mag); }
-    ctxL.beginPath(); ctxL.arc(cx+dx, cy+dy, s*0.02, 0, Math.PI*2);
-    ctxL.fillStyle="#ff1744"; ctxL.shadowColor="#ff1744"; ctxL.shadowBlur=8; ctxL.fill(); ctxL.shadowBlur=0;
+    if (REDRAW_ALL) {
+      ctxL.beginPath(); ctxL.arc(cx+dx, cy+dy, s*0.02, 0, Math.PI*2);
+      ctxL.fillStyle="#ff1744"; ctxL.shadowColor="#ff1744"; ctxL.shadowBlur=8; ctxL.fill(); ctxL.shadowBlur=0;
+    } else {
+      const dot = dotSprite(s*0.02, cvLevel._dpr), ds = dot.width / cvLevel._dpr;
+      ctxL.drawImage(dot, cx+dx - ds/2, cy+dy - ds/2, ds, ds);
+    }
 
     $("#txt-level").textContent = `pitch ${pitch.toFixed(2)}°, roll ${roll.toFixed(2)}° (±${fullDeg}° view, avg)`;
   }
@@ -349,7 +424,7 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
     const tF = norm01(pF, gFS), tB = norm01(pB, gFS), tR = norm01(pR, gFS), tL = norm01(pL, gFS);
 
     ctxM.clearRect(0,0,W,H);
-    drawAxisCross(ctxM, cx, cy, s);
+    dialLayer(ctxM, cvMotion, "axes", (g)=>drawAxisCross(g, cx, cy, s));
 
     // Peak arrows (thick)
     drawArrowForPeak(ctxM, cx, cy, s, -Math.PI/2, tF); // forward (+)
@@ -382,15 +457,20 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
   }
 
   // -------- Roll (gyro) with numbers + ticks at zero -------------------------
+  // current signed rates (derived from directional components)
+  function rollInputs(d){
+    return {
+      pitchRate: (+(d.gyro_pitchup||0)) - (+(d.gyro_pitchdown||0)),
+      rollRate:  (+(d.gyro_rollright||0)) - (+(d.gyro_rollleft ||0)), // RIGHT positive
+      turnRate:  (+(d.gyro_turnright||0)) - (+(d.gyro_turnleft ||0)),
+    };
+  }
   function drawRoll(d){
     const W = cvRoll._w, H = cvRoll._h, SCALE = totalScale(), dpsFS = ROLL_STEPS[rolIdx];
     const s = Math.min(W,H) * SCALE, cx = W/2, cy = H/2;
     const r  = s * 0.34, thick = s * 0.04, arcDeg = 90, half = (arcDeg * Math.PI / 180) / 2;
 
-    // current signed rates (derived from directional components)
-    const pitchRate = (+(d.gyro_pitchup||0)) - (+(d.gyro_pitchdown||0));
-    const rollRate  = (+(d.gyro_rollright||0)) - (+(d.gyro_rollleft ||0)); // RIGHT positive
-    const turnRate  = (+(d.gyro_turnright||0)) - (+(d.gyro_turnleft ||0));
+    const { pitchRate, rollRate, turnRate } = rollInputs(d);
 
     // peaks (directional) from firmware
     const rp = d.roll_peak || {};
@@ -401,8 +481,10 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
 
     ctxR.clearRect(0,0,W,H);
     // Background circle
-    ctxR.save(); ctxR.strokeStyle = "rgba(255,255,255,0.15)"; ctxR.lineWidth = thick;
-    ctxR.beginPath(); ctxR.arc(cx, cy, r, 0, Math.PI*2); ctxR.stroke(); ctxR.restore();
+    dialLayer(ctxR, cvRoll, "ring", (g)=>{
+      g.strokeStyle = "rgba(255,255,255,0.15)"; g.lineWidth = thick;
+      g.beginPath(); g.arc(cx, cy, r, 0, Math.PI*2); g.stroke();
+    });
 
     // Peak arcs (90° each, aligned to axes)
     function drawArc(ang, t){
@@ -422,8 +504,8 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
     drawArc( Math.PI/2,  tPD);
     drawArc( Math.PI,    tLeft);
 
-    // Axis cross
-    drawAxisCross(ctxR, cx, cy, s);
+    // Axis cross (over the arcs)
+    dialLayer(ctxR, cvRoll, "axes", (g)=>drawAxisCross(g, cx, cy, s), true);
 
     // Current thin red ticks — always draw (zero shows at center)
     drawRedTick(ctxR, cx, cy, s, (pitchRate>=0 ? -Math.PI/2 : Math.PI/2), norm01(Math.abs(pitchRate), dpsFS));
@@ -448,34 +530,272 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
       `gyro pitch/roll/turn dps: ${pitchRate.toFixed(1)}, ${rollRate.toFixed(1)}, ${turnRate.toFixed(1)} (peaks shown, ±${dpsFS}°/s view)`;
   }
 
-  // -------- Poll loop --------------------------------------------------------
-  async function tick(){
+  // -------- Sway alert banner ------------------------------------------------
+  const swayEl = $("#sway-alert");
+  function showSway(a){
+    if (!a || !a.active) { swayEl.style.display = "none"; return; }
+    swayEl.textContent = `SWAY ${a.hz.toFixed(2)} Hz — yaw ${a.yaw_dps.toFixed(1)}°/s, lateral ${a.lat_g.toFixed(2)} g`;
+    swayEl.style.display = "block";
+  }
+
+  // -------- Latency / drops --------------------------------------------------
+  // Frames carry seq and t_us (device clock at acquisition) and pub_us (when
+  // serialized). /time gives the device-to-page clock offset: of a few round
+  // trips the shortest wins, its reply taken as the midpoint. Latency runs
+  // from acquisition to the end of the draw; on the stream a seq gap counts
+  // as dropped frames (polling skips frames by design and counts none).
+  const LAT_N = 256;
+  const lat = { off:null, rtt:0, lastSeq:0, frames:0, drops:0, prevEnd:0, rx:0, resyncs:0,
+                total:[], dev:[], net:[], draw:[], gap:[] };
+  function keep(a, v){ if (isFinite(v)) { a.push(v); if (a.length > LAT_N) a.shift(); } }
+  function pct(a, p){
+    if (!a.length) return NaN;
+    const s = a.slice().sort((x,y)=>x-y);
+    return s[Math.min(s.length-1, Math.floor(p*s.length))];
+  }
+  async function syncClock(){
+    let best = null;
+    for (let i=0;i<8;i++){
+      try{
+        const t0 = performance.now();
+        const r = await fetch("/time", { cache:"no-store" });
+        if (!r.ok) throw 0;
+        const j = await r.json(), t1 = performance.now();
+        if (!best || t1-t0 < best.rtt) best = { rtt:t1-t0, off:j.us/1000 - (t0+t1)/2 };
+      } catch { break; }
+    }
+    if (best) { lat.off = best.off; lat.rtt = best.rtt; }
+  }
+  function countSeq(d, streaming){
+    if (typeof d.seq !== "number") return;
+    if (d.seq < lat.lastSeq) { lat.lastSeq = 0; syncClock(); }   // device restarted
+    if (streaming && lat.lastSeq && d.seq > lat.lastSeq + 1) lat.drops += d.seq - lat.lastSeq - 1;
+    lat.lastSeq = d.seq; lat.frames++;
+  }
+  // Once per frame, at the end of the paint that first shows it
+  function measure(d, recvMs, endMs){
+    if (lat.off !== null && typeof d.t_us === "number") {
+      keep(lat.total, endMs - (d.t_us/1000 - lat.off));
+      if (typeof d.pub_us === "number") {
+        keep(lat.dev, (d.pub_us - d.t_us)/1000);
+        keep(lat.net, recvMs - (d.pub_us/1000 - lat.off));
+      }
+    }
+    keep(lat.draw, endMs - recvMs);
+    if (lat.prevEnd) keep(lat.gap, endMs - lat.prevEnd);
+    lat.prevEnd = endMs;
+  }
+  const latEl = $("#lat-overlay");
+  let latOn = localStorage.getItem('lat') === '1';
+  function showLat(){
+    latEl.style.display = latOn ? "block" : "none";
+    if (!latOn) return;
+    const f = (v)=> isFinite(v) ? v.toFixed(v < 10 ? 1 : 0) : "–";
+    latEl.textContent =
+      `latency  p50 ${f(pct(lat.total,.5))}  p99 ${f(pct(lat.total,.99))} ms\n` +
+      `  device ${f(pct(lat.dev,.5))}  net ${f(pct(lat.net,.5))}  draw ${f(pct(lat.draw,.5))} ms (p50)\n` +
+      `frame gap p50 ${f(pct(lat.gap,.5))}  p99 ${f(pct(lat.gap,.99))} ms\n` +
+      `drops ${lat.drops}/${lat.frames + lat.drops}  ${es ? "stream " + ENC : "poll"}  rtt ${lat.off === null ? "–" : f(lat.rtt)} ms\n` +
+      (es ? `rx ${(lat.rx/1024).toFixed(2)} kB/s  resyncs ${lat.resyncs}\n` : "") +
+      `render p50 ${f(pct(rs.ms,.5))}  p99 ${f(pct(rs.ms,.99))} ms  gauges ${rs.drawn}/${rs.drawn + rs.skipped} drawn  ` +
+      `dpr ${cvLevel._dpr}${REDRAW_ALL ? "  redraw=all" : ""}\n` +
+      `paints ${rs.paints}/s  predict ${PREDICT ? "on" : "off"}`;
+    rs.drawn = rs.skipped = rs.paints = 0; lat.rx = 0;
+  }
+  $("#btn-lat").addEventListener("click", ()=>{ latOn = !latOn; localStorage.setItem('lat', latOn ? '1' : '0'); showLat(); });
+
+  // -------- Prediction -------------------------------------------------------
+  // Between frames the level gauge is dead-reckoned from the last frame: the
+  // angle moves at pitch_rate/roll_rate and the firmware's display EMA
+  // (avg_tau_ms) is run forward on it, up to the present, so transport
+  // latency is taken out as well. A new frame does not jump the dot: the
+  // previous prediction's error against it fades over PRED_BLEND_MS. The
+  // motion and rate gauges carry no derivative and show frames as they are.
+  // ?predict=0 turns it off.
+  const PREDICT = params.get('predict') !== '0';
+  const PRED_MAX_MS = 500;      // extrapolate no further when frames stall
+  const PRED_BLEND_MS = 120;
+  const RATE_DEADBAND = 0.3;    // deg/s: gyro bias and noise, not motion
+  const blend = { p:0, r:0, at:0 };
+  // EMA of x0 + rate*t started from avg0, t ms later
+  function emaAt(x0, avg0, rate, tau, t){
+    if (!(tau > 0)) return x0 + rate*t/1000;
+    const k = rate/1000;
+    return x0 + k*(t - tau) + (avg0 - x0 + k*tau) * Math.exp(-t/tau);
+  }
+  function levelAt(now){
+    const d = cur.d;
+    if (typeof d.pitch_rate !== "number" || typeof d.pos_pitch_calibrated !== "number") return null;
+    const acq = (lat.off !== null && typeof d.t_us === "number") ? d.t_us/1000 - lat.off : cur.recv;
+    const age = now - acq, t = Math.min(PRED_MAX_MS, Math.max(0, age)), tau = +(d.avg_tau_ms || 0);
+    const dz = (v)=> Math.abs(v) < RATE_DEADBAND ? 0 : v;
+    const pr = dz(d.pitch_rate), rr = dz(d.roll_rate || 0);
+    const { pitch: pAvg, roll: rAvg } = levelInputs(d);
+    const fade = Math.exp(-(now - blend.at) / PRED_BLEND_MS);
+    // Without any rate the instantaneous angles are sensor noise around the
+    // averages: hold those rather than run the EMA towards one noisy sample
+    const still = !pr && !rr;
+    const pitch = (still ? pAvg : emaAt(d.pos_pitch_calibrated, pAvg, pr, tau, t)) + blend.p * fade;
+    const roll  = (still ? rAvg : emaAt(d.pos_roll_calibrated || 0, rAvg, rr, tau, t)) + blend.r * fade;
+    // Still changing at 0.01 deg: rates or a fading error
+    const moving = age < PRED_MAX_MS && (!still || Math.max(Math.abs(blend.p), Math.abs(blend.r)) * fade > 0.005);
+    return { pitch, roll, moving };
+  }
+  function blendFrom(was, now){
+    blend.p = 0; blend.r = 0; blend.at = now;
+    const lv = levelAt(now);
+    if (lv) { blend.p = was.pitch - lv.pitch; blend.r = was.roll - lv.roll; }
+  }
+
+  // -------- Paint ------------------------------------------------------------
+  // Frames only record the newest data; drawing happens in the next animation
+  // frame, so a burst of arrivals costs one paint and a hidden tab none. Each
+  // gauge keys the inputs it shows, quantized to what can move a pixel or a
+  // label, and is only redrawn when its key changes.
+  const q = (v, fs)=> Math.round(v / fs * 500);
+  function levelKey(d){
+    const { pitch, roll } = levelInputs(d);
+    return [levIdx, Math.round(pitch*100), Math.round(roll*100)].join();
+  }
+  function motionKey(d){
+    const fs = MOTION_STEPS[motIdx], ap = d.accel_peak || {};
+    const f = +(d.accel_forward||0), r = +(d.accel_right||0), u = +(d.accel_up||0);
+    return [motIdx, q(f,fs), q(r,fs), Math.round(f*100), Math.round(r*100), Math.round(u*100),
+            q(+(ap.up||0),fs), q(+(ap.down||0),fs), q(+(ap.left||0),fs), q(+(ap.right||0),fs)].join();
+  }
+  function rollKey(d){
+    const fs = ROLL_STEPS[rolIdx], rp = d.roll_peak || {};
+    const { pitchRate, rollRate, turnRate } = rollInputs(d);
+    return [rolIdx, q(pitchRate,fs), q(rollRate,fs), Math.round(pitchRate*10), Math.round(rollRate*10), Math.round(turnRate*10),
+            q(+(rp.up||0),fs), q(+(rp.down||0),fs), q(+(rp.left||0),fs), q(+(rp.right||0),fs)].join();
+  }
+  const GAUGES = [
+    { draw: drawLeveling, key: levelKey,  shown: null },
+    { draw: drawMotion,   key: motionKey, shown: null },
+    { draw: drawRoll,     key: rollKey,   shown: null },
+  ];
+  const rs = { ms:[], drawn:0, skipped:0, paints:0 };   // paint cost; counts since the last readout
+  let cur = null, rafId = 0;
+  function schedule(){ if (!rafId) rafId = requestAnimationFrame(paint); }
+  function invalidate(){ GAUGES.forEach((g)=>g.shown = null); schedule(); }
+  function paint(){
+    rafId = 0;
+    if (!cur) return;
+    const t0 = performance.now();
+    const lv = PREDICT ? levelAt(t0) : null;
+    const d = lv ? Object.assign({}, cur.d, { pos_pitch_avg: lv.pitch, pos_roll_avg: lv.roll }) : cur.d;
+    rs.paints++;
+    for (const g of GAUGES) {
+      const k = REDRAW_ALL ? null : g.key(d);
+      if (k !== null && k === g.shown) { rs.skipped++; continue; }
+      g.draw(d); g.shown = k; rs.drawn++;
+    }
+    showSway(d.sway_alert);
+    const end = performance.now();
+    keep(rs.ms, end - t0);
+    if (!cur.measured) { cur.measured = true; measure(d, cur.recv, end); }
+    if (lv && lv.moving) schedule();   // keep animating until the prediction settles
+  }
+
+  // -------- Delta stream -----------------------------------------------------
+  // /stream?enc=delta (?enc=full for whole documents): a keyframe lists the
+  // fields with their steps and quantized values; a delta is [seq, seq - key,
+  // ms after the key, pub_us - t_us, field, change, ...] against it. Frames
+  // come out as the same objects /sensor returns. A delta for a keyframe we
+  // do not hold (lost on a slow link) reopens the stream, which starts with
+  // the latest keyframe.
+  const ENC = params.get('enc') === 'full' ? 'full' : 'delta';
+  const dk = { seq:-1, t_us:0, step:[], q:[], paths:[] };
+  function frameOf(q, seq, t_us, pub_us){
+    const d = { seq, t_us, pub_us };
+    dk.paths.forEach((p, i)=>{
+      let o = d;
+      for (let j = 0; j < p.length - 1; j++) o = o[p[j]] || (o[p[j]] = typeof p[j+1] === "number" ? [] : {});
+      o[p[p.length-1]] = q[i] * dk.step[i];
+    });
+    return d;
+  }
+  function decode(m){
+    if (!Array.isArray(m)) {
+      if (!m.fields) return m;
+      Object.assign(dk, { seq:m.key, t_us:m.t_us, step:m.step, q:m.q,
+        paths: m.fields.map((f)=>f.split('.').map((s)=> /^\d+$/.test(s) ? +s : s)) });
+      return frameOf(m.q, m.seq, m.t_us, m.pub_us);
+    }
+    if (m[0] - m[1] !== dk.seq) return null;
+    const q = dk.q.slice();
+    for (let i = 4; i < m.length; i += 2) q[m[i]] += m[i+1];
+    const t_us = dk.t_us + m[2]*1000;
+    return frameOf(q, m[0], t_us, t_us + m[3]);
+  }
+
+  // -------- Frames: /stream (SSE), polling as fallback -----------------------
+  let es = null;
+  function onFrame(d, recvMs, streaming){
+    lastOkTs = recvMs; statusEl.textContent = "ok";
+    countSeq(d, streaming);
+    const was = (PREDICT && cur) ? levelAt(recvMs) : null;
+    cur = { d, recv: recvMs, measured: false };
+    if (was && was.moving) blendFrom(was, recvMs);   // a still gauge just takes the frame
+    schedule();
+  }
+  function offline(){
+    const dt=(performance.now()-lastOkTs)/1000;
+    statusEl.textContent = dt>3 ? "offline" : "connecting...";
+  }
+  async function poll(){
     try{
       const r = await fetch("/sensor", { cache:"no-store" });
       if (!r.ok) throw 0;
-      const d = await r.json(); lastOkTs=performance.now(); statusEl.textContent="ok";
-      drawLeveling(d); drawMotion(d); drawRoll(d);
-    } catch {
-      const dt=(performance.now()-lastOkTs)/1000;
-      statusEl.textContent = dt>3 ? "offline" : "connecting...";
-    }
+      const d = await r.json();
+      onFrame(d, performance.now(), false);
+    } catch { offline(); }
+  }
+  function startStream(){
+    es = new EventSource(ENC === 'delta' ? "/stream?enc=delta" : "/stream");   // reconnects by itself
+    let opening = true;
+    es.onopen = ()=>{ opening = true; };
+    es.onmessage = (e)=>{
+      const t = performance.now();
+      lat.rx += e.data.length + 8;   // "data: " ... "\n\n"
+      let d; try { d = decode(JSON.parse(e.data)); } catch { return; }
+      if (!d) { lat.resyncs++; es.close(); startStream(); return; }
+      // A delta stream opens with the latest keyframe, which may be many
+      // seconds old: it only primes the decoder for the next frame
+      const skip = opening && ENC === 'delta';
+      opening = false;
+      if (!skip) onFrame(d, t, true);
+    };
+    es.onerror = offline;
   }
 
   // -------- Canvas sizing ----------------------------------------------------
+  // Backing store capped at 2x: a 3x phone fills 2.25x the pixels for no
+  // visible gain on these shapes (?dpr= overrides)
+  const DPR_MAX = parseFloat(params.get('dpr')) || 2;
   function fitCanvas(cv){
-    const dpr = window.devicePixelRatio || 1, rect=cv.getBoundingClientRect();
+    const dpr = Math.min(DPR_MAX, window.devicePixelRatio || 1), rect=cv.getBoundingClientRect();
     const w=Math.max(260, Math.floor(rect.width)), h=Math.max(240, Math.floor(rect.width*0.65));
-    cv.width=Math.round(w*dpr); cv.height=Math.round(h*dpr); cv._w=w; cv._h=h;
+    if (cv._w === w && cv._h === h && cv._dpr === dpr) return;   // setting width clears the canvas
+    cv.width=Math.round(w*dpr); cv.height=Math.round(h*dpr); cv._w=w; cv._h=h; cv._dpr=dpr;
     cv.getContext("2d").setTransform(dpr,0,0,dpr,0,0);
   }
   function resizeAll(){ [cvLevel, cvMotion, cvRoll].forEach(fitCanvas); }
-  window.addEventListener("resize", ()=>{ resizeAll(); tick(); });
+  window.addEventListener("resize", ()=>{ resizeAll(); invalidate(); });
 
-  // Boot
+  // Boot (?poll=1 or no EventSource: poll /sensor every ?ms=, or at the
+  // profile's ui_poll_ms, looked up on every pass so a switch takes effect)
   resizeAll();
-  const POLL_MS = Math.max(100, parseInt(params.get('ms') || '200', 10));
-  setInterval(tick, POLL_MS);
-  tick();
+  getProfile();
+  if (window.EventSource && !params.get('poll')) startStream();
+  else {
+    const pollMs = ()=> Math.max(100, parseInt(params.get('ms'), 10) || (profile ? profile.profile.ui_poll_ms : 200));
+    (function pollLoop(){ poll(); setTimeout(pollLoop, pollMs()); })();
+  }
+  syncClock();
+  setInterval(syncClock, 30000);   // crystal drift between the two clocks
+  setInterval(showLat, 1000);
+  showLat();
 })();
 </script>
 </body>
@@ -0,0 +1,273 @@
+// accel_cal.cpp : multi-orientation accelerometer calibration (see accel_cal.h)
+
+#include "accel_cal.h"
+
+#include <math.h>
+#include <string.h>
+
+// Design-vector columns of the diagonal model: x2 y2 z2 2x 2y 2z
+static const uint8_t kDiagCols[6] = { 0, 1, 2, 6, 7, 8 };
+static const uint8_t kFullCols[9] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+void AccelCalibrator::Sums::clear() { memset(this, 0, sizeof(*this)); }
+
+void AccelCalibrator::Sums::add(const double d[9]) {
+  for (int i = 0; i < 9; ++i) {
+    for (int j = i; j < 9; ++j) s[i][j] += d[i] * d[j];
+    r[i] += d[i];
+  }
+  n++;
+}
+
+void AccelCalibrator::Sums::merge(const Sums& o) {
+  for (int i = 0; i < 9; ++i) {
+    for (int j = i; j < 9; ++j) s[i][j] += o.s[i][j];
+    r[i] += o.r[i];
+  }
+  n += o.n;
+}
+
+void AccelCalibrator::start(uint8_t imu) {
+  _imu = imu;
+  _poses = 0;
+  _last = CAP_NONE;
+  _sum.clear(); _stage.clear();
+  _state = COLLECTING;
+}
+
+bool AccelCalibrator::capture(uint16_t n) {
+  if (_state != COLLECTING || n < 2) return false;
+  if (_poses >= TL_ACAL_MAX_POSES) { _last = CAP_FULL; return false; }
+  _stage.clear();
+  memset(_mean, 0, sizeof(_mean)); memset(_m2, 0, sizeof(_m2));
+  _target = n;
+  _state = CAPTURING;
+  return true;
+}
+
+void AccelCalibrator::push(float x, float y, float z) {
+  if (_state != CAPTURING) return;
+  const double u[3] = { x, y, z };
+  const double d[9] = { u[0] * u[0], u[1] * u[1], u[2] * u[2],
+                        2 * u[1] * u[2], 2 * u[0] * u[2], 2 * u[0] * u[1],
+                        2 * u[0], 2 * u[1], 2 * u[2] };
+  _stage.add(d);
+  for (int k = 0; k < 3; ++k) {
+    const double delta = u[k] - _mean[k];
+    _mean[k] += delta / _stage.n;
+    _m2[k] += delta * (u[k] - _mean[k]);
+  }
+  if (_stage.n >= _target) finishCapture();
+}
+
+void AccelCalibrator::finishCapture() {
+  _state = COLLECTING;
+  float sd = 0;
+  for (int k = 0; k < 3; ++k) sd = fmaxf(sd, (float)sqrt(_m2[k] / (_stage.n - 1)));
+  if (sd > TL_ACAL_STILL_G) { _last = CAP_MOVING; return; }
+
+  const double len = sqrt(_mean[0] * _mean[0] + _mean[1] * _mean[1] + _mean[2] * _mean[2]);
+  const double minCos = cos(TL_ACAL_MIN_POSE_DEG * M_PI / 180.0);
+  for (uint8_t i = 0; i < _poses; ++i) {
+    const float* p = _pose[i].u;
+    const double plen = sqrt((double)p[0] * p[0] + (double)p[1] * p[1] + (double)p[2] * p[2]);
+    const double c = (_mean[0] * p[0] + _mean[1] * p[1] + _mean[2] * p[2]) / (len * plen + 1e-12);
+    if (c > minCos) { _last = CAP_DUPLICATE; return; }
+  }
+
+  Pose& p = _pose[_poses++];
+  for (int k = 0; k < 3; ++k) p.u[k] = (float)_mean[k];
+  p.sd = sd;
+  p.n = (uint16_t)_stage.n;
+  _sum.merge(_stage);
+  _last = CAP_ACCEPTED;
+}
+
+uint8_t AccelCalibrator::faces() const {
+  const float minCos = cosf(TL_ACAL_MIN_POSE_DEG * (float)M_PI / 180.0f);
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < _poses; ++i) {
+    const float* u = _pose[i].u;
+    const float len = sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+    for (int k = 0; k < 3; ++k) {
+      if (u[k] >  minCos * len) mask |= 1u << (2 * k);
+      if (u[k] < -minCos * len) mask |= 1u << (2 * k + 1);
+    }
+  }
+  return mask;
+}
+
+// Gaussian elimination with partial pivoting, in place; false if a pivot
+// falls below tol relative to the largest diagonal entry of a
+static bool solveLinear(double a[9][9], double x[9], int n) {
+  double scale = 0;
+  for (int i = 0; i < n; ++i) scale = fmax(scale, fabs(a[i][i]));
+  const double tol = 1e-7 * scale;
+  for (int c = 0; c < n; ++c) {
+    int p = c;
+    for (int r = c + 1; r < n; ++r) if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+    if (!(fabs(a[p][c]) > tol)) return false;
+    if (p != c) {
+      for (int k = 0; k < n; ++k) { const double t = a[c][k]; a[c][k] = a[p][k]; a[p][k] = t; }
+      const double t = x[c]; x[c] = x[p]; x[p] = t;
+    }
+    for (int r = c + 1; r < n; ++r) {
+      const double f = a[r][c] / a[c][c];
+      for (int k = c; k < n; ++k) a[r][k] -= f * a[c][k];
+      x[r] -= f * x[c];
+    }
+  }
+  for (int c = n - 1; c >= 0; --c) {
+    for (int k = c + 1; k < n; ++k) x[c] -= a[c][k] * x[k];
+    x[c] /= a[c][c];
+  }
+  return true;
+}
+
+// Cyclic Jacobi on a symmetric 3x3: a becomes diagonal (eigenvalues), v the eigenvectors (columns)
+static void eigenSym3(double a[3][3], double v[3][3]) {
+  for (int i = 0; i < 3; ++i) for (int j = 0; j < 3; ++j) v[i][j] = i == j;
+  for (int sweep = 0; sweep < 16; ++sweep) {
+    const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    if (off < 1e-30) break;
+    for (int p = 0; p < 2; ++p) {
+      for (int q = p + 1; q < 3; ++q) {
+        if (fabs(a[p][q]) < 1e-300) continue;
+        const double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        const double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1));
+        const double c = 1 / sqrt(t * t + 1), s = t * c;
+        for (int k = 0; k < 3; ++k) {   // a = a J
+          const double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - s * akq; a[k][q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 3; ++k) {   // a = J' a
+          const double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk; a[q][k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < 3; ++k) {
+          const double vkp = v[k][p], vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq; v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
+
+static float normError(const AccelTrim& t, const float u[3]) {
+  const float d[3] = { u[0] - t.b[0], u[1] - t.b[1], u[2] - t.b[2] };
+  float s = 0;
+  for (int r = 0; r < 3; ++r) {
+    const float a = t.m[3 * r] * d[0] + t.m[3 * r + 1] * d[1] + t.m[3 * r + 2] * d[2];
+    s += a * a;
+  }
+  return sqrtf(s) - 1.0f;
+}
+
+AccelCalibrator::Result AccelCalibrator::solve(bool cross) const {
+  Result res;
+  const int n = params(cross);
+  if (_poses < n) { res.error = FEW_POSES; return res; }
+
+  // Noise keeps the cross columns from being exactly singular without tilted
+  // poses, so check the geometry instead: centred on the diagonal fit, every
+  // axis pair needs a pose at least TL_ACAL_MIN_POSE_DEG off both axes
+  if (cross) {
+    const Result diag = solve(false);
+    if (diag.error != OK && diag.error != IMPLAUSIBLE) return diag;
+    const float need = 0.5f * sinf(2.0f * TL_ACAL_MIN_POSE_DEG * (float)M_PI / 180.0f);
+    float tilt[3] = { 0, 0, 0 };   // yz, xz, xy
+    for (uint8_t i = 0; i < _poses; ++i) {
+      float c[3];
+      for (int k = 0; k < 3; ++k) c[k] = _pose[i].u[k] - diag.trim.b[k];
+      const float l2 = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+      tilt[0] = fmaxf(tilt[0], fabsf(c[1] * c[2]) / l2);
+      tilt[1] = fmaxf(tilt[1], fabsf(c[0] * c[2]) / l2);
+      tilt[2] = fmaxf(tilt[2], fabsf(c[0] * c[1]) / l2);
+    }
+    if (tilt[0] < need || tilt[1] < need || tilt[2] < need) { res.error = NEED_TILT; return res; }
+  }
+
+  // Normal equations (sum D D') v = sum D on the model's columns
+  const uint8_t* cols = cross ? kFullCols : kDiagCols;
+  double a[9][9], x[9];
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      const int ci = cols[i < j ? i : j], cj = cols[i < j ? j : i];
+      a[i][j] = _sum.s[ci][cj];
+    }
+    x[i] = _sum.r[cols[i]];
+  }
+  if (!solveLinear(a, x, n)) { res.error = SINGULAR; return res; }
+  double v[9] = {};
+  for (int i = 0; i < n; ++i) v[cols[i]] = x[i];
+
+  // u'Qu + 2L'u = 1  ->  (u - b)'Q(u - b) = 1 + b'Qb with b = -Q^-1 L
+  double q[3][3] = { { v[0], v[5], v[4] }, { v[5], v[1], v[3] }, { v[4], v[3], v[2] } };
+  const double det = q[0][0] * (q[1][1] * q[2][2] - q[1][2] * q[2][1])
+                   - q[0][1] * (q[1][0] * q[2][2] - q[1][2] * q[2][0])
+                   + q[0][2] * (q[1][0] * q[2][1] - q[1][1] * q[2][0]);
+  if (!(fabs(det) > 1e-12)) { res.error = NOT_ELLIPSOID; return res; }
+  const double inv[3][3] = {
+    { (q[1][1] * q[2][2] - q[1][2] * q[2][1]) / det, (q[0][2] * q[2][1] - q[0][1] * q[2][2]) / det, (q[0][1] * q[1][2] - q[0][2] * q[1][1]) / det },
+    { (q[1][2] * q[2][0] - q[1][0] * q[2][2]) / det, (q[0][0] * q[2][2] - q[0][2] * q[2][0]) / det, (q[0][2] * q[1][0] - q[0][0] * q[1][2]) / det },
+    { (q[1][0] * q[2][1] - q[1][1] * q[2][0]) / det, (q[0][1] * q[2][0] - q[0][0] * q[2][1]) / det, (q[0][0] * q[1][1] - q[0][1] * q[1][0]) / det } };
+  double b[3], k = 1;
+  for (int r = 0; r < 3; ++r) b[r] = -(inv[r][0] * v[6] + inv[r][1] * v[7] + inv[r][2] * v[8]);
+  for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) k += b[r] * q[r][c] * b[c];
+  if (!(k > 0)) { res.error = NOT_ELLIPSOID; return res; }
+
+  // M = sqrt(Q / k), the symmetric root: no rotation of the sensor axes
+  for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) q[r][c] /= k;
+  double e[3][3];
+  eigenSym3(q, e);
+  double root[3];
+  for (int i = 0; i < 3; ++i) {
+    if (!(q[i][i] > 0)) { res.error = NOT_ELLIPSOID; return res; }
+    root[i] = sqrt(q[i][i]);
+  }
+  AccelTrim& t = res.trim;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      double m = 0;
+      for (int i = 0; i < 3; ++i) m += e[r][i] * root[i] * e[c][i];
+      t.m[3 * r + c] = (float)m;
+    }
+    t.b[r] = (float)b[r];
+  }
+  t.cross = cross;
+
+  for (int r = 0; r < 3; ++r) {
+    if (fabsf(t.b[r]) > TL_ACAL_MAX_OFFSET_G || fabsf(t.m[4 * r] - 1.0f) > TL_ACAL_MAX_SCALE_ERR) {
+      res.error = IMPLAUSIBLE;
+    }
+  }
+
+  const AccelTrim identity;
+  float sum = 0, sumRaw = 0;
+  for (uint8_t i = 0; i < _poses; ++i) {
+    const float err = normError(t, _pose[i].u), raw = normError(identity, _pose[i].u);
+    sum += err * err; sumRaw += raw * raw;
+    res.maxG = fmaxf(res.maxG, fabsf(err));
+  }
+  res.rmsG = sqrtf(sum / _poses);
+  res.rmsRawG = sqrtf(sumRaw / _poses);
+  t.valid = res.error == OK;
+  return res;
+}
+
+const char* AccelCalibrator::errorName(Error e) {
+  switch (e) {
+    case OK:            return "ok";
+    case FEW_POSES:     return "too few poses";
+    case SINGULAR:      return "ill-conditioned: add poses in new orientations";
+    case NEED_TILT:     return "cross terms need poses tilted between every pair of axes";
+    case NOT_ELLIPSOID: return "poses do not fit an ellipsoid";
+    case IMPLAUSIBLE:   return "offset or scale out of range";
+  }
+  return "?";
+}
+
+const char* AccelCalibrator::captureName(Capture c) {
+  static const char* const names[] = { "none", "accepted", "moving", "duplicate", "full" };
+  return names[c < 5 ? c : 0];
+}
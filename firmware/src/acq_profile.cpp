@@ -0,0 +1,61 @@
+// acq_profile.cpp : acquisition profile presets and checks (see acq_profile.h)
+
+#include "acq_profile.h"
+
+#include <math.h>
+#include <string.h>
+
+// Noise figures are the MPU-6050's densities (400 ug/rtHz, 0.005 deg/s/rtHz)
+// over the DLPF bandwidth; the parked and towing deadbands sit at ~4.5 sigma
+const AcqProfile kAcqPresets[] = {
+  // DLPF off (the library's setup): 1 kHz accel read at TL_SAMPLE_HZ, so
+  // everything above 50 Hz folds into the reading, ~8 mg rms
+  { "general", 0, 0, 0, 0, TL_LEVEL_AVG_TAU_MS, TL_ACCEL_PEAK_TAU_MS, TL_ROLL_PEAK_TAU_MS,
+    TL_ACCEL_DEADBAND_G, TL_PUBLISH_HZ, TL_UI_DEFAULT_POLL_MS },
+  // 5 Hz DLPF, output refreshed at 100 Hz: ~1 mg and 0.02 deg/s rms, 0.07 deg
+  // on the instantaneous angles before the 2 s average; half the frames
+  { "parked",  6, 9, 0, 0, 2000, 1000, 1000, 0.005f, 5, 500 },
+  // 44 Hz DLPF (just under the tick's Nyquist), +-8 g and +-500 deg/s for
+  // pothole and swerve peaks, held 3 s; ~3 mg rms. Twice the frames
+  { "towing",  3, 9, 1, 2, 600, 3000, 3000, 0.015f, 20, 100 },
+};
+const uint8_t kAcqPresetCount = sizeof(kAcqPresets) / sizeof(kAcqPresets[0]);
+
+const AcqProfile* acqPreset(const char* name) {
+  if (!name) return nullptr;
+  for (uint8_t i = 0; i < kAcqPresetCount; ++i)
+    if (strcmp(kAcqPresets[i].name, name) == 0) return &kAcqPresets[i];
+  return nullptr;
+}
+
+// DLPF_CFG 0..6: accel bandwidth and delay (ms) per the register map
+static const float kDlpfHz[7]    = { 260, 184, 94, 44, 21, 10, 5 };
+static const float kDlpfDelay[7] = { 0, 2.0f, 3.0f, 4.9f, 8.5f, 13.8f, 19.0f };
+
+float acqDlpfHz(uint8_t dlpf) { return dlpf < 7 ? kDlpfHz[dlpf] : 0.0f; }
+
+float acqOutputHz(const AcqProfile& p) {
+  const float gyroHz = p.dlpf == 0 ? 8000.0f : 1000.0f;
+  return gyroHz / (1.0f + p.smplrtDiv);
+}
+
+// Two output periods (accel refreshes at most at 1 kHz) and the filter delay:
+// the registers then hold a sample taken entirely under the new setup
+uint32_t acqSettleMs(const AcqProfile& p) {
+  const float outHz = fminf(acqOutputHz(p), 1000.0f);
+  const float ms = 2000.0f / outHz + (p.dlpf < 7 ? kDlpfDelay[p.dlpf] : 0.0f);
+  return (uint32_t)ceilf(ms);
+}
+
+const char* acqProfileError(const AcqProfile& p) {
+  if (p.dlpf > 6) return "dlpf must be 0..6";
+  if (p.gyroRange > 3 || p.accRange > 3) return "gyro_range and acc_range must be 0..3";
+  if (acqOutputHz(p) < TL_SAMPLE_HZ) return "smplrt_div leaves the output rate below the sample rate";
+  const uint16_t taus[] = { p.levelAvgTauMs, p.accelPeakTauMs, p.rollPeakTauMs };
+  for (uint16_t t : taus)
+    if (t < 50 || t > 60000) return "time constants must be 50..60000 ms";
+  if (!(p.accelDeadbandG >= 0.0f && p.accelDeadbandG <= 0.5f)) return "accel_deadband_g must be 0..0.5";
+  if (p.publishHz < 1 || p.publishHz > TL_SAMPLE_HZ / 4) return "publish_hz out of range";
+  if (p.uiPollMs < 100 || p.uiPollMs > 5000) return "ui_poll_ms must be 100..5000";
+  return nullptr;
+}
@@ -0,0 +1,137 @@
+// captive_dns.cpp : wildcard captive-portal DNS task (see captive_dns.h)
+
+#include "captive_dns.h"
+
+#include <lwip/sockets.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static constexpr size_t DNS_HEADER_LEN = 12;
+static constexpr size_t DNS_MAX_PACKET = 512;
+static constexpr uint16_t DNS_TYPE_A = 1, DNS_TYPE_ANY = 255, DNS_CLASS_IN = 1;
+
+static uint16_t rd16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+static void wr16(uint8_t* p, uint16_t v) { p[0] = v >> 8; p[1] = v & 0xFF; }
+
+// Case-insensitive compare of an uncompressed QNAME with a dotted name
+static bool qnameEquals(const uint8_t* q, const uint8_t* end, const char* dotted) {
+  while (q < end && *q) {
+    uint8_t n = *q++;
+    if (q + n > end) return false;
+    for (uint8_t i = 0; i < n; ++i, ++dotted) {
+      if (!*dotted || tolower(q[i]) != tolower((uint8_t)*dotted)) return false;
+    }
+    q += n;
+    if (q < end && *q && *dotted++ != '.') return false;
+  }
+  return *dotted == 0;
+}
+
+void CaptiveDns::buildAnswer(uint8_t* rec, uint32_t ttl, IPAddress ip) {
+  wr16(rec + 0, 0xC00C);                 // pointer to the question name
+  wr16(rec + 2, DNS_TYPE_A);
+  wr16(rec + 4, DNS_CLASS_IN);
+  rec[6] = ttl >> 24; rec[7] = ttl >> 16; rec[8] = ttl >> 8; rec[9] = ttl;
+  wr16(rec + 10, 4);
+  rec[12] = ip[0]; rec[13] = ip[1]; rec[14] = ip[2]; rec[15] = ip[3];
+}
+
+void CaptiveDns::setIP(IPAddress ip) {
+  buildAnswer(_ansOwn, TL_DNS_OWN_TTL_SECONDS, ip);
+  buildAnswer(_ansOther, TL_DNS_TTL_SECONDS, ip);
+}
+
+bool CaptiveDns::begin(IPAddress ip) {
+  setIP(ip);
+  if (_fd >= 0) return true;
+  int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd < 0) { log_e("dns: socket() failed"); return false; }
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(53);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    log_e("dns: bind(53) failed");
+    close(fd); return false;
+  }
+  _fd = fd;
+  _load.name = "dns"; _load.core = TL_NET_CORE;
+  if (xTaskCreatePinnedToCore(taskEntry, "dns", TL_DNS_TASK_STACK, this, TL_DNS_TASK_PRIO, &_load.handle, TL_NET_CORE) != pdPASS) {
+    log_e("dns: task create failed");
+    return false;
+  }
+  return true;
+}
+
+void CaptiveDns::taskEntry(void* arg) { static_cast<CaptiveDns*>(arg)->run(); }
+
+// Token bucket per client address; the least recently seen slot is recycled
+bool CaptiveDns::admit(uint32_t addr, uint32_t nowMs) {
+  Bucket* b = nullptr; Bucket* oldest = &_buckets[0];
+  for (size_t i = 0; i < TL_DNS_RL_CLIENTS; ++i) {
+    if (_buckets[i].addr == addr) { b = &_buckets[i]; break; }
+    if ((int32_t)(_buckets[i].lastMs - oldest->lastMs) < 0 || _buckets[i].addr == 0) oldest = &_buckets[i];
+  }
+  if (!b) { b = oldest; b->addr = addr; b->tokens = TL_DNS_RL_BURST; b->lastMs = nowMs; }
+
+  b->tokens += (float)(nowMs - b->lastMs) * (TL_DNS_RL_QPS / 1000.0f);
+  if (b->tokens > TL_DNS_RL_BURST) b->tokens = TL_DNS_RL_BURST;
+  b->lastMs = nowMs;
+  if (b->tokens < 1.0f) return false;
+  b->tokens -= 1.0f;
+  return true;
+}
+
+// Turns the query in pkt into its reply in place; returns the reply length or 0 to drop.
+size_t CaptiveDns::answer(uint8_t* pkt, size_t len, size_t cap) {
+  if (len < DNS_HEADER_LEN) return 0;
+  const uint16_t flags = rd16(pkt + 2);
+  // Standard query (QR=0, OPCODE=0) with exactly one question
+  if ((flags & 0x8000) || (flags & 0x7800) || rd16(pkt + 4) != 1) return 0;
+
+  const uint8_t* end = pkt + len;
+  const uint8_t* q = pkt + DNS_HEADER_LEN;
+  while (q < end && *q) {
+    if (*q & 0xC0) return 0;     // compression is not valid in a question
+    q += *q + 1;
+  }
+  if (q + 5 > end) return 0;
+  const uint8_t* qname = pkt + DNS_HEADER_LEN;
+  const uint16_t qtype = rd16(q + 1), qclass = rd16(q + 3);
+  const size_t qEnd = (q + 5) - pkt;
+
+  // Header: response, authoritative, keep RD, NOERROR; drop any EDNS/extra records
+  wr16(pkt + 2, 0x8400 | (flags & 0x0100));
+  wr16(pkt + 6, 0); wr16(pkt + 8, 0); wr16(pkt + 10, 0);
+
+  if ((qtype != DNS_TYPE_A && qtype != DNS_TYPE_ANY) || qclass != DNS_CLASS_IN || qEnd + kAnswerLen > cap) {
+    _stats.empty++;
+    return qEnd;
+  }
+  const bool own = qnameEquals(qname, end, TL_DOMAIN);
+  if (own) _stats.ownDomain++;
+  memcpy(pkt + qEnd, own ? _ansOwn : _ansOther, kAnswerLen);
+  wr16(pkt + 6, 1);
+  _stats.answered++;
+  return qEnd + kAnswerLen;
+}
+
+void CaptiveDns::run() {
+  uint8_t pkt[DNS_MAX_PACKET];
+  for (;;) {
+    struct sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    int n = recvfrom(_fd, pkt, sizeof(pkt), 0, (struct sockaddr*)&from, &fromLen);
+    if (n <= 0) { vTaskDelay(pdMS_TO_TICKS(10)); continue; }
+    const uint32_t t0 = micros();
+    _stats.queries++;
+
+    if (!admit(from.sin_addr.s_addr, millis())) { _stats.rateLimited++; }
+    else {
+      size_t out = answer(pkt, (size_t)n, sizeof(pkt));
+      if (out) sendto(_fd, pkt, out, 0, (struct sockaddr*)&from, fromLen);
+      else _stats.malformed++;
+    }
+    _load.add(micros() - t0);
+  }
+}
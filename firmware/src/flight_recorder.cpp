@@ -0,0 +1,95 @@
+// flight_recorder.cpp : PSRAM pre-trigger recorder (see flight_recorder.h)
+
+#include "flight_recorder.h"
+
+bool FlightRecorder::begin() {
+  if (_ring) return true;
+  if (!psramFound()) { log_e("recorder: no PSRAM, disabled"); return false; }
+  _ring = (RecSample*)ps_malloc(sizeof(RecSample) * kRingLen);
+  if (!_ring) { log_e("recorder: ring allocation failed"); return false; }
+  return true;
+}
+
+void FlightRecorder::record(const ImuBus& bus, float accelMagG, bool swayRaised, uint32_t nowMs) {
+  if (!_ring) return;
+  const uint32_t c0 = ESP.getCycleCount();
+
+  RecSample& s = _ring[_written % kRingLen];
+  s.us = bus.sample(0).us;
+  for (uint8_t i = 0; i < TL_IMU_MAX; ++i) memcpy(s.raw[i], bus.sample(i).raw, sizeof(s.raw[i]));
+  _written++;
+
+  // Accel triggers on the upward crossing only: a long pull is one event
+  const bool accelHigh = accelMagG >= _accelG;
+  const bool accelEdge = accelHigh && !_accelHigh;
+  _accelHigh = accelHigh;
+
+  const uint8_t st = _state.load(std::memory_order_relaxed);
+  if (st == ARMED) {
+    if (_manual.exchange(false, std::memory_order_relaxed)) start(MANUAL, 0, bus, nowMs);
+    else if (swayRaised)                                     start(SWAY, 0, bus, nowMs);
+    else if (accelEdge)                                      start(ACCEL, accelMagG, bus, nowMs);
+  } else {
+    if (swayRaised || accelEdge || _manual.exchange(false, std::memory_order_relaxed)) _stats.ignored++;
+    if (st == CAPTURING && _written >= _winEnd) _state.store(READY, std::memory_order_release);
+  }
+
+  const uint32_t cyc = ESP.getCycleCount() - c0;
+  _stats.samples++; _stats.cycles += cyc;
+  if (cyc > _stats.maxCycles) _stats.maxCycles = cyc;
+}
+
+void FlightRecorder::start(Kind kind, float value, const ImuBus& bus, uint32_t nowMs) {
+  const uint32_t trig = _written - 1;                 // the sample just stored
+  _winStart = trig >= kPreLen ? trig - kPreLen : 0;   // less pre-roll right after boot
+  _winEnd = trig + 1 + kPostLen;
+
+  RecHeader& h = _hdr;
+  h = RecHeader{};
+  memcpy(h.magic, "TLFR", 4);
+  h.version = 1;
+  h.sampleSize = sizeof(RecSample);
+  h.count = _winEnd - _winStart;
+  h.triggerIndex = trig - _winStart;
+  h.triggerMs = nowMs;
+  h.sampleHz = TL_SAMPLE_HZ;
+  h.kind = kind;
+  h.value = value;
+  for (uint8_t i = 0; i < TL_IMU_MAX; ++i) {
+    if (bus.present(i)) h.imuMask |= 1u << i;
+    h.accLsbPerG[i] = bus.device(i).accLsbPerG;
+    h.gyroLsbPerDps[i] = bus.device(i).gyroLsbPerDps;
+  }
+  _stats.triggers++;
+  _state.store(CAPTURING, std::memory_order_release);
+}
+
+void FlightRecorder::service() {
+  if (_state.load(std::memory_order_acquire) != READY) return;
+
+  const size_t bytes = sizeof(RecHeader) + (size_t)_hdr.count * sizeof(RecSample);
+  SharedFrame* f = SharedFrame::create(bytes, true);
+  if (f) {
+    uint8_t* out = (uint8_t*)f->json();
+    memcpy(out, &_hdr, sizeof(RecHeader));
+    uint8_t* dst = out + sizeof(RecHeader);   // not RecSample-aligned: byte copies only
+    // Copy in at most two runs (the window may wrap the ring)
+    uint32_t n = _winStart;
+    while (n < _winEnd) {
+      const uint32_t idx = n % kRingLen;
+      const uint32_t run = min(_winEnd - n, kRingLen - idx);
+      memcpy(dst, _ring + idx, run * sizeof(RecSample));
+      dst += run * sizeof(RecSample); n += run;
+    }
+    // The writer may have lapped the oldest samples while this ran
+    if (_written - _winStart > kRingLen) { f->unref(); f = nullptr; }
+  }
+  if (f) {
+    f->jsonLen = bytes;
+    _capture.publish(f);
+    _stats.captures++;
+  } else {
+    _stats.lost++;
+  }
+  _state.store(ARMED, std::memory_order_release);
+}
@@ -0,0 +1,87 @@
+// frame_delta.cpp : keyframe + delta telemetry encoding (see frame_delta.h)
+
+#include "frame_delta.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace {
+// Bounded appender over the caller's buffer; full once anything was cut
+struct Out {
+  char* p;
+  size_t cap, len = 0;
+  bool full = false;
+  Out(char* buf, size_t n) : p(buf), cap(n) { if (cap) p[0] = 0; else full = true; }
+  void put(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    if (full) return;
+    va_list ap; va_start(ap, fmt);
+    const int n = vsnprintf(p + len, cap - len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= cap - len) { full = true; return; }
+    len += n;
+  }
+};
+
+int32_t quantize(float v, float step) {
+  if (!isfinite(v)) return 0;
+  const float q = roundf(v / step);
+  return q > 2.0e9f ? 2000000000 : q < -2.0e9f ? -2000000000 : (int32_t)q;
+}
+}  // namespace
+
+DeltaEncoder::DeltaEncoder(const StreamField* fields, uint8_t count, uint32_t keyMs)
+    : _f(fields), _count(count < TL_STREAM_MAX_FIELDS ? count : TL_STREAM_MAX_FIELDS), _keyMs(keyMs) {
+  for (uint8_t i = 0; i < _count; ++i) {
+    const int32_t d = (int32_t)lroundf(_f[i].deadband / _f[i].step);
+    _dbq[i] = d < 1 ? 1 : d;
+  }
+}
+
+size_t DeltaEncoder::encode(const float* v, uint8_t n, uint32_t seq, int64_t tUs, int64_t pubUs, char* out, size_t cap) {
+  if (n > _count) n = _count;
+  int32_t q[TL_STREAM_MAX_FIELDS];
+  for (uint8_t i = 0; i < n; ++i) q[i] = quantize(v[i], _f[i].step);
+  const bool key = _needKey || n != _n || tUs - _keyUs >= (int64_t)_keyMs * 1000;
+  const size_t len = key ? keyframe(q, n, seq, tUs, pubUs, out, cap) : delta(q, seq, tUs, pubUs, out, cap);
+  if (!len) { _needKey = true; _stats.overflows++; }
+  return len;
+}
+
+size_t DeltaEncoder::keyframe(const int32_t* q, uint8_t n, uint32_t seq, int64_t tUs, int64_t pubUs, char* out, size_t cap) {
+  Out o(out, cap);
+  o.put("{\"seq\":%lu,\"key\":%lu,\"t_us\":%lld,\"pub_us\":%lld,\"fields\":[",
+        (unsigned long)seq, (unsigned long)seq, (long long)tUs, (long long)pubUs);
+  for (uint8_t i = 0; i < n; ++i) o.put("%s\"%s\"", i ? "," : "", _f[i].name);
+  o.put("],\"step\":[");
+  for (uint8_t i = 0; i < n; ++i) o.put("%s%g", i ? "," : "", (double)_f[i].step);
+  o.put("],\"q\":[");
+  for (uint8_t i = 0; i < n; ++i) o.put("%s%ld", i ? "," : "", (long)q[i]);
+  o.put("]}");
+  if (o.full) return 0;
+
+  for (uint8_t i = 0; i < n; ++i) _keyQ[i] = q[i];
+  _n = n; _keySeq = seq; _keyUs = tUs;
+  _needKey = false; _lastKey = true;
+  _stats.keys++; _stats.keyBytes += o.len;
+  return o.len;
+}
+
+size_t DeltaEncoder::delta(const int32_t* q, uint32_t seq, int64_t tUs, int64_t pubUs, char* out, size_t cap) {
+  Out o(out, cap);
+  o.put("[%lu,%lu,%lld,%lld", (unsigned long)seq, (unsigned long)(seq - _keySeq),
+        (long long)((tUs - _keyUs + 500) / 1000), (long long)(pubUs - tUs));
+  bool any = false;
+  for (uint8_t i = 0; i < _n; ++i) {
+    const int64_t d = (int64_t)q[i] - _keyQ[i];   // quantize() spans +-2e9: the change can pass int32
+    if (d >= _dbq[i] || d <= -_dbq[i]) { o.put(",%u,%lld", (unsigned)i, (long long)d); any = true; }
+  }
+  o.put("]");
+  if (o.full) return 0;
+
+  _lastKey = false;
+  _stats.deltas++; _stats.deltaBytes += o.len;
+  if (!any) _stats.still++;
+  if (o.len > _stats.maxDelta) _stats.maxDelta = (uint16_t)o.len;
+  return o.len;
+}
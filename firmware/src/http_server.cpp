@@ -0,0 +1,749 @@
+// http_server.cpp : event-driven HTTP/1.x server (see http_server.h)
+
+#include "http_server.h"
+
+#include <lwip/sockets.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+struct HttpServer::Conn {
+  int fd = -1;
+  bool writing = false;
+  bool streaming = false;       // SSE subscriber: frames follow the head until close
+  uint8_t channel = 0;          // ... of this broadcast channel
+  bool clientKeepAlive = false; // request allows a persistent connection
+  bool keepAlive = false;       // this response leaves the connection open
+  uint16_t served = 0;          // responses completed on this connection
+  uint32_t lastIoMs = 0;
+  uint32_t reqStartUs = 0;
+
+  // Request (parsed in place; pointers into rx)
+  char rx[TL_HTTP_RX_BUF + 1];
+  size_t rxLen = 0;
+  size_t reqLen = 0;            // bytes of rx taken by the current request
+  HTTPMethod method = HTTP_GET;
+  const char* path = "";
+  const char* query = nullptr;
+  const char* hdrs = "";        // header lines after the request line, NUL-terminated
+  const char* body = nullptr;
+  size_t bodyLen = 0;
+
+  // ROUTE_UPLOAD body in flight: the head stays in rx, chunks land behind it
+  bool uploading = false;
+  const Route* upRoute = nullptr;
+  size_t upTotal = 0, upGot = 0;
+
+  // Response: head and body sit in the request arena while the handler runs
+  // and in heap[] once they outlive it (or did not fit); the body may also
+  // point at flash or a referenced SharedFrame (pending = next frame for a
+  // busy subscriber)
+  const char* head = nullptr;
+  size_t headLen = 0;
+  char* heap[2] = { nullptr, nullptr };   // owned copies of head / body
+  SharedFrame* frame = nullptr;
+  SharedFrame* pending = nullptr;
+  const char* out = nullptr;
+  size_t outLen = 0;
+  size_t headOff = 0, outOff = 0;
+};
+
+// ---------------- Small helpers ----------------
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 302: return "Found";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+  }
+  return "";
+}
+
+static bool parseMethod(const char* s, HTTPMethod& m) {
+  if      (!strcmp(s, "GET"))     m = HTTP_GET;
+  else if (!strcmp(s, "POST"))    m = HTTP_POST;
+  else if (!strcmp(s, "OPTIONS")) m = HTTP_OPTIONS;
+  else if (!strcmp(s, "HEAD"))    m = HTTP_HEAD;
+  else if (!strcmp(s, "PUT"))     m = HTTP_PUT;
+  else if (!strcmp(s, "DELETE"))  m = HTTP_DELETE;
+  else if (!strcmp(s, "PATCH"))   m = HTTP_PATCH;
+  else return false;
+  return true;
+}
+
+static int hexVal(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Percent/plus decoding into out (room for n + 1); returns the decoded length
+static size_t urlDecode(const char* s, size_t n, char* out) {
+  size_t o = 0;
+  for (size_t i = 0; i < n; ++i) {
+    char c = s[i];
+    if (c == '+') c = ' ';
+    else if (c == '%' && i + 2 < n) {
+      int hi = hexVal(s[i+1]), lo = hexVal(s[i+2]);
+      if (hi >= 0 && lo >= 0) { c = (char)((hi << 4) | lo); i += 2; }
+    }
+    out[o++] = c;
+  }
+  out[o] = 0;
+  return o;
+}
+
+// Content-Length value up to eol: digits only (blanks around allowed), no
+// overflow; anything else makes the request unframeable
+static bool parseLength(const char* v, const char* eol, size_t& out) {
+  while (v < eol && (*v == ' ' || *v == '\t')) ++v;
+  while (eol > v && (eol[-1] == ' ' || eol[-1] == '\t')) --eol;
+  if (v == eol) return false;
+  size_t n = 0;
+  for (; v < eol; ++v) {
+    if (*v < '0' || *v > '9') return false;
+    const size_t d = *v - '0';
+    if (n > (SIZE_MAX - d) / 10) return false;
+    n = n * 10 + d;
+  }
+  out = n;
+  return true;
+}
+
+static uint32_t nowUs() { return (uint32_t)esp_timer_get_time(); }
+
+// ---------------- Public API ----------------
+HttpServer::HttpServer(uint16_t port) : _port(port) {}
+
+void HttpServer::setRoutes(RouteLookup lookup) { _lookup = lookup; }
+
+void HttpServer::onNotFound(THandlerFunction fn) { _notFound = fn; }
+
+bool HttpServer::begin() {
+  if (_listenFd >= 0) return true;
+  int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0) { log_e("http: socket() failed"); return false; }
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(_port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, TL_HTTP_MAX_CLIENTS) != 0) {
+    log_e("http: bind/listen on port %u failed", _port);
+    close(fd); return false;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  _listenFd = fd;
+
+  // Wake-up socket on loopback so broadcast() from another task interrupts select()
+  _wakeFd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  struct sockaddr_in wa = {};
+  wa.sin_family = AF_INET;
+  wa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t wl = sizeof(wa);
+  if (_wakeFd < 0 || bind(_wakeFd, (struct sockaddr*)&wa, sizeof(wa)) != 0 ||
+      getsockname(_wakeFd, (struct sockaddr*)&wa, &wl) != 0) {
+    log_e("http: wake socket failed");
+    return false;
+  }
+  fcntl(_wakeFd, F_SETFL, fcntl(_wakeFd, F_GETFL, 0) | O_NONBLOCK);
+  _wakePort = ntohs(wa.sin_port);
+
+  _conns = new Conn[TL_HTTP_MAX_CLIENTS];
+  _load.name = "http"; _load.core = TL_NET_CORE;
+  if (xTaskCreatePinnedToCore(taskEntry, "http", TL_HTTP_TASK_STACK, this, TL_HTTP_TASK_PRIO, &_load.handle, TL_NET_CORE) != pdPASS) {
+    log_e("http: task create failed");
+    return false;
+  }
+  return true;
+}
+
+HTTPMethod HttpServer::method() const { return _cur && _cur->method != HTTP_HEAD ? _cur->method : HTTP_GET; }
+const char* HttpServer::uri() const { return _cur ? _cur->path : ""; }
+
+bool HttpServer::rawArg(const char* name, const char** val, size_t* len) const {
+  if (!_cur || !_cur->query) return false;
+  const size_t nlen = strlen(name);
+  const char* p = _cur->query;
+  while (*p) {
+    const char* amp = strchr(p, '&'); if (!amp) amp = p + strlen(p);
+    const char* eq = (const char*)memchr(p, '=', amp - p);
+    const char* kend = eq ? eq : amp;
+    if ((size_t)(kend - p) == nlen && !memcmp(p, name, nlen)) {
+      *val = eq ? eq + 1 : amp; *len = eq ? (size_t)(amp - eq - 1) : 0;
+      return true;
+    }
+    p = *amp ? amp + 1 : amp;
+  }
+  return false;
+}
+
+bool HttpServer::hasArg(const char* name) const {
+  const char* v; size_t n; return rawArg(name, &v, &n);
+}
+
+bool HttpServer::findArg(const char* name, const char** val, size_t* len) {
+  const char* raw; size_t n;
+  if (!rawArg(name, &raw, &n)) return false;
+  char* out = (char*)_arena.alloc(n + 1);
+  if (!out) return false;
+  const size_t m = urlDecode(raw, n, out);
+  *val = out;
+  if (len) *len = m;
+  return true;
+}
+
+const char* HttpServer::body() const { return _cur ? _cur->body : nullptr; }
+size_t HttpServer::bodyLen() const { return _cur ? _cur->bodyLen : 0; }
+
+static bool findHeader(const char* hdrs, const char* name, const char** val, size_t* len) {
+  const size_t nlen = strlen(name);
+  for (const char* p = hdrs; *p; ) {
+    const char* eol = strstr(p, "\r\n"); if (!eol) eol = p + strlen(p);
+    if ((size_t)(eol - p) > nlen && p[nlen] == ':' && !strncasecmp(p, name, nlen)) {
+      const char* v = p + nlen + 1;
+      while (v < eol && *v == ' ') ++v;
+      *val = v; *len = eol - v;
+      return true;
+    }
+    p = *eol ? eol + 2 : eol;
+  }
+  return false;
+}
+
+bool HttpServer::header(const char* name, const char** val, size_t* len) const {
+  return _cur && findHeader(_cur->hdrs, name, val, len);
+}
+
+void HttpServer::sendHeader(const char* name, const char* value, bool first) {
+  FixedString<TL_HTTP_EXTRA_HEADERS> line;
+  line.append(name).append(": ").append(value).append("\r\n");
+  if (line.truncated() || line.length() > _pendingHeaders.capacity() - _pendingHeaders.length()) {
+    log_w("http: header %s dropped (TL_HTTP_EXTRA_HEADERS)", name);
+    return;
+  }
+  if (first) _pendingHeaders.prepend(line.c_str(), line.length());
+  else _pendingHeaders.append(line.c_str(), line.length());
+}
+
+// CORS headers for ROUTE_CORS routes; Allow-Methods comes from the route's mask
+template <size_t N>
+void HttpServer::appendPolicyHeaders(FixedString<N>& head) {
+  if (!_route || !(_route->flags & ROUTE_CORS)) return;
+  static const struct { HTTPMethod m; const char* name; } kNames[] = {
+    { HTTP_GET, "GET" }, { HTTP_POST, "POST" }, { HTTP_PUT, "PUT" }, { HTTP_DELETE, "DELETE" }, { HTTP_PATCH, "PATCH" },
+  };
+  head.append("Access-Control-Allow-Origin: *\r\nAccess-Control-Allow-Methods: ");
+  for (const auto& k : kNames) {
+    if (_route->methods & methodBit(k.m)) head.append(k.name).append(',');
+  }
+  head.append("OPTIONS\r\nAccess-Control-Allow-Headers: Content-Type\r\n");
+}
+
+// Arena copy of the head; the heap only if the arena is full
+void HttpServer::setHead(Conn& c, const char* head, size_t len) {
+  void* d = _arena.copy(head, len);
+  if (!d && (d = malloc(len))) { memcpy(d, head, len); c.heap[0] = (char*)d; }
+  if (!d) log_e("http: no memory for response head");
+  c.head = (const char*)d; c.headLen = d ? len : 0;
+}
+
+void HttpServer::beginResponse(int code, const char* contentType, size_t len) {
+  Conn& c = *_cur;
+  _head.clear();
+  _head.appendf("HTTP/1.1 %d %s\r\n", code, statusText(code));
+  if (contentType && *contentType) _head.append("Content-Type: ").append(contentType).append("\r\n");
+  _head.appendf("Content-Length: %u\r\n", (unsigned)len);
+  if (c.keepAlive) {
+    _head.appendf("Connection: keep-alive\r\nKeep-Alive: timeout=%u, max=%u\r\n",
+                  (unsigned)(TL_HTTP_KEEPALIVE_IDLE_MS / 1000), (unsigned)(TL_HTTP_KEEPALIVE_MAX_REQUESTS - c.served));
+  } else {
+    _head.append("Connection: close\r\n");
+  }
+  appendPolicyHeaders(_head);
+  _head.append(_pendingHeaders.c_str(), _pendingHeaders.length());
+  _head.append("\r\n");
+  _pendingHeaders.clear();
+  setHead(c, _head.c_str(), _head.length());
+  if (c.method == HTTP_HEAD) c.outLen = 0;   // the GET's length, none of its bytes
+  c.headOff = c.outOff = 0;
+  c.writing = true;
+}
+
+void HttpServer::send(int code, const char* contentType, const char* content) {
+  send(code, contentType, content, content ? strlen(content) : 0);
+}
+
+void HttpServer::send(int code, const char* contentType, const char* content, size_t len) {
+  if (!_cur || _cur->writing) return;
+  Conn& c = *_cur;
+  const char* out = content;
+  if (len && !_arena.owns(content)) {
+    void* d = _arena.copy(content, len);
+    if (!d && (d = malloc(len))) { memcpy(d, content, len); c.heap[1] = (char*)d; }
+    if (!d) { log_e("http: no memory for %u byte response", (unsigned)len); len = 0; }
+    out = (const char*)d;
+  }
+  c.out = out; c.outLen = len;
+  beginResponse(code, contentType, len);
+}
+
+void HttpServer::send_P(int code, const char* contentType, PGM_P content) {
+  if (!_cur || _cur->writing) return;
+  _cur->out = content; _cur->outLen = strlen_P(content);   // flash is memory mapped: send in place
+  beginResponse(code, contentType, _cur->outLen);
+}
+
+void HttpServer::sendFrame(int code, const char* contentType, SharedFrame* frame) {
+  if (!_cur || _cur->writing) { frame->unref(); return; }
+  _cur->frame = frame;
+  _cur->out = frame->json(); _cur->outLen = frame->jsonLen;
+  beginResponse(code, contentType, _cur->outLen);
+}
+
+void HttpServer::beginStream(SharedFrame* first, uint8_t channel) {
+  if (!_cur || _cur->writing || channel >= kChannels) { if (first) first->unref(); return; }
+  Conn& c = *_cur;
+  const bool headOnly = c.method == HTTP_HEAD;
+  if (headOnly) { if (first) first->unref(); first = nullptr; c.keepAlive = false; }
+  _head.clear();
+  _head.append("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n");
+  if (headOnly) _head.append("Connection: close\r\n");
+  appendPolicyHeaders(_head);
+  _head.append(_pendingHeaders.c_str(), _pendingHeaders.length());
+  _head.append("\r\n");
+  _pendingHeaders.clear();
+  setHead(c, _head.c_str(), _head.length());
+  c.out = nullptr; c.outLen = 0; c.headOff = c.outOff = 0;
+  c.writing = true;
+  if (headOnly) return;
+  c.streaming = true; c.channel = channel;
+  c.pending = first;   // sent right after the head
+  _stats.subscribers++;
+}
+
+// ---------------- Frame fan-out ----------------
+void HttpServer::broadcast(SharedFrame* frame, uint8_t channel) {
+  if (channel >= kChannels) { frame->unref(); return; }
+  _bcast[channel].publish(frame);
+  wake();
+}
+
+void HttpServer::wake() {
+  if (_wakeFd < 0) return;
+  struct sockaddr_in wa = {};
+  wa.sin_family = AF_INET;
+  wa.sin_port = htons(_wakePort);
+  wa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const uint8_t b = 1;
+  sendto(_wakeFd, &b, 1, 0, (struct sockaddr*)&wa, sizeof(wa));
+}
+
+void HttpServer::startFrame(Conn& c, SharedFrame* f) {
+  c.frame = f;
+  c.lastIoMs = millis();   // stall clock starts with the frame, not at the previous one
+  c.head = nullptr; c.headLen = c.headOff = 0;
+  c.out = f->sse(); c.outLen = f->sseLen(); c.outOff = 0;
+  c.writing = true;
+}
+
+// Hands the newest frame of each channel to its subscribers; a subscriber
+// still writing an older frame gets it queued, replacing any frame it has not
+// started yet. A queued keyframe stays: the non-key frame is dropped instead,
+// since it would be undecodable without it.
+void HttpServer::fanOut() {
+  for (uint8_t ch = 0; ch < kChannels; ++ch) {
+    SharedFrame* f = _bcast[ch].take();
+    if (!f) continue;
+    for (int i = 0; i < TL_HTTP_MAX_CLIENTS; ++i) {
+      Conn& c = _conns[i];
+      if (c.fd < 0 || !c.streaming || c.channel != ch) continue;
+      if (c.writing) {
+        _stats.streamSkips += c.pending ? 1 : 0;
+        if (c.pending && c.pending->keyframe && !f->keyframe) { _stats.keyHolds++; continue; }
+        if (c.pending) c.pending->unref();
+        f->ref();
+        c.pending = f;
+      } else {
+        f->ref();
+        startFrame(c, f);
+        onWritable(c);
+      }
+    }
+    f->unref();
+  }
+}
+
+// ---------------- Server task ----------------
+void HttpServer::taskEntry(void* arg) { static_cast<HttpServer*>(arg)->run(); }
+
+void HttpServer::run() {
+  for (;;) {
+    fd_set rd, wr; FD_ZERO(&rd); FD_ZERO(&wr);
+    int maxFd = -1, freeSlots = 0;
+    for (int i = 0; i < TL_HTTP_MAX_CLIENTS; ++i) {
+      Conn& c = _conns[i];
+      if (c.fd < 0) { ++freeSlots; continue; }
+      FD_SET(c.fd, c.writing ? &wr : &rd);
+      if (c.fd > maxFd) maxFd = c.fd;
+    }
+    // With every slot busy, new clients wait in the listen backlog
+    if (freeSlots > 0) { FD_SET(_listenFd, &rd); if (_listenFd > maxFd) maxFd = _listenFd; }
+    FD_SET(_wakeFd, &rd); if (_wakeFd > maxFd) maxFd = _wakeFd;
+
+    struct timeval tv = { 0, 100 * 1000 };
+    int n = select(maxFd + 1, &rd, &wr, nullptr, &tv);
+    if (n < 0) { vTaskDelay(pdMS_TO_TICKS(10)); continue; }
+    const uint32_t workStart = micros();
+
+    if (n > 0 && FD_ISSET(_wakeFd, &rd)) {
+      uint8_t drain[16];
+      while (recv(_wakeFd, drain, sizeof(drain), 0) > 0) {}
+    }
+    fanOut();
+    if (n > 0 && FD_ISSET(_listenFd, &rd)) acceptClients();
+
+    for (int i = 0; i < TL_HTTP_MAX_CLIENTS; ++i) {
+      Conn& c = _conns[i];
+      if (c.fd < 0) continue;
+      if (n > 0 && FD_ISSET(c.fd, &rd)) onReadable(c);
+      else if (n > 0 && FD_ISSET(c.fd, &wr)) { onWritable(c); serve(c); }
+      if (c.fd < 0) continue;
+      // lastIoMs moves only with bytes transferred, so a socket that keeps
+      // reporting ready without progress still runs out its allowance
+      const uint32_t idle = millis() - c.lastIoMs;
+      if (c.streaming) {
+        // A subscriber waits between frames for as long as it likes, but not on a frame
+        if (c.writing && idle > TL_HTTP_STREAM_STALL_MS) { _stats.streamStalls++; closeConn(c); }
+        continue;
+      }
+      // Between requests a persistent connection gets the longer keep-alive allowance
+      const bool between = c.served > 0 && c.rxLen == 0;
+      if (idle > (between ? TL_HTTP_KEEPALIVE_IDLE_MS : TL_HTTP_IDLE_TIMEOUT_MS)) {
+        if (between) _stats.kaIdleClosed++; else _stats.timeouts++;
+        closeConn(c);
+      }
+    }
+    _load.add(micros() - workStart);
+  }
+}
+
+void HttpServer::acceptClients() {
+  for (int i = 0; i < TL_HTTP_MAX_CLIENTS; ++i) {
+    Conn& c = _conns[i];
+    if (c.fd >= 0) continue;
+    int fd = accept(_listenFd, nullptr, nullptr);
+    if (fd < 0) return;   // backlog drained
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1; setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c.fd = fd; c.writing = false; c.rxLen = 0; c.served = 0; c.lastIoMs = millis();
+    _stats.accepted++;
+    if (++_stats.active > _stats.peakActive) _stats.peakActive = _stats.active;
+  }
+}
+
+void HttpServer::closeConn(Conn& c) {
+  if (c.fd < 0) return;
+  if (c.uploading) uploadEvent(c, Upload::ABORTED, nullptr, 0);
+  close(c.fd);
+  if (c.streaming && _stats.subscribers) _stats.subscribers--;
+  endResponse(c);
+  if (c.pending) { c.pending->unref(); c.pending = nullptr; }
+  c.fd = -1; c.writing = false; c.streaming = false; c.channel = 0; c.keepAlive = false; c.rxLen = 0;
+  if (_stats.active) _stats.active--;
+}
+
+// Drops everything the finished (or abandoned) response held
+void HttpServer::endResponse(Conn& c) {
+  if (c.frame) { c.frame->unref(); c.frame = nullptr; }
+  free(c.heap[0]); free(c.heap[1]); c.heap[0] = c.heap[1] = nullptr;
+  c.head = nullptr; c.headLen = c.headOff = 0;
+  c.out = nullptr; c.outLen = c.outOff = 0;
+}
+
+// The arena is reset for the next request: a response still being written
+// keeps only its unsent bytes, moved to the heap
+void HttpServer::detach(Conn& c) {
+  if (c.fd < 0 || !c.writing) return;
+  const bool headIn = _arena.owns(c.head), bodyIn = _arena.owns(c.out);
+  if (!headIn && !bodyIn) return;
+  _stats.arenaSpills++;
+  auto move = [&](const char*& p, size_t& len, size_t& off, char*& owned) {
+    const size_t rest = len - off;
+    owned = rest ? (char*)malloc(rest) : nullptr;
+    if (rest && !owned) return false;
+    if (rest) memcpy(owned, p + off, rest);
+    p = owned; len = rest; off = 0;
+    return true;
+  };
+  if ((headIn && !move(c.head, c.headLen, c.headOff, c.heap[0])) ||
+      (bodyIn && !move(c.out, c.outLen, c.outOff, c.heap[1]))) {
+    log_e("http: no memory to keep a pending response");
+    closeConn(c);
+  }
+}
+
+void HttpServer::onReadable(Conn& c) {
+  if (c.streaming) {
+    // Subscribers only listen; anything they send is discarded, EOF closes
+    char sink[64];
+    int r = recv(c.fd, sink, sizeof(sink), 0);
+    if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) closeConn(c);
+    return;
+  }
+  if (c.uploading) {
+    size_t room = TL_HTTP_RX_BUF - c.reqLen;
+    if (room > c.upTotal - c.upGot) room = c.upTotal - c.upGot;
+    int r = recv(c.fd, c.rx + c.reqLen, room, 0);
+    if (r <= 0) {
+      if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      closeConn(c); return;
+    }
+    c.rxLen = c.reqLen + r; c.lastIoMs = millis();
+    onUploadData(c);
+    return;
+  }
+  if (c.rxLen >= TL_HTTP_RX_BUF) { _stats.badRequests++; closeConn(c); return; }
+  int r = recv(c.fd, c.rx + c.rxLen, TL_HTTP_RX_BUF - c.rxLen, 0);
+  if (r <= 0) {
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    closeConn(c); return;
+  }
+  if (c.rxLen == 0) c.reqStartUs = nowUs();
+  c.rxLen += r; c.lastIoMs = millis();
+  serve(c);
+}
+
+// Answers every complete request buffered on c, in order, until a response
+// has to wait for the socket or the connection closes.
+void HttpServer::serve(Conn& c) {
+  while (c.fd >= 0 && !c.writing && !c.streaming && !c.uploading && parseRequest(c)) {
+    dispatch(c);
+    onWritable(c);
+    detach(c);
+  }
+}
+
+// Returns true once a complete request sits in rx; answers 4xx itself for bad input.
+bool HttpServer::parseRequest(Conn& c) {
+  auto reject = [&](int code, const char* msg) {
+    _cur = &c; _route = nullptr; c.keepAlive = false; _stats.badRequests++;
+    _pendingHeaders.clear(); _arena.reset();
+    send(code, "text/plain", msg); _cur = nullptr; onWritable(c); detach(c);
+    return false;
+  };
+  if (c.rxLen == 0) return false;
+  c.rx[c.rxLen] = 0;
+  char* hdrEnd = strstr(c.rx, "\r\n\r\n");
+  if (!hdrEnd) return (c.rxLen >= TL_HTTP_RX_BUF) ? reject(431, "headers too large") : false;
+  const size_t headLen = (hdrEnd - c.rx) + 4;
+
+  size_t contentLen = 0;
+  bool haveLen = false;
+  int connHdr = 0;   // +1 keep-alive, -1 close, 0 absent
+  for (char* h = strstr(c.rx, "\r\n"); h && h < hdrEnd; h = strstr(h + 2, "\r\n")) {
+    if (!strncasecmp(h + 2, "Content-Length:", 15)) {
+      // A second value (even an equal one) is refused rather than guessed at
+      if (haveLen || !parseLength(h + 17, strstr(h + 2, "\r\n"), contentLen)) return reject(400, "bad content-length");
+      haveLen = true;
+    } else if (!strncasecmp(h + 2, "Connection:", 11)) {
+      const char* v = h + 13; while (*v == ' ') ++v;
+      if (!strncasecmp(v, "close", 5)) connHdr = -1;
+      else if (!strncasecmp(v, "keep-alive", 10)) connHdr = 1;
+    }
+  }
+  if (contentLen > 0) {
+    if (const Route* r = uploadRoute(c)) {
+      if (TL_HTTP_RX_BUF - headLen < 256) return reject(431, "headers too large");
+      if (!parseHead(c, hdrEnd, connHdr)) return reject(400, "bad request");
+      beginUpload(c, r, headLen, contentLen);
+      return false;
+    }
+  }
+  if (contentLen > TL_HTTP_RX_BUF - headLen) return reject(413, "body too large");   // headLen <= rxLen: no wrap
+  if (c.rxLen < headLen + contentLen) return false;
+
+  if (!parseHead(c, hdrEnd, connHdr)) return reject(400, "bad request");
+  c.reqLen = headLen + contentLen;
+  // Body is not NUL-terminated: a pipelined request may follow it in rx
+  if (contentLen > 0) { c.body = c.rx + headLen; c.bodyLen = contentLen; }
+  else { c.body = nullptr; c.bodyLen = 0; }
+  return true;
+}
+
+// Request line: METHOD SP target SP version, tokenized in place, then the
+// header lines (NUL-terminated at the blank line)
+bool HttpServer::parseHead(Conn& c, char* hdrEnd, int connHdr) {
+  *hdrEnd = 0;
+  char* lineEnd = strstr(c.rx, "\r\n"); if (lineEnd) *lineEnd = 0;
+  char* sp1 = strchr(c.rx, ' ');
+  char* sp2 = sp1 ? strchr(sp1 + 1, ' ') : nullptr;
+  if (!sp1 || !sp2) return false;
+  *sp1 = 0; *sp2 = 0;
+  if (!parseMethod(c.rx, c.method)) return false;
+  // HTTP/1.1 is persistent unless told otherwise; HTTP/1.0 only on request
+  const bool http11 = !strcmp(sp2 + 1, "HTTP/1.1");
+  c.clientKeepAlive = http11 ? (connHdr >= 0) : (connHdr > 0);
+  c.path = sp1 + 1;
+  char* q = strchr(sp1 + 1, '?');
+  if (q) { *q = 0; c.query = q + 1; } else c.query = nullptr;
+  c.hdrs = lineEnd ? lineEnd + 2 : hdrEnd;
+  return true;
+}
+
+// ---------------- Streamed uploads ----------------
+// ROUTE_UPLOAD route allowing this method, from the untouched request line
+const Route* HttpServer::uploadRoute(const Conn& c) const {
+  if (!_lookup) return nullptr;
+  char method[8], path[48];
+  size_t n = 0;
+  const char* p = c.rx;
+  for (; *p && *p != ' '; ++p) { if (n + 1 >= sizeof(method)) return nullptr; method[n++] = *p; }
+  method[n] = 0;
+  if (*p != ' ') return nullptr;
+  n = 0;
+  for (++p; *p && *p != ' ' && *p != '?' && *p != '\r'; ++p) { if (n + 1 >= sizeof(path)) return nullptr; path[n++] = *p; }
+  path[n] = 0;
+  HTTPMethod m;
+  const Route* r = _lookup(path);
+  if (!r || !(r->flags & ROUTE_UPLOAD) || !r->upload || !parseMethod(method, m)) return nullptr;
+  return (r->methods & methodBit(m)) ? r : nullptr;
+}
+
+void HttpServer::beginUpload(Conn& c, const Route* r, size_t headLen, size_t contentLen) {
+  c.uploading = true; c.upRoute = r;
+  c.upTotal = contentLen; c.upGot = 0;
+  c.reqLen = headLen;
+  c.body = nullptr; c.bodyLen = 0;
+  _stats.uploads++;
+  uploadEvent(c, Upload::START, nullptr, 0);
+  if (!c.uploading) return;
+  // Accepted: a client waiting on "Expect: 100-continue" can send the body now
+  // (a refusal above went out as the final answer instead)
+  const char* v; size_t n;
+  if (c.rxLen == c.reqLen && findHeader(c.hdrs, "Expect", &v, &n) && n >= 12 && !strncasecmp(v, "100-continue", 12)) {
+    static const char k100[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    ::send(c.fd, k100, sizeof(k100) - 1, MSG_DONTWAIT);
+  }
+  onUploadData(c);   // body bytes that came in with the head
+}
+
+// Hands the bytes behind the head to the upload handler and drops them; after
+// the last one, END and then the route handler answers like any request
+void HttpServer::onUploadData(Conn& c) {
+  if (c.rxLen > c.reqLen) {
+    size_t n = c.rxLen - c.reqLen;
+    if (n > c.upTotal - c.upGot) n = c.upTotal - c.upGot;   // a pipelined request is not served after an upload
+    c.upGot += n;
+    uploadEvent(c, Upload::WRITE, (const uint8_t*)c.rx + c.reqLen, n);
+    c.rxLen = c.reqLen;
+  }
+  if (!c.uploading || c.upGot < c.upTotal) return;
+  uploadEvent(c, Upload::END, nullptr, 0);
+  if (!c.uploading) return;
+  c.uploading = false;
+  dispatch(c);
+  onWritable(c);
+  detach(c);
+}
+
+void HttpServer::uploadEvent(Conn& c, Upload::Status status, const uint8_t* buf, size_t len) {
+  _upload.status = status; _upload.buf = buf; _upload.len = len;
+  _upload.received = c.upGot; _upload.total = c.upTotal;
+  if (status == Upload::ABORTED) {
+    _stats.uploadAborts++;
+    c.uploading = false;
+    c.upRoute->upload();
+    return;
+  }
+  _cur = &c; _route = c.upRoute;
+  _pendingHeaders.clear(); _arena.reset();
+  c.keepAlive = false;
+  c.upRoute->upload();
+  _cur = nullptr; _route = nullptr;
+  if (c.writing) {
+    // Refused: the answer goes out and the connection closes, rest of the body unread
+    c.uploading = false;
+    _stats.requests++;
+    onWritable(c);
+    detach(c);
+  }
+}
+
+void HttpServer::dispatch(Conn& c) {
+  _cur = &c;
+  _pendingHeaders.clear();
+  _arena.reset();
+  _stats.requests++;
+
+  const uint32_t c0 = ESP.getCycleCount();
+  const Route* r = _lookup ? _lookup(c.path) : nullptr;
+  _stats.dispatchCycles += ESP.getCycleCount() - c0;
+
+  const bool allowed = r && ((r->methods & methodBit(c.method))
+                              || (c.method == HTTP_HEAD && (r->methods & methodBit(HTTP_GET))));
+  const bool preflight = r && !allowed && c.method == HTTP_OPTIONS && (r->flags & ROUTE_CORS);
+  _route = (allowed || preflight) ? r : nullptr;
+
+  if (c.served > 0) _stats.reused++;
+  c.keepAlive = false;
+  if (_route && (_route->flags & ROUTE_KEEPALIVE) && c.clientKeepAlive) {
+    c.keepAlive = c.served + 1 < TL_HTTP_KEEPALIVE_MAX_REQUESTS;
+    if (!c.keepAlive) _stats.kaMaxClosed++;
+  }
+
+  if (allowed) r->handler();
+  else if (preflight) { _stats.preflights++; send(204); }
+  else { _stats.notFound++; if (_notFound) _notFound(); }
+
+  if (!c.writing) send(500, "text/plain", "no response");
+  _cur = nullptr; _route = nullptr;
+}
+
+void HttpServer::onWritable(Conn& c) {
+  if (c.fd < 0 || !c.writing) return;
+  // A zero-byte send is no progress, like EAGAIN: wait for select() again
+  while (c.headOff < c.headLen) {
+    int w = ::send(c.fd, c.head + c.headOff, c.headLen - c.headOff, MSG_DONTWAIT);
+    if (w <= 0) { if (w == 0 || errno == EAGAIN || errno == EWOULDBLOCK) return; closeConn(c); return; }
+    c.headOff += w; c.lastIoMs = millis();
+  }
+  while (c.outOff < c.outLen) {
+    int w = ::send(c.fd, c.out + c.outOff, c.outLen - c.outOff, MSG_DONTWAIT);
+    if (w <= 0) { if (w == 0 || errno == EAGAIN || errno == EWOULDBLOCK) return; closeConn(c); return; }
+    c.outOff += w; c.lastIoMs = millis();
+  }
+
+  if (c.streaming) {
+    // Stream head or a frame is out; move on to the queued frame, if any
+    if (c.frame) _stats.streamFrames++;
+    endResponse(c);
+    c.writing = false;
+    if (c.pending) { SharedFrame* f = c.pending; c.pending = nullptr; startFrame(c, f); onWritable(c); }
+    return;
+  }
+
+  const uint32_t us = nowUs() - c.reqStartUs;
+  _stats.lastUs = us; _stats.sumUs += us;
+  if (us > _stats.maxUs) _stats.maxUs = us;
+  if (!c.keepAlive) { closeConn(c); return; }
+
+  // Persistent: drop the answered request, keep any pipelined bytes behind it
+  c.served++;
+  c.writing = false;
+  endResponse(c);
+  const size_t rest = c.rxLen - c.reqLen;
+  memmove(c.rx, c.rx + c.reqLen, rest);
+  c.rxLen = rest;
+  if (rest) { _stats.pipelined++; c.reqStartUs = nowUs(); }
+}
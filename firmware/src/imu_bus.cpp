@@ -0,0 +1,139 @@
+// imu_bus.cpp : see imu_bus.h
+
+#include "imu_bus.h"
+
+#include <MPU6050_light.h>
+
+static constexpr uint8_t REG_SMPLRT_DIV   = 0x19;
+static constexpr uint8_t REG_CONFIG       = 0x1A;   // DLPF_CFG in bits 2:0
+static constexpr uint8_t REG_GYRO_CONFIG  = 0x1B;
+static constexpr uint8_t REG_ACCEL_CONFIG = 0x1C;
+static constexpr uint8_t REG_ACCEL_XOUT_H = 0x3B;   // 14 bytes: accel xyz, temp, gyro xyz
+static constexpr size_t  BURST_LEN = 14;
+
+static const uint8_t kAddrs[] = TL_IMU_ADDRS;
+static_assert(sizeof(kAddrs) == TL_IMU_MAX, "TL_IMU_ADDRS must list TL_IMU_MAX addresses");
+
+uint8_t ImuBus::begin() {
+  _found = 0;
+  for (uint8_t i = 0; i < TL_IMU_MAX; ++i) {
+    Device& d = _dev[i];
+    d.addr = kAddrs[i];
+    _wire.beginTransmission(d.addr);
+    if (_wire.endTransmission() != 0) { d.present = false; continue; }
+
+    // Library bring-up: wake, clock source, +-250 dps, +-2 g
+    MPU6050 mpu(_wire);
+    mpu.setAddress(d.addr);
+    if (mpu.begin(0, 0) != 0) { log_e("IMU 0x%02x: begin failed", d.addr); continue; }
+    readScales(d);
+    d.present = true;
+    ++_found;
+  }
+  return _found;
+}
+
+bool ImuBus::readScales(Device& d) {
+  uint8_t cfg = 0;
+  bool ok = true;
+  if (readReg(d.addr, REG_GYRO_CONFIG, &cfg, 1)) {
+    static const float gyro[4] = { 131.0f, 65.5f, 32.8f, 16.4f };
+    d.gyroLsbPerDps = gyro[(cfg >> 3) & 0x03];
+  } else ok = false;
+  if (readReg(d.addr, REG_ACCEL_CONFIG, &cfg, 1)) {
+    static const float acc[4] = { 16384.0f, 8192.0f, 4096.0f, 2048.0f };
+    d.accLsbPerG = acc[(cfg >> 3) & 0x03];
+  } else ok = false;
+  foldTrim(d);
+  return ok;
+}
+
+bool ImuBus::configure(uint8_t dlpf, uint8_t smplrtDiv, uint8_t gyroRange, uint8_t accRange, uint32_t settleMs) {
+  bool all = true;
+  for (Device& d : _dev) {
+    if (!d.present) continue;
+    MPU6050 mpu(_wire);
+    mpu.setAddress(d.addr);
+    const bool ok = mpu.writeData(REG_CONFIG, dlpf & 0x07) == 0
+                 && mpu.writeData(REG_SMPLRT_DIV, smplrtDiv) == 0
+                 && mpu.setGyroConfig(gyroRange) == 0
+                 && mpu.setAccConfig(accRange) == 0;
+    // Scales follow whatever the registers now hold, even after a partial write
+    if (!readScales(d) || !ok) { log_e("IMU 0x%02x: configure failed", d.addr); all = false; }
+    d.settleUntilUs = micros() + settleMs * 1000;
+    d.settling = true;
+  }
+  return all;
+}
+
+void ImuBus::foldTrim(Device& d) {
+  const AccelTrim& t = d.trim;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) d.accGain[3 * r + c] = t.m[3 * r + c] / d.accLsbPerG;
+    d.accOffset[r] = t.m[3 * r] * t.b[0] + t.m[3 * r + 1] * t.b[1] + t.m[3 * r + 2] * t.b[2];
+  }
+}
+
+void ImuBus::setAccelTrim(uint8_t i, const AccelTrim& t) {
+  if (i >= TL_IMU_MAX) return;
+  _dev[i].trim = t;
+  foldTrim(_dev[i]);
+}
+
+bool ImuBus::readReg(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len) {
+  _wire.beginTransmission(addr);
+  _wire.write(reg);
+  if (_wire.endTransmission(false) != 0) return false;
+  if (_wire.requestFrom(addr, (uint8_t)len) != len) return false;
+  for (size_t i = 0; i < len; ++i) buf[i] = (uint8_t)_wire.read();
+  return true;
+}
+
+bool ImuBus::burst(Device& d) {
+  if (d.settling) {
+    if ((int32_t)(micros() - d.settleUntilUs) < 0) { d.sample.ok = false; return false; }
+    d.settling = false;
+  }
+  uint8_t b[BURST_LEN];
+  const uint32_t t0 = micros();
+  const bool ok = readReg(d.addr, REG_ACCEL_XOUT_H, b, BURST_LEN);
+  const uint32_t dt = micros() - t0;
+
+  d.reads++;
+  d.lastReadUs = dt;
+  if (dt > d.maxReadUs) d.maxReadUs = dt;
+  d.sample.us = t0;
+  d.sample.ok = ok;
+  if (!ok) { d.errors++; return false; }
+
+  static const uint8_t offs[6] = { 0, 2, 4, 8, 10, 12 };   // skip temperature
+  int16_t* raw = d.sample.raw;
+  for (int i = 0; i < 6; ++i) raw[i] = (int16_t)((b[offs[i]] << 8) | b[offs[i] + 1]);
+  const float* g = d.accGain;
+  const float x = raw[0], y = raw[1], z = raw[2];
+  d.sample.ax = g[0] * x + g[1] * y + g[2] * z - d.accOffset[0];
+  d.sample.ay = g[3] * x + g[4] * y + g[5] * z - d.accOffset[1];
+  d.sample.az = g[6] * x + g[7] * y + g[8] * z - d.accOffset[2];
+  d.sample.gx = raw[3] / d.gyroLsbPerDps;
+  d.sample.gy = raw[4] / d.gyroLsbPerDps;
+  d.sample.gz = raw[5] / d.gyroLsbPerDps;
+  return true;
+}
+
+void ImuBus::acquire() {
+  const uint32_t t0 = micros();
+  bool first = true;
+  uint32_t firstUs = 0;
+  for (Device& d : _dev) {
+    if (!d.present) continue;
+    burst(d);
+    if (first) { firstUs = d.sample.us; first = false; }
+    d.skewUs = d.sample.us - firstUs;
+  }
+  _lastCycleUs = micros() - t0;
+  if (_lastCycleUs > _maxCycleUs) _maxCycleUs = _lastCycleUs;
+}
+
+bool ImuBus::readOne(uint8_t i) {
+  return present(i) && burst(_dev[i]);
+}
@@ -1,22 +1,71 @@
 // main.cpp : ESP32 (ESP32-S3/C3) + MPU-6050/6500 + Wi-Fi AP + HTTP UI + Captive Portal
-// - Wildcard DNS to AP IP
-// - Global HTTP 302 to http://<TL_DOMAIN><TL_WEB_UI_PATH> for all paths and 404s
+// - Event-driven multi-connection HTTP server in its own task (http_server.h)
+// - One or two IMUs (0x68/0x69) on the shared I2C bus, read back to back on
+//   every sample tick, each with its own basis and calibration (imu_bus.h)
+// - Windowed FFT of lateral accel and roll/yaw rate: /spectrum and a dominant
+//   sway frequency/amplitude in every frame (spectrum.h)
+// - Always-on sway alert from a streaming Goertzel bank, state in every frame,
+//   timestamped log and thresholds on /sway (sway_detector.h)
+// - PSRAM flight recorder: raw samples of every IMU in a ring, a window
+//   around each accel/sway/manual trigger downloadable from /recorder/capture
+//   (flight_recorder.h)
+// - Guided multi-orientation accel calibration (offset, scale, cross-axis)
+//   solved from streamed normal-equation sums, applied per burst (accel_cal.h)
+// - Authenticated OTA: /update streams the image into the inactive slot,
+//   MD5-checked, confirmed after a healthy run or rolled back (ota_update.h)
+// - Fixed-rate sampling; each frame is serialized once and fanned out to
+//   /sensor polls and /stream (SSE) subscribers (shared_frame.h)
+// - Everything derived in a tick is published as one snapshot through a
+//   seqlock: frames, multicast and handlers read a consistent copy without a
+//   lock and the sense task never waits for them (seqlock.h)
+// - Presence-driven power policy: CPU clock, publish rate and loop() cadence
+//   drop while nobody is connected; sampling rate never changes (power_policy.h)
+// - Acquisition profiles ("general", "parked", "towing" on /profile): MPU
+//   filter and ranges plus the derived time constants and rates, switched
+//   between two ticks and persisted (acq_profile.h)
+// - Tasks: "sense" pinned to TL_SENSE_CORE; "http", "dns", loop() (housekeeping)
+//   and Wi-Fi on TL_NET_CORE; per-task CPU and stack in /diag (task_load.h)
+// - Optional station mode joins the vehicle's Wi-Fi next to the AP and
+//   multicasts compact binary frames there (mcast_telemetry.h)
+// - Wildcard DNS to AP IP from its own event-driven, rate-limited task (captive_dns.h)
+// - Global HTTP 302 to http://<TL_DOMAIN><TL_WEB_UI_PATH> for all paths and 404s;
+//   request paths build in a per-request arena and fixed strings, no heap churn
 // - mDNS publishes _http._tcp
 // - NO HTTPS (removed)
 
 #include <Arduino.h>
 #include <Wire.h>
-#include <MPU6050_light.h>
 #include <WiFi.h>
-#include <WebServer.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
-#include <DNSServer.h>
 #include <ESPmDNS.h>
+#include <esp_timer.h>
 
 #include "config.h"
+#include "accel_cal.h"
+#include "acq_profile.h"
+#include "captive_dns.h"
+#include "fixed_string.h"
+#include "flight_recorder.h"
+#include "http_server.h"
+#include "imu_bus.h"
+#include "frame_delta.h"
+#include "mcast_telemetry.h"
+#include "ota_update.h"
+#include "power_policy.h"
+#include "seqlock.h"
+#include "spectrum.h"
+#include "stream_fields.h"
+#include "sway_detector.h"
+#include "task_load.h"
 #include "web_ui.h"
 
+#if defined(ARDUINO_RUNNING_CORE) && ARDUINO_RUNNING_CORE != TL_NET_CORE
+#warning "ARDUINO_RUNNING_CORE should match TL_NET_CORE: loop() restarts the AP"
+#endif
+
+SET_LOOP_TASK_STACK_SIZE(TL_LOOP_TASK_STACK);
+
 // -------- Debug macros --------
 #ifdef DEBUG_SERIAL
   #define DEBUG_PRINT(x)   Serial.print(x)
@@ -27,18 +76,39 @@
 #endif
 
 // -------- Devices --------
-static constexpr uint8_t MPU_ADDR = 0x68; // change to 0x69 if AD0=HIGH
-MPU6050 mpu(Wire);
-WebServer server(TL_HTTP_PORT);
+ImuBus imuBus(Wire);   // TL_IMU_ADDRS; slot 0 is the primary
+HttpServer server(TL_HTTP_PORT);
+McastTelemetry mcast;
+SpectrumAnalyzer spectrum;   // owned by the sense task; /spectrum reads under its lock
+SwayDetector swayAlert;      // fed by the sense task under StateLock
+FlightRecorder recorder;     // written by the sense task, frozen by loop()
+PowerPolicy power;           // evaluated and applied by loop()
+AccelCalibrator accelCal;    // fed by the sense task while a pose is captured
+OtaUpdate ota;               // written from the HTTP task, confirmed/rebooted by loop()
 Preferences prefs;
 
 // -------- Captive portal DNS --------
-DNSServer dnsServer;
+CaptiveDns dnsServer;
 IPAddress apIP;
 
+// -------- Shared state lock --------
+// HTTP handlers run on the server task while the sense task polls the IMU;
+// both take this lock around IMU access, calibration and basis. What a tick
+// derives from them is published through g_state instead (see SensorState).
+static SemaphoreHandle_t g_stateMutex = nullptr;
+struct StateLock {
+  StateLock()  { xSemaphoreTake(g_stateMutex, portMAX_DELAY); }
+  ~StateLock() { xSemaphoreGive(g_stateMutex); }
+};
+
 // -------- Wi-Fi pending reconfig (global) --------
-struct WifiPending { bool apply; String ssid; String password; uint32_t at_ms; };
-static WifiPending g_wifiPending = { false, String(), String(), 0 };
+struct WifiPending { bool apply = false; FixedString<32> ssid; FixedString<63> password; uint32_t at_ms = 0; };
+static WifiPending g_wifiPending;
+
+// -------- Station mode (optional, multicast telemetry) --------
+struct StationConfig { bool enabled = false; FixedString<32> ssid; FixedString<63> password; };
+static StationConfig g_sta;
+static bool g_staPending = false;   // /station changed the link: loop() re-applies
 
 // -------- Math helpers / basis --------
 static inline float dot3(const float a[3], const float b[3]) { return a[0]*b[0]+a[1]*b[1]+a[2]*b[2]; }
@@ -56,60 +126,89 @@ static const float AX_X[3] = {1,0,0}, AX_Y[3] = {0,1,0};
 
 struct OrientBasis {
   float fwd[3]; float rgt[3]; float up[3]; bool valid=false;
-} g_basis;
-
-static String g_forwardHint = "+X"; // allowed: +X, -X, +Y, -Y
-
-static void buildBasisFromUpAndHint(const float up_s[3]){
+};
+
+// Per-IMU mounting, calibration and pose; every device has its own basis and zeros
+struct ImuChannel {
+  OrientBasis basis;
+  FixedString<2> forwardHint = "+X"; // allowed: +X, -X, +Y, -Y
+  float pitch_zero=0, roll_zero=0;
+  float g_mag = TL_GRAVITY_G_DEFAULT;
+  float pitch_raw=0, roll_raw=0;
+  float pitch=0, roll=0;             // calibrated
+  float pitch_avg=0, roll_avg=0;     // EMA (display only)
+  uint32_t lastAvgMs=0; bool avgInit=false;
+};
+static ImuChannel g_imu[TL_IMU_MAX];
+
+static void buildBasisFromUpAndHint(ImuChannel& ch, const float up_s[3]){
   float up[3] = { up_s[0], up_s[1], up_s[2] };
   normalize3(up);
-  const float* base = (g_forwardHint.indexOf('Y')>=0 ? AX_Y : AX_X);
-  float sign = (g_forwardHint.startsWith("-") ? -1.0f : 1.0f);
+  const float* base = (ch.forwardHint[1]=='Y' ? AX_Y : AX_X);
+  float sign = (ch.forwardHint[0]=='-' ? -1.0f : 1.0f);
   float cand[3] = { base[0]*sign, base[1]*sign, base[2]*sign };
 
   float fwd[3]; projOntoPlane(cand, up, fwd);
   float rgt[3]; cross3(fwd, up, rgt); normalize3(rgt);
   float tmp[3]; cross3(up, rgt, tmp); normalize3(tmp);
-  memcpy(g_basis.fwd, tmp, sizeof(tmp));
-  memcpy(g_basis.rgt, rgt, sizeof(rgt));
-  memcpy(g_basis.up,  up,  sizeof(up));
-  g_basis.valid = true;
+  memcpy(ch.basis.fwd, tmp, sizeof(tmp));
+  memcpy(ch.basis.rgt, rgt, sizeof(rgt));
+  memcpy(ch.basis.up,  up,  sizeof(up));
+  ch.basis.valid = true;
 }
 
-static void toTrailer(float sx, float sy, float sz, float& fwd, float& rgt, float& up){
-  if (!g_basis.valid) { fwd = rgt = up = 0; return; }
+static void toTrailer(const ImuChannel& ch, float sx, float sy, float sz, float& fwd, float& rgt, float& up){
+  if (!ch.basis.valid) { fwd = rgt = up = 0; return; }
   const float v[3] = { sx, sy, sz };
-  fwd = dot3(v, g_basis.fwd);
-  rgt = dot3(v, g_basis.rgt);
-  up  = dot3(v, g_basis.up);
+  fwd = dot3(v, ch.basis.fwd);
+  rgt = dot3(v, ch.basis.rgt);
+  up  = dot3(v, ch.basis.up);
 }
 
-// -------- Pose/accel/gyro, zeros & EMA --------
-static float pos_pitch_raw=0, pos_roll_raw=0;
-static float pos_pitch_calibrated=0, pos_roll_calibrated=0;
-static float pos_pitch_zero=0, pos_roll_zero=0;
-
-static float accel_x_raw=0, accel_y_raw=0, accel_z_raw=0;
-static float gyro_x_raw=0,  gyro_y_raw=0,  gyro_z_raw=0;
-
-static float accel_forward=0, accel_backward=0;
-static float accel_right=0,  accel_left=0;
-static float accel_up=0,     accel_down=0;
-
-static float gyro_pitchup=0,  gyro_pitchdown=0;
-static float gyro_rollright=0, gyro_rollleft=0;
-static float gyro_turnright=0, gyro_turnleft=0;
-
-static float pos_pitch_avg=0, pos_roll_avg=0;
-static uint32_t lastAvgMs=0; static bool avgInit=false;
-
-static float g_mag = TL_GRAVITY_G_DEFAULT;
-static float g_fwd_sub=0, g_rgt_sub=0, g_up_sub=0;
-
+// -------- Published sensor state --------
+// Everything one tick derives, as one POD. The sense task fills g_derived
+// (its own, never shared) and publishes it through g_state at the end of the
+// tick; frames, multicast packets and handlers copy it from there without a
+// lock, so nothing they report mixes two ticks.
 struct Peak4 { float up=0, down=0, left=0, right=0; };
-static Peak4 g_accelPeak, g_rollPeak;
+struct AxleState {
+  float pitch_raw=0, roll_raw=0;     // deg, before the zeros
+  float pitch=0, roll=0;             // calibrated
+  float pitch_avg=0, roll_avg=0;     // EMA (display only)
+  bool present=false;
+  bool ok=false;                     // fresh sample this tick; false: stale, the angles above are the last good ones
+};
+struct SensorState {
+  uint32_t tick=0, ms=0;             // sense ticks since boot, millis() of the sample
+  int64_t us=0;                      // esp_timer at the end of the burst (/time clock)
+  AxleState axle[TL_IMU_MAX];
+  // Primary IMU
+  float accel_raw[3] = {0,0,0};      // sensor frame, g
+  float gyro_raw[3]  = {0,0,0};      // sensor frame, deg/s
+  float accel_fwd=0, accel_right=0, accel_up=0;   // trailer frame, gravity removed, deadbanded (g)
+  float grav_fwd=0, grav_right=0, grav_up=0;      // the gravity estimate removed (g)
+  float rate_pitch=0, rate_roll=0, rate_turn=0;   // deg/s; pitch up, roll right, turn right positive
+  uint16_t avgTauMs=TL_LEVEL_AVG_TAU_MS;          // EMA behind the _avg angles (profile)
+  Peak4 accelPeak, rollPeak;
+  SpectrumAnalyzer::Peak sway;
+  SwayDetector::State swayAlert;
+};
+static SensorState g_derived;              // sense task only
+static SeqLock<SensorState> g_state;       // latest published g_derived
+static volatile bool g_peakReset = false;  // handlers ask, the sense task clears the peaks
+// g_state.write() cost for /diag: the sense task keeps the 64-bit sum and
+// publishes the average, so the handler reads two 32-bit words, never a torn sum
+static volatile uint32_t g_stateWriteAvgCycles = 0;
+static volatile uint32_t g_stateWriteMaxCycles = 0;
 static uint32_t accelPeakLastMs=0, rollPeakLastMs=0;
 
+// -------- Acquisition profile --------
+// Set by setup() and /profile, read by the sense task; both under StateLock,
+// so a tick runs entirely on one profile
+static AcqProfile g_acq = kAcqPresets[0];
+static uint32_t g_acqSwitches = 0;        // taken through /profile since boot, for /diag
+static bool g_acqPending = false;         // /profile changed the publish rate: loop() hands it to the power policy
+
 static void updatePeak(Peak4& peak, const Peak4& nowvals, uint32_t& lastMs, float tau_ms){
   uint32_t now = millis();
   if (lastMs == 0) { peak = nowvals; lastMs = now; return; }
@@ -126,342 +225,799 @@ static void updatePeak(Peak4& peak, const Peak4& nowvals, uint32_t& lastMs, floa
   lastMs = now;
 }
 
-// ---------------- Low-level I2C helpers ----------------
-static bool i2cRead(uint8_t dev, uint8_t reg, uint8_t* buf, size_t len) {
-  Wire.beginTransmission(dev);
-  Wire.write(reg);
-  if (Wire.endTransmission(false) != 0) return false;
-  size_t n = Wire.requestFrom(dev, (uint8_t)len);
-  if (n != len) return false;
-  for (size_t i=0;i<len;++i) buf[i]=Wire.read();
-  return true;
-}
-static bool readGyroRawRegs(int16_t& rx, int16_t& ry, int16_t& rz) {
-  uint8_t b[6];
-  if (!i2cRead(MPU_ADDR, 0x43, b, 6)) return false;
-  rx = (int16_t)((b[0]<<8)|b[1]); ry=(int16_t)((b[2]<<8)|b[3]); rz=(int16_t)((b[4]<<8)|b[5]);
-  return true;
-}
-static float gyroLSBperDPS() {
-  uint8_t cfg=0; if (!i2cRead(MPU_ADDR, 0x1B, &cfg, 1)) return 131.0f;
-  switch ((cfg>>3)&0x03) { case 0: return 131.0f; case 1: return 65.5f; case 2: return 32.8f; case 3: return 16.4f; }
-  return 131.0f;
-}
-
 // ---------------- Preferences (basis + calibration) ----------------
-static void saveBasis(const float up_s[3]){
-  prefs.begin("ori2", false);
+// Slot 0 keeps the original namespaces so existing units retain their setup.
+// The savers read only what handlers write (basis, hint, zeros, g_mag), so
+// handlers call them after releasing StateLock: a flash write can take tens of
+// ms and the sense task would wait for it
+static const char* basisNs(uint8_t i){ return i ? "ori2_1" : "ori2"; }
+static const char* calNs(uint8_t i)  { return i ? "imu_1"  : "imu"; }
+
+static void saveBasis(uint8_t i, const float up_s[3]){
+  const ImuChannel& ch = g_imu[i];
+  prefs.begin(basisNs(i), false);
   prefs.putFloat("upx", up_s[0]); prefs.putFloat("upy", up_s[1]); prefs.putFloat("upz", up_s[2]);
-  prefs.putString("hint", g_forwardHint);
-  prefs.putFloat("fx", g_basis.fwd[0]); prefs.putFloat("fy", g_basis.fwd[1]); prefs.putFloat("fz", g_basis.fwd[2]);
-  prefs.putFloat("rx", g_basis.rgt[0]); prefs.putFloat("ry", g_basis.rgt[1]); prefs.putFloat("rz", g_basis.rgt[2]);
-  prefs.putFloat("ux", g_basis.up[0]);  prefs.putFloat("uy", g_basis.up[1]);  prefs.putFloat("uz", g_basis.up[2]);
+  prefs.putString("hint", ch.forwardHint.c_str());
+  prefs.putFloat("fx", ch.basis.fwd[0]); prefs.putFloat("fy", ch.basis.fwd[1]); prefs.putFloat("fz", ch.basis.fwd[2]);
+  prefs.putFloat("rx", ch.basis.rgt[0]); prefs.putFloat("ry", ch.basis.rgt[1]); prefs.putFloat("rz", ch.basis.rgt[2]);
+  prefs.putFloat("ux", ch.basis.up[0]);  prefs.putFloat("uy", ch.basis.up[1]);  prefs.putFloat("uz", ch.basis.up[2]);
   prefs.end();
 }
-static bool loadBasis(float up_out[3]){
-  prefs.begin("ori2", true);
+static bool loadBasis(uint8_t i, float up_out[3]){
+  ImuChannel& ch = g_imu[i];
+  prefs.begin(basisNs(i), true);
   bool has = prefs.isKey("upx") && prefs.isKey("ux") && prefs.isKey("fx");
   if (has){
     up_out[0]=prefs.getFloat("upx",0); up_out[1]=prefs.getFloat("upy",0); up_out[2]=prefs.getFloat("upz",1);
-    g_forwardHint=prefs.getString("hint","+X");
-    g_basis.fwd[0]=prefs.getFloat("fx",1); g_basis.fwd[1]=prefs.getFloat("fy",0); g_basis.fwd[2]=prefs.getFloat("fz",0);
-    g_basis.rgt[0]=prefs.getFloat("rx",0); g_basis.rgt[1]=prefs.getFloat("ry",1); g_basis.rgt[2]=prefs.getFloat("rz",0);
-    g_basis.up[0] =prefs.getFloat("ux",0); g_basis.up[1] =prefs.getFloat("uy",0); g_basis.up[2] =prefs.getFloat("uz",1);
-    g_basis.valid=true;
+    ch.forwardHint=prefs.getString("hint","+X").c_str();
+    ch.basis.fwd[0]=prefs.getFloat("fx",1); ch.basis.fwd[1]=prefs.getFloat("fy",0); ch.basis.fwd[2]=prefs.getFloat("fz",0);
+    ch.basis.rgt[0]=prefs.getFloat("rx",0); ch.basis.rgt[1]=prefs.getFloat("ry",1); ch.basis.rgt[2]=prefs.getFloat("rz",0);
+    ch.basis.up[0] =prefs.getFloat("ux",0); ch.basis.up[1] =prefs.getFloat("uy",0); ch.basis.up[2] =prefs.getFloat("uz",1);
+    ch.basis.valid=true;
   }
   prefs.end();
   return has;
 }
-static void saveCalibration() {
-  prefs.begin("imu", false);
-  prefs.putFloat("pitch_zero", pos_pitch_zero);
-  prefs.putFloat("roll_zero",  pos_roll_zero);
-  prefs.putFloat("g_mag",      g_mag);
+// Accel terms (accel_cal.h) as raw floats: m row-major, then b
+static const char* acalNs(uint8_t i) { return i ? "acal_1" : "acal"; }
+static void saveAccelTrim(uint8_t i, const AccelTrim& t){
+  prefs.begin(acalNs(i), false);
+  if (!t.valid) { prefs.clear(); prefs.end(); return; }
+  prefs.putBytes("m", t.m, sizeof(t.m)); prefs.putBytes("b", t.b, sizeof(t.b));
+  prefs.putBool("cross", t.cross);
   prefs.end();
 }
-static void loadOrBootstrapCalibration() {
-  prefs.begin("imu", true);
+static void loadAccelTrim(uint8_t i){
+  AccelTrim t;
+  prefs.begin(acalNs(i), true);
+  t.valid = prefs.getBytes("m", t.m, sizeof(t.m)) == sizeof(t.m) && prefs.getBytes("b", t.b, sizeof(t.b)) == sizeof(t.b);
+  t.cross = prefs.getBool("cross", false);
+  prefs.end();
+  imuBus.setAccelTrim(i, t.valid ? t : AccelTrim{});
+}
+static void saveCalibration(uint8_t i) {
+  const ImuChannel& ch = g_imu[i];
+  prefs.begin(calNs(i), false);
+  prefs.putFloat("pitch_zero", ch.pitch_zero);
+  prefs.putFloat("roll_zero",  ch.roll_zero);
+  prefs.putFloat("g_mag",      ch.g_mag);
+  prefs.end();
+}
+
+// Mean accel and |a| of every present IMU over n acquisitions (trailer at rest).
+// The lock covers one burst at a time, never the waits, so the sense task
+// keeps its ticks while a handler samples
+struct RestMean { float a[3] = {0,0,0}; float gmag = 0; int n = 0; };
+static void sampleAtRest(RestMean out[TL_IMU_MAX], int n, int delayMs) {
+  for (int k=0;k<n;k++){
+    {
+      StateLock lock;
+      imuBus.acquire();
+      for (uint8_t i=0;i<TL_IMU_MAX;i++){
+        const ImuSample& s = imuBus.sample(i);
+        if (!imuBus.present(i) || !s.ok) continue;
+        out[i].a[0]+=s.ax; out[i].a[1]+=s.ay; out[i].a[2]+=s.az;
+        out[i].gmag += sqrtf(s.ax*s.ax + s.ay*s.ay + s.az*s.az);
+        out[i].n++;
+      }
+    }
+    delay(delayMs);
+  }
+  for (uint8_t i=0;i<TL_IMU_MAX;i++){
+    if (!out[i].n) continue;
+    out[i].a[0]/=out[i].n; out[i].a[1]/=out[i].n; out[i].a[2]/=out[i].n; out[i].gmag/=out[i].n;
+  }
+}
+
+static void zeroFromRest(ImuChannel& ch, const float a[3]) {
+  float fwdPose,rgtPose,upPose; toTrailer(ch, a[0], a[1], a[2], fwdPose, rgtPose, upPose);
+  float denom = sqrtf(rgtPose*rgtPose + upPose*upPose); if (denom < 1e-6f) denom = 1e-6f;
+  ch.pitch_zero = atan2f(-fwdPose, denom) * 180.0f / PI;
+  ch.roll_zero  = atan2f( rgtPose, upPose ) * 180.0f / PI;
+}
+
+static void loadOrBootstrapCalibration(uint8_t i, const RestMean& rest) {
+  ImuChannel& ch = g_imu[i];
+  prefs.begin(calNs(i), true);
   bool hasPitch = prefs.isKey("pitch_zero") || prefs.isKey("pitch_off");
   bool hasRoll  = prefs.isKey("roll_zero")  || prefs.isKey("roll_off");
-  g_mag = prefs.getFloat("g_mag", TL_GRAVITY_G_DEFAULT);
+  ch.g_mag = prefs.getFloat("g_mag", TL_GRAVITY_G_DEFAULT);
   if (hasPitch && hasRoll) {
-    pos_pitch_zero = prefs.getFloat(prefs.isKey("pitch_zero") ? "pitch_zero" : "pitch_off", 0.0f);
-    pos_roll_zero  = prefs.getFloat(prefs.isKey("roll_zero")  ? "roll_zero"  : "roll_off",  0.0f);
+    ch.pitch_zero = prefs.getFloat(prefs.isKey("pitch_zero") ? "pitch_zero" : "pitch_off", 0.0f);
+    ch.roll_zero  = prefs.getFloat(prefs.isKey("roll_zero")  ? "roll_zero"  : "roll_off",  0.0f);
     prefs.end(); return;
   }
   prefs.end();
 
-  for (int i=0;i<30;i++){ mpu.update(); delay(5); }
-  float ax=mpu.getAccX(), ay=mpu.getAccY(), az=mpu.getAccZ();
-  float fwdPose,rgtPose,upPose; toTrailer(ax,ay,az,fwdPose,rgtPose,upPose);
-  float denom = sqrtf(rgtPose*rgtPose + upPose*upPose); if (denom < 1e-6f) denom = 1e-6f;
-  pos_pitch_zero = atan2f(-fwdPose, denom) * 180.0f / PI;
-  pos_roll_zero  = atan2f( rgtPose, upPose ) * 180.0f / PI;
-  saveCalibration();
+  if (!rest.n) return;
+  zeroFromRest(ch, rest.a);
+  saveCalibration(i);
 }
 
+// Uncalibrated reading (plain LSB scale) of the device under calibration
+static void feedAccelCal() {
+  if (accelCal.state() != AccelCalibrator::CAPTURING) return;
+  const ImuBus::Device& d = imuBus.device(accelCal.imu());
+  if (!d.present || !d.sample.ok) return;
+  const float k = 1.0f / d.accLsbPerG;
+  accelCal.push(d.sample.raw[0] * k, d.sample.raw[1] * k, d.sample.raw[2] * k);
+}
+
+static void resetAverages(ImuChannel& ch) { ch.pitch_avg = ch.roll_avg = 0.0f; ch.avgInit = true; ch.lastAvgMs = millis(); }
+
 // ---------------- Sensor read and derive values ----------------
-static void readIMU() {
-  mpu.update();
-  accel_x_raw=mpu.getAccX(); accel_y_raw=mpu.getAccY(); accel_z_raw=mpu.getAccZ();
-  gyro_x_raw=mpu.getGyroX(); gyro_y_raw=mpu.getGyroY(); gyro_z_raw=mpu.getGyroZ();
+static inline float wrap180(float a){ if(!isfinite(a))return 0.0f; while(a>180.0f)a-=360.0f; while(a<-180.0f)a+=360.0f; return a; }
+
+// Pitch/roll of one IMU in its own trailer frame, plus the display EMA
+static void updatePose(ImuChannel& ch, const ImuSample& s, uint32_t now) {
+  float af, ar, au; toTrailer(ch, s.ax, s.ay, s.az, af, ar, au);
+  float denom = sqrtf(ar*ar + au*au); if (denom < 1e-6f) denom=1e-6f;
+  ch.pitch_raw = atan2f(-af, denom) * 180.0f / PI;
+  ch.roll_raw  = atan2f( ar, au ) * 180.0f / PI;
+  ch.pitch = wrap180(ch.pitch_raw - ch.pitch_zero);
+  ch.roll  = wrap180(ch.roll_raw  - ch.roll_zero);
+
+  if (!ch.avgInit) { ch.pitch_avg=ch.pitch; ch.roll_avg=ch.roll; ch.avgInit=true; ch.lastAvgMs=now; }
+  else {
+    uint32_t dt = now - ch.lastAvgMs; if (dt>2000) dt=2000;
+    float alpha = 1.0f - expf(-(float)dt / (float)g_acq.levelAvgTauMs);
+    if (alpha<0) alpha=0; if (alpha>1) alpha=1;
+    ch.pitch_avg += alpha*(ch.pitch - ch.pitch_avg);
+    ch.roll_avg  += alpha*(ch.roll  - ch.roll_avg);
+    ch.lastAvgMs=now;
+  }
+}
+
+// One acquisition cycle: every IMU back to back, then pose per device and the
+// gravity-free accel / gyro gauges from the primary, into st. A device with no
+// fresh sample (settling after /profile, a failed burst) feeds nothing: its
+// axle keeps the last output with ok cleared
+static void readIMU(SensorState& st) {
+  imuBus.acquire();
+  const uint32_t now = millis();
+  st.ms = now; st.us = esp_timer_get_time();
+  st.avgTauMs = g_acq.levelAvgTauMs;
+  for (uint8_t i=0;i<TL_IMU_MAX;i++){
+    AxleState& a = st.axle[i];
+    a.present = imuBus.present(i);
+    a.ok = a.present && imuBus.sample(i).ok;
+    if (!a.ok) continue;   // settling or a failed burst: the pose and its EMA hold
+    ImuChannel& ch = g_imu[i];
+    updatePose(ch, imuBus.sample(i), now);
+    a.pitch_raw = ch.pitch_raw; a.roll_raw = ch.roll_raw;
+    a.pitch = ch.pitch;         a.roll = ch.roll;
+    a.pitch_avg = ch.pitch_avg; a.roll_avg = ch.roll_avg;
+  }
 
-  if (!isfinite(gyro_x_raw) || !isfinite(gyro_y_raw) || !isfinite(gyro_z_raw)) {
-    int16_t grx,gry,grz;
-    if (readGyroRawRegs(grx,gry,grz)) {
-      float lsb=gyroLSBperDPS(); gyro_x_raw=(float)grx/lsb; gyro_y_raw=(float)gry/lsb; gyro_z_raw=(float)grz/lsb;
-    } else { gyro_x_raw=gyro_y_raw=gyro_z_raw=0; }
+  if (g_peakReset) {
+    st.accelPeak = Peak4{}; st.rollPeak = Peak4{}; accelPeakLastMs = rollPeakLastMs = now;
+    g_peakReset = false;
   }
+  if (!st.axle[0].ok) return;   // gauges and peaks hold their last values too
+
+  const ImuChannel& ch = g_imu[0];
+  const ImuSample& s = imuBus.sample(0);
+  st.accel_raw[0]=s.ax; st.accel_raw[1]=s.ay; st.accel_raw[2]=s.az;
+  st.gyro_raw[0]=s.gx;  st.gyro_raw[1]=s.gy;  st.gyro_raw[2]=s.gz;
 
   float af_raw, ar_raw, au_raw;
-  toTrailer(accel_x_raw, accel_y_raw, accel_z_raw, af_raw, ar_raw, au_raw);
+  toTrailer(ch, s.ax, s.ay, s.az, af_raw, ar_raw, au_raw);
 
-  float denom = sqrtf(ar_raw*ar_raw + au_raw*au_raw); if (denom < 1e-6f) denom=1e-6f;
-  pos_pitch_raw = atan2f(-af_raw, denom) * 180.0f / PI;
-  pos_roll_raw  = atan2f( ar_raw, au_raw ) * 180.0f / PI;
+  float pr = ch.pitch * (PI/180.0f);
+  float rr = ch.roll  * (PI/180.0f);
+  st.grav_fwd   = -sinf(pr) * ch.g_mag;
+  st.grav_right =  sinf(rr) * ch.g_mag;
+  st.grav_up    =  cosf(pr) * cosf(rr) * ch.g_mag;
 
-  auto wrap180=[](float a){ if(!isfinite(a))return 0.0f; while(a>180.0f)a-=360.0f; while(a<-180.0f)a+=360.0f; return a; };
-  pos_pitch_calibrated = wrap180(pos_pitch_raw - pos_pitch_zero);
-  pos_roll_calibrated  = wrap180(pos_roll_raw  - pos_roll_zero);
+  const float deadband = g_acq.accelDeadbandG;
+  auto dz = [deadband](float v){ return (fabsf(v) < deadband) ? 0.0f : v; };
+  st.accel_fwd   = dz(af_raw - st.grav_fwd);
+  st.accel_right = dz(ar_raw - st.grav_right);
+  st.accel_up    = dz(au_raw - st.grav_up);
 
-  uint32_t now = millis();
-  if (!avgInit) { pos_pitch_avg=pos_pitch_calibrated; pos_roll_avg=pos_roll_calibrated; avgInit=true; lastAvgMs=now; }
-  else {
-    uint32_t dt = now - lastAvgMs; if (dt>2000) dt=2000;
-    float alpha = 1.0f - expf(-(float)dt / (float)TL_LEVEL_AVG_TAU_MS);
-    if (alpha<0) alpha=0; if (alpha>1) alpha=1;
-    pos_pitch_avg += alpha*(pos_pitch_calibrated - pos_pitch_avg);
-    pos_roll_avg  += alpha*(pos_roll_calibrated  - pos_roll_avg);
-    lastAvgMs=now;
-  }
-
-  float pr = pos_pitch_calibrated * (PI/180.0f);
-  float rr = pos_roll_calibrated  * (PI/180.0f);
-  g_fwd_sub = -sinf(pr) * g_mag;
-  g_rgt_sub =  sinf(rr) * g_mag;
-  g_up_sub  =  cosf(pr) * cosf(rr) * g_mag;
-
-  auto dz = [](float v){ return (fabsf(v) < TL_ACCEL_DEADBAND_G) ? 0.0f : v; };
-  float af = dz(af_raw - g_fwd_sub);
-  float ar = dz(ar_raw - g_rgt_sub);
-  float au = dz(au_raw - g_up_sub);
-
-  accel_forward = af; accel_backward = -af;
-  accel_right   = ar; accel_left     = -ar;
-  accel_up      = au; accel_down     = -au;
-
-  float gf, gr, gu; toTrailer(gyro_x_raw, gyro_y_raw, gyro_z_raw, gf, gr, gu);
-  gyro_pitchup    = max(0.0f, +gr);
-  gyro_pitchdown  = max(0.0f, -gr);
-  gyro_rollright  = max(0.0f, -gf);  // RIGHT positive
-  gyro_rollleft   = max(0.0f, +gf);
-  gyro_turnright  = max(0.0f, +gu);
-  gyro_turnleft   = max(0.0f, -gu);
+  float gf, gr, gu; toTrailer(ch, s.gx, s.gy, s.gz, gf, gr, gu);
+  st.rate_pitch = gr;
+  st.rate_roll  = -gf;   // RIGHT positive
+  st.rate_turn  = gu;
 
   Peak4 accNow;
-  accNow.up    = max(0.0f,  accel_forward);
-  accNow.down  = max(0.0f, -accel_forward);
-  accNow.right = max(0.0f,  accel_right);
-  accNow.left  = max(0.0f, -accel_right);
-  updatePeak(g_accelPeak, accNow, accelPeakLastMs, (float)TL_ACCEL_PEAK_TAU_MS);
+  accNow.up    = max(0.0f,  st.accel_fwd);
+  accNow.down  = max(0.0f, -st.accel_fwd);
+  accNow.right = max(0.0f,  st.accel_right);
+  accNow.left  = max(0.0f, -st.accel_right);
+  updatePeak(st.accelPeak, accNow, accelPeakLastMs, (float)g_acq.accelPeakTauMs);
 
   Peak4 rollNow;
-  rollNow.up    = gyro_pitchup;
-  rollNow.down  = gyro_pitchdown;
-  rollNow.right = gyro_rollright;   // RIGHT positive
-  rollNow.left  = gyro_rollleft;
-  updatePeak(g_rollPeak, rollNow, rollPeakLastMs, (float)TL_ROLL_PEAK_TAU_MS);
+  rollNow.up    = max(0.0f,  st.rate_pitch);
+  rollNow.down  = max(0.0f, -st.rate_pitch);
+  rollNow.right = max(0.0f,  st.rate_roll);
+  rollNow.left  = max(0.0f, -st.rate_roll);
+  updatePeak(st.rollPeak, rollNow, rollPeakLastMs, (float)g_acq.rollPeakTauMs);
 }
 
 // ---------------- HTTP helpers & captive portal ----------------
-static void addCORS(){ server.sendHeader("Access-Control-Allow-Origin","*"); server.sendHeader("Access-Control-Allow-Methods","GET,POST,OPTIONS"); server.sendHeader("Access-Control-Allow-Headers","Content-Type"); server.sendHeader("Cache-Control","no-store"); }
-static void sendJson(int code, const String& body){ addCORS(); server.send(code,"application/json",body); }
+// Handler JSON lives in the request arena (HttpServer::arena(), dropped after
+// every request); a document that outgrows it continues on the heap.
+// CORS headers come from the route table (ROUTE_CORS); API answers are never cached
+struct ArenaJsonAllocator : ArduinoJson::Allocator {
+  void* allocate(size_t n) override { void* p = server.arena().alloc(n); return p ? p : malloc(n); }
+  void deallocate(void* p) override { if (!server.arena().owns(p)) free(p); }
+  void* reallocate(void* p, size_t n) override {
+    RequestArena& a = server.arena();
+    if (!p) return allocate(n);
+    if (!a.owns(p)) return realloc(p, n);
+    if (void* q = a.realloc(p, n)) return q;
+    void* q = malloc(n);
+    if (q) memcpy(q, p, min(a.size(p), n));
+    return q;
+  }
+};
+static ArenaJsonAllocator g_reqAlloc;   // HTTP handlers only (server task)
+
+static void noStore(){ server.sendHeader("Cache-Control","no-store"); }
+static void sendJson(int code, const char* body){ noStore(); server.send(code,"application/json",body); }
+// Serialized into the arena and sent from there without another copy
+static void sendJson(int code, const JsonDocument& doc){
+  const size_t n = measureJson(doc);
+  char* buf = (char*)server.arena().alloc(n + 1);
+  if (buf) { serializeJson(doc, buf, n + 1); noStore(); server.send(code, "application/json", buf, n); return; }
+  if (!(buf = (char*)malloc(n + 1))) { sendJson(500, "{\"error\":\"no memory\"}"); return; }
+  serializeJson(doc, buf, n + 1); noStore(); server.send(code, "application/json", buf, n);
+  free(buf);
+}
+// Request body parsed in place into an arena document; false if absent or malformed
+static bool parseBody(JsonDocument& doc){
+  return server.bodyLen() && !deserializeJson(doc, server.body(), server.bodyLen());
+}
 
-static String hostUrl(const char* path){
-  String u = "http://"; u += TL_DOMAIN;
-  if (TL_HTTP_PORT!=80){ u += ":"; u += String(TL_HTTP_PORT); }
-  if (path && *path) { if (path[0]!='/') u+='/'; u+=path; }
-  return u;
+// Fixed at boot from TL_DOMAIN: redirect target and mDNS label
+static FixedString<96> g_uiUrl;       // http://<TL_DOMAIN>[:port]<TL_WEB_UI_PATH>
+static FixedString<32> g_mdnsLabel;   // first DNS label of TL_DOMAIN, lower case
+static void initHostNames(){
+  g_uiUrl.assign("http://").append(TL_DOMAIN);
+  if (TL_HTTP_PORT!=80) g_uiUrl.appendf(":%u", (unsigned)TL_HTTP_PORT);
+  if (TL_WEB_UI_PATH[0] && TL_WEB_UI_PATH[0]!='/') g_uiUrl.append('/');
+  g_uiUrl.append(TL_WEB_UI_PATH);
+  const char* dot = strchr(TL_DOMAIN, '.');
+  g_mdnsLabel.assign(TL_DOMAIN, (dot && dot > TL_DOMAIN) ? (size_t)(dot - TL_DOMAIN) : strlen(TL_DOMAIN));
+  g_mdnsLabel.toLowerCase();
 }
-static String mdnsHostLabel(){ String s=TL_DOMAIN; s.toLowerCase(); int dot=s.indexOf('.'); if(dot>0) s.remove(dot); return s; }
 
 // Global 302 to the UI at TL_DOMAIN
 static void send302ToUI() {
-  String ui = hostUrl(TL_WEB_UI_PATH);  // http://<TL_DOMAIN>[:port]/...
-  server.sendHeader("Location", ui, true);
+  server.sendHeader("Location", g_uiUrl.c_str(), true);
   server.send(302, "text/plain", "Redirecting to UI...");
 }
 
 static void startCaptiveDNS() {
   apIP = WiFi.softAPIP();
-  dnsServer.stop();
-  dnsServer.setTTL(TL_DNS_TTL_SECONDS);
-  dnsServer.setErrorReplyCode(DNSReplyCode::NoError);
-  dnsServer.start(53, "*", apIP);  // wildcard to AP IP
+  dnsServer.begin(apIP);  // wildcard to AP IP; later calls only swap the address
 }
 
 // Redirect handler used for all captive probes and unknown paths
 static void redirectAny(){ send302ToUI(); }
 
-static void registerCaptiveRoutes() {
-  // Redirect for common captive probes
-  server.on("/", HTTP_ANY, redirectAny);
-  // Android
-  server.on("/generate_204", HTTP_ANY, redirectAny);
-  server.on("/gen_204", HTTP_ANY, redirectAny);
-  server.on("/google/generate_204", HTTP_ANY, redirectAny);
-  server.on("/connectivity-check", HTTP_ANY, redirectAny);
-  server.on("/connectivitycheck.gstatic.com/generate_204", HTTP_ANY, redirectAny);
-  // Apple
-  server.on("/hotspot-detect.html", HTTP_ANY, redirectAny);
-  server.on("/success.html", HTTP_ANY, redirectAny);
-  server.on("/library/test/success.html", HTTP_ANY, redirectAny);
-  server.on("/captive.apple.com", HTTP_ANY, redirectAny);
-  // Windows
-  server.on("/ncsi.txt", HTTP_ANY, redirectAny);
-  server.on("/connecttest.txt", HTTP_ANY, redirectAny);
-  server.on("/www.msftconnecttest.com/connecttest.txt", HTTP_ANY, redirectAny);
-  // Chrome and misc
-  server.on("/canonical.html", HTTP_ANY, redirectAny);
-
-  // Catch everything else (all 404s)
-  server.onNotFound(redirectAny);
-}
-
-// ---------------- HTTP API handlers ----------------
-static void handleSensor() {
-  readIMU();
-  JsonDocument doc;
-
-  doc["pos_pitch_raw"]        = pos_pitch_raw;
-  doc["pos_roll_raw"]         = pos_roll_raw;
-  doc["pos_pitch_calibrated"] = pos_pitch_calibrated;
-  doc["pos_roll_calibrated"]  = pos_roll_calibrated;
-  doc["pos_pitch_avg"]        = pos_pitch_avg;
-  doc["pos_roll_avg"]         = pos_roll_avg;
-
-  doc["accel_x_raw"]=accel_x_raw; doc["accel_y_raw"]=accel_y_raw; doc["accel_z_raw"]=accel_z_raw;
-  doc["gyro_x_raw"]=gyro_x_raw;   doc["gyro_y_raw"]=gyro_y_raw;   doc["gyro_z_raw"]=gyro_z_raw;
-
-  doc["accel_forward"]=accel_forward; doc["accel_backward"]=accel_backward;
-  doc["accel_right"]=accel_right;     doc["accel_left"]=accel_left;
-  doc["accel_up"]=accel_up;           doc["accel_down"]=accel_down;
+static void handleUI(){ server.send_P(200, "text/html", INDEX_HTML); }
+
+
+// ---------------- Telemetry frames ----------------
+static FrameSlot g_latestFrame;
+static uint32_t g_frameSeq = 0;
+static uint64_t g_frameBytes = 0;   // full documents serialized, for the delta ratio in /diag
+
+static void fillSensorDoc(JsonDocument& doc, const SensorState& st) {
+  const AxleState& p = st.axle[0];
+  doc["t_us"]                 = st.us;
+  doc["pos_pitch_raw"]        = p.pitch_raw;
+  doc["pos_roll_raw"]         = p.roll_raw;
+  doc["pos_pitch_calibrated"] = p.pitch;
+  doc["pos_roll_calibrated"]  = p.roll;
+  doc["pos_pitch_avg"]        = p.pitch_avg;
+  doc["pos_roll_avg"]         = p.roll_avg;
+  // How fast the angles above move (deg/s) and the EMA behind the _avg ones,
+  // for the UI to predict between frames. Pitch falls as the nose rises (gyro
+  // pitch-up), roll follows gyro roll-right
+  doc["pitch_rate"]           = -st.rate_pitch;
+  doc["roll_rate"]            = st.rate_roll;
+  doc["avg_tau_ms"]           = st.avgTauMs;
+  doc["imu_ok"]               = p.ok;   // false: no fresh sample, everything below is held
+
+  doc["accel_x_raw"]=st.accel_raw[0]; doc["accel_y_raw"]=st.accel_raw[1]; doc["accel_z_raw"]=st.accel_raw[2];
+  doc["gyro_x_raw"]=st.gyro_raw[0];   doc["gyro_y_raw"]=st.gyro_raw[1];   doc["gyro_z_raw"]=st.gyro_raw[2];
+
+  doc["accel_forward"]=st.accel_fwd;  doc["accel_backward"]=-st.accel_fwd;
+  doc["accel_right"]=st.accel_right;  doc["accel_left"]=-st.accel_right;
+  doc["accel_up"]=st.accel_up;        doc["accel_down"]=-st.accel_up;
 
   {
     JsonObject ap = doc["accel_peak"].to<JsonObject>();
-    ap["up"]    = g_accelPeak.up;
-    ap["down"]  = g_accelPeak.down;
-    ap["left"]  = g_accelPeak.left;
-    ap["right"] = g_accelPeak.right;
+    ap["up"]    = st.accelPeak.up;
+    ap["down"]  = st.accelPeak.down;
+    ap["left"]  = st.accelPeak.left;
+    ap["right"] = st.accelPeak.right;
   }
 
-  doc["gravity_forward"]=g_fwd_sub;
-  doc["gravity_right"]=g_rgt_sub;
-  doc["gravity_up"]=g_up_sub;
+  doc["gravity_forward"]=st.grav_fwd;
+  doc["gravity_right"]=st.grav_right;
+  doc["gravity_up"]=st.grav_up;
 
-  doc["gyro_pitchup"]=gyro_pitchup;     doc["gyro_pitchdown"]=gyro_pitchdown;
-  doc["gyro_rollright"]=gyro_rollright; doc["gyro_rollleft"]=gyro_rollleft;
-  doc["gyro_turnright"]=gyro_turnright; doc["gyro_turnleft"]=gyro_turnleft;
+  doc["gyro_pitchup"]=max(0.0f, st.rate_pitch);   doc["gyro_pitchdown"]=max(0.0f, -st.rate_pitch);
+  doc["gyro_rollright"]=max(0.0f, st.rate_roll);  doc["gyro_rollleft"]=max(0.0f, -st.rate_roll);
+  doc["gyro_turnright"]=max(0.0f, st.rate_turn);  doc["gyro_turnleft"]=max(0.0f, -st.rate_turn);
 
   {
     JsonObject rp = doc["roll_peak"].to<JsonObject>();
-    rp["up"]    = g_rollPeak.up;
-    rp["down"]  = g_rollPeak.down;
-    rp["left"]  = g_rollPeak.left;
-    rp["right"] = g_rollPeak.right;
+    rp["up"]    = st.rollPeak.up;
+    rp["down"]  = st.rollPeak.down;
+    rp["left"]  = st.rollPeak.left;
+    rp["right"] = st.rollPeak.right;
+  }
+
+  doc["sway_hz"]  = st.sway.hz;
+  doc["sway_amp"] = st.sway.amp;
+  {
+    const SwayDetector::State& sw = st.swayAlert;
+    JsonObject sa = doc["sway_alert"].to<JsonObject>();
+    sa["active"]  = sw.active;
+    sa["count"]   = sw.alerts;
+    sa["hz"]      = sw.hz;
+    sa["yaw_dps"] = sw.yawDps;
+    sa["lat_g"]   = sw.latG;
   }
 
-  String json; serializeJson(doc, json); sendJson(200, json);
+  // Second IMU: per-axle level and frame twist (front roll minus rear roll;
+  // zero after /calibrate on level ground)
+  if (st.axle[1].present) {
+    JsonArray axles = doc["axles"].to<JsonArray>();
+    for (uint8_t i=0;i<TL_IMU_MAX;i++){
+      const AxleState& ax = st.axle[i];
+      JsonObject a = axles.add<JsonObject>();
+      a["pitch"] = ax.pitch;     a["roll"] = ax.roll;
+      a["pitch_avg"] = ax.pitch_avg; a["roll_avg"] = ax.roll_avg;
+      a["ok"] = ax.ok;
+    }
+    doc["frame_twist"]     = wrap180(st.axle[0].roll - st.axle[1].roll);
+    doc["frame_twist_avg"] = wrap180(st.axle[0].roll_avg - st.axle[1].roll_avg);
+  }
 }
 
-static void handleCalibrate() {
-  for (int i=0;i<40;i++){ mpu.update(); delay(4); }
+// Delta stream (/stream?enc=delta): kStreamFields (stream_fields.h) encoded
+// against the latest keyframe
+enum : uint8_t { STREAM_FULL, STREAM_DELTA };   // HttpServer channels
+static DeltaEncoder g_deltaEnc(kStreamFields, kStreamFieldCount);
+static FrameSlot g_latestKey;                   // newest delta-stream keyframe, opens every subscription
+static char g_deltaBuf[TL_STREAM_FRAME_MAX];    // sense task only
+
+// v[] in kStreamFields order, the same numbers fillSensorDoc() writes; returns the field count
+static uint8_t streamValues(float* v, const SensorState& st) {
+  const AxleState& p = st.axle[0];
+  uint8_t n = 0;
+  auto put = [&](float x) { v[n++] = x; };
+  put(p.pitch_raw); put(p.roll_raw); put(p.pitch); put(p.roll); put(p.pitch_avg); put(p.roll_avg);
+  put(-st.rate_pitch); put(st.rate_roll); put(st.avgTauMs);
+  for (float x : st.accel_raw) put(x);
+  for (float x : st.gyro_raw) put(x);
+  put(st.accel_fwd); put(st.accel_right); put(st.accel_up);
+  put(st.accelPeak.up); put(st.accelPeak.down); put(st.accelPeak.left); put(st.accelPeak.right);
+  put(st.grav_fwd); put(st.grav_right); put(st.grav_up);
+  put(max(0.0f, st.rate_pitch)); put(max(0.0f, -st.rate_pitch));
+  put(max(0.0f, st.rate_roll));  put(max(0.0f, -st.rate_roll));
+  put(max(0.0f, st.rate_turn));  put(max(0.0f, -st.rate_turn));
+  put(st.rollPeak.up); put(st.rollPeak.down); put(st.rollPeak.left); put(st.rollPeak.right);
+  // A dominant frequency is only sent while it stands out: on noise the peak
+  // bin hops from frame to frame, so it reads 0 there
+  put(st.sway.amp >= TL_STREAM_SWAY_FLOOR_G ? st.sway.hz : 0.0f); put(st.sway.amp);
+  put(st.swayAlert.active ? 1.0f : 0.0f); put((float)st.swayAlert.alerts);
+  put(st.swayAlert.active ? st.swayAlert.hz : 0.0f); put(st.swayAlert.yawDps); put(st.swayAlert.latG);
+  put(p.ok ? 1.0f : 0.0f);
+  if (!st.axle[1].present) return kStreamFieldCount - kStreamRearFields;
+  for (const AxleState& ax : st.axle) {
+    put(ax.pitch); put(ax.roll); put(ax.pitch_avg); put(ax.roll_avg); put(ax.ok ? 1.0f : 0.0f);
+  }
+  put(wrap180(p.roll - st.axle[1].roll)); put(wrap180(p.roll_avg - st.axle[1].roll_avg));
+  return n;
+}
 
-  const int N=80;
-  float ax=0,ay=0,az=0, gsum=0;
-  for (int i=0;i<N;i++){
-    mpu.update();
-    float x=mpu.getAccX(), y=mpu.getAccY(), z=mpu.getAccZ();
-    ax+=x; ay+=y; az+=z; gsum += sqrtf(x*x + y*y + z*z);
-    delay(2);
+// Serialize one published state once; polls and subscribers share the bytes.
+// seq counts every frame, so a gap on /stream is a frame the client missed;
+// t_us (acquisition) and pub_us (serialization) are on the /time clock. The
+// delta stream gets the same frame encoded against its last keyframe
+static void publishFrame(const SensorState& st) {
+  JsonDocument doc;
+  const uint32_t seq = ++g_frameSeq;
+  doc["seq"] = seq;
+  fillSensorDoc(doc, st);
+  const int64_t pubUs = esp_timer_get_time();
+  doc["pub_us"] = pubUs;
+  const size_t n = measureJson(doc);
+  SharedFrame* f = SharedFrame::create(n);
+  if (!f) return;
+  f->jsonLen = serializeJson(doc, f->json(), n + 1);
+  f->seq = seq;
+  f->seal();
+  g_frameBytes += f->jsonLen;
+  f->ref();                  // one reference for the slot, one for the broadcast
+  g_latestFrame.publish(f);
+  server.broadcast(f, STREAM_FULL);
+
+  float v[kStreamFieldCount];
+  const uint8_t nv = streamValues(v, st);
+  const size_t dn = g_deltaEnc.encode(v, nv, seq, st.us, pubUs, g_deltaBuf, sizeof(g_deltaBuf));
+  SharedFrame* df = dn ? SharedFrame::create(dn) : nullptr;
+  if (!df) {
+    // The encoder has already rebased on a keyframe nobody will hold; new
+    // subscribers would open on the previous one and resync forever
+    if (dn && g_deltaEnc.lastWasKey()) g_deltaEnc.requestKey();
+    return;
   }
-  ax/=N; ay/=N; az/=N;
-  g_mag = gsum / N;
+  memcpy(df->json(), g_deltaBuf, dn);
+  df->jsonLen = dn;
+  df->seq = seq;
+  df->keyframe = g_deltaEnc.lastWasKey();
+  df->seal();
+  if (df->keyframe) { df->ref(); g_latestKey.publish(df); }
+  server.broadcast(df, STREAM_DELTA);
+}
+
+// Binary multicast frame (station mode) from the current state
+static uint32_t g_mcastSeq = 0;
+static void fillPacket(TelemetryPacket& pk, const SensorState& st) {
+  const AxleState& p = st.axle[0];
+  pk.seq = ++g_mcastSeq; pk.ms = st.ms;
+  pk.flags = p.ok ? TelemetryPacket::FLAG_PRIMARY_OK : 0;
+  if (st.swayAlert.active) pk.flags |= TelemetryPacket::FLAG_SWAY;
+  pk.pitch = p.pitch; pk.roll = p.roll; pk.pitchAvg = p.pitch_avg; pk.rollAvg = p.roll_avg;
+  pk.accFwd = st.accel_fwd; pk.accRight = st.accel_right; pk.accUp = st.accel_up;
+  pk.ratePitch = st.rate_pitch;
+  pk.rateRoll  = st.rate_roll;
+  pk.rateTurn  = st.rate_turn;
+  if (st.axle[1].present) {
+    pk.flags |= TelemetryPacket::FLAG_REAR;
+    pk.rearPitch = st.axle[1].pitch; pk.rearRoll = st.axle[1].roll;
+    pk.twist = wrap180(p.roll - st.axle[1].roll);
+  }
+}
 
-  float up_s[3] = { ax, ay, az }; normalize3(up_s);
-  buildBasisFromUpAndHint(up_s); saveBasis(up_s);
+// ---------------- Tasks ----------------
+static TaskLoad g_senseLoad, g_loopLoad;
+static volatile uint8_t g_publishHz = TL_PUBLISH_HZ;   // set by the power policy
+static volatile uint32_t g_otaSenseGapUs = 0;          // longest sense tick interval during the upload
+
+// Sensing + processing: fixed-rate, pinned, high priority. EMA and peaks
+// advance with time, not with request arrival.
+static void senseTask(void*) {
+  const TickType_t period = pdMS_TO_TICKS(1000 / TL_SAMPLE_HZ);
+  TickType_t wake = xTaskGetTickCount();
+  uint32_t nextPublishMs = 0;
+  uint32_t swayAlerts = 0;
+  uint8_t publishHz = TL_PUBLISH_HZ;
+  uint32_t lastStartUs = micros();
+  uint64_t writeCycles = 0;
+  uint32_t writes = 0;
+  for (;;) {
+    vTaskDelayUntil(&wake, period);
+    const uint32_t t0 = micros();
+    if (ota.receiving() && t0 - lastStartUs > g_otaSenseGapUs) g_otaSenseGapUs = t0 - lastStartUs;
+    lastStartUs = t0;
+    SensorState& st = g_derived;
+    {
+      StateLock lock; readIMU(st); feedAccelCal();
+      spectrum.push(st.accel_right, st.rate_roll, st.rate_turn);
+      swayAlert.push(st.rate_turn, st.accel_right, millis());
+      st.swayAlert = swayAlert.state();
+      const bool swayRaised = st.swayAlert.alerts != swayAlerts;
+      swayAlerts = st.swayAlert.alerts;
+      recorder.record(imuBus, sqrtf(st.accel_fwd*st.accel_fwd + st.accel_right*st.accel_right + st.accel_up*st.accel_up),
+                      swayRaised, millis());
+    }
+    st.sway = spectrum.sway();   // last compute(); at most a tick old
+    st.tick++;
+    const uint32_t c0 = ESP.getCycleCount();
+    g_state.write(st);
+    const uint32_t wc = ESP.getCycleCount() - c0;
+    writeCycles += wc; writes++;
+    g_stateWriteAvgCycles = (uint32_t)(writeCycles / writes);
+    if (wc > g_stateWriteMaxCycles) g_stateWriteMaxCycles = wc;
+
+    if (mcast.due(millis())) { TelemetryPacket pk; fillPacket(pk, st); mcast.send(pk); }
+    spectrum.compute();   // every TL_SAMPLE_HZ / TL_SPECTRUM_HZ ticks, outside the state lock
+    const uint32_t now = millis();
+    const uint8_t hz = g_publishHz;
+    if (hz > publishHz) nextPublishMs = now;   // back from idle: publish now, not at the old 1 s slot
+    publishHz = hz;
+    if ((int32_t)(now - nextPublishMs) >= 0) { nextPublishMs = now + 1000 / hz; publishFrame(st); }
+    g_senseLoad.add(micros() - t0);
+  }
+}
 
-  float fwdPose,rgtPose,upPose; toTrailer(ax, ay, az, fwdPose, rgtPose, upPose);
-  float denom = sqrtf(rgtPose*rgtPose + upPose*upPose); if (denom < 1e-6f) denom=1e-6f;
-  pos_pitch_zero = atan2f(-fwdPose, denom) * 180.0f / PI;
-  pos_roll_zero  = atan2f( rgtPose, upPose ) * 180.0f / PI;
-  saveCalibration();
+static void startTasks() {
+  spectrum.begin();
+  swayAlert.begin(TL_SAMPLE_HZ);
+  recorder.begin();
+  g_loopLoad.name = "loop"; g_loopLoad.core = xPortGetCoreID(); g_loopLoad.handle = xTaskGetCurrentTaskHandle();
+  g_senseLoad.name = "sense"; g_senseLoad.core = TL_SENSE_CORE;
+  xTaskCreatePinnedToCore(senseTask, "sense", TL_SENSE_TASK_STACK, nullptr, TL_SENSE_TASK_PRIO, &g_senseLoad.handle, TL_SENSE_CORE);
+}
 
-  g_accelPeak = Peak4{}; accelPeakLastMs = millis();
-  g_rollPeak  = Peak4{}; rollPeakLastMs  = millis();
+// ---------------- HTTP API handlers ----------------
+static void handleSensor() {
+  SharedFrame* f = g_latestFrame.acquire();
+  if (!f) { sendJson(503, "{\"error\":\"no data yet\"}"); return; }
+  noStore(); server.sendFrame(200, "application/json", f);
+}
 
-  pos_pitch_avg = pos_roll_avg = 0.0f; avgInit=true; lastAvgMs=millis();
+// /stream (GET): Server-Sent Events, one "data:" event per published frame.
+// ?enc=delta: keyframes and deltas (frame_delta.h) instead of full
+// documents, starting with the latest keyframe
+static void handleStream() {
+  noStore();
+  const char* enc;
+  if (server.findArg("enc", &enc) && !strcmp(enc, "delta")) server.beginStream(g_latestKey.acquire(), STREAM_DELTA);
+  else server.beginStream(g_latestFrame.acquire(), STREAM_FULL);
+}
 
-  JsonDocument resp; resp["status"]="ok"; resp["forward_hint"]=g_forwardHint; resp["g_mag"]=g_mag;
-  String json; serializeJson(resp, json); sendJson(200, json);
+// /time (GET): the device clock frames are stamped with. The UI brackets the
+// request with its own clock and takes the reply as the midpoint; the
+// shortest of a few round trips gives the offset
+static void handleTime() {
+  FixedString<40> resp;
+  resp.appendf("{\"us\":%lld}", (long long)esp_timer_get_time());
+  sendJson(200, resp.c_str());
 }
 
+// Samples without holding StateLock (sampleAtRest locks per burst), derives
+// the new basis and zeros on copies, swaps them in under the lock in one step
+// and writes flash after releasing it
+static void handleCalibrate() {
+  for (int i=0;i<40;i++){ { StateLock lock; imuBus.acquire(); } delay(4); }
+
+  RestMean rest[TL_IMU_MAX];
+  sampleAtRest(rest, 80, 2);
+  ImuChannel next[TL_IMU_MAX];
+  float up[TL_IMU_MAX][3];
+  int calibrated = 0;
+  for (uint8_t i=0;i<TL_IMU_MAX;i++){
+    if (!rest[i].n) continue;
+    ImuChannel& ch = next[i];
+    ch.forwardHint = g_imu[i].forwardHint.c_str();   // handler-owned, like the basis and zeros
+    ch.g_mag = rest[i].gmag;
+    memcpy(up[i], rest[i].a, sizeof(up[i])); normalize3(up[i]);
+    buildBasisFromUpAndHint(ch, up[i]);
+    zeroFromRest(ch, rest[i].a);
+    calibrated++;
+  }
+  {
+    StateLock lock;
+    for (uint8_t i=0;i<TL_IMU_MAX;i++){
+      if (!rest[i].n) continue;
+      ImuChannel& ch = g_imu[i];
+      ch.basis = next[i].basis; ch.g_mag = next[i].g_mag;
+      ch.pitch_zero = next[i].pitch_zero; ch.roll_zero = next[i].roll_zero;
+      resetAverages(ch);
+    }
+  }
+  g_peakReset = true;
+  for (uint8_t i=0;i<TL_IMU_MAX;i++){
+    if (rest[i].n) { saveBasis(i, up[i]); saveCalibration(i); }
+  }
+
+  JsonDocument resp(&g_reqAlloc); resp["status"]="ok"; resp["forward_hint"]=g_imu[0].forwardHint.c_str(); resp["g_mag"]=g_imu[0].g_mag;
+  resp["imus"]=calibrated;
+  sendJson(200, resp);
+}
+
+// Zeros, basis and accel terms only change in handlers on this task, so the
+// GETs below read them unlocked; live angles come from the published state
 static void handleGetCalibration() {
-  JsonDocument d; d["pos_pitch_zero"]=pos_pitch_zero; d["pos_roll_zero"]=pos_roll_zero; d["g_mag"]=g_mag;
-  String json; serializeJson(d, json); sendJson(200, json);
+  const ImuChannel& p = g_imu[0];
+  const SensorState st = g_state.read();
+  JsonDocument d(&g_reqAlloc); d["pos_pitch_zero"]=p.pitch_zero; d["pos_roll_zero"]=p.roll_zero; d["g_mag"]=p.g_mag;
+  JsonArray imus = d["imus"].to<JsonArray>();
+  for (uint8_t i=0;i<TL_IMU_MAX;i++){
+    if (!imuBus.present(i)) continue;
+    JsonObject o = imus.add<JsonObject>();
+    o["imu"]=i; o["addr"]=imuBus.device(i).addr;
+    o["pos_pitch_zero"]=g_imu[i].pitch_zero; o["pos_roll_zero"]=g_imu[i].roll_zero; o["g_mag"]=g_imu[i].g_mag;
+    o["accel_cal"]=imuBus.device(i).trim.valid;
+    o["pos_pitch_calibrated"]=st.axle[i].pitch; o["pos_roll_calibrated"]=st.axle[i].roll;
+  }
+  sendJson(200, d);
 }
 static void handleResetCalibration() {
-  pos_pitch_zero=0; pos_roll_zero=0; g_mag=TL_GRAVITY_G_DEFAULT; saveCalibration();
-  pos_pitch_avg=pos_roll_avg=0; avgInit=true; lastAvgMs=millis();
-  g_accelPeak = Peak4{}; g_rollPeak = Peak4{}; accelPeakLastMs=rollPeakLastMs=millis();
+  {
+    StateLock lock;
+    for (uint8_t i=0;i<TL_IMU_MAX;i++){
+      ImuChannel& ch = g_imu[i];
+      ch.pitch_zero=0; ch.roll_zero=0; ch.g_mag=TL_GRAVITY_G_DEFAULT;
+      resetAverages(ch);
+    }
+  }
+  for (uint8_t i=0;i<TL_IMU_MAX;i++) if (imuBus.present(i)) saveCalibration(i);
+  g_peakReset = true;
   sendJson(200, "{\"status\":\"ok\"}");
 }
 
-// GET: basis info; POST: set forward_hint=+X|-X|+Y|-Y and rebuild basis using saved UP
+// Guided accel calibration. POST {"action":..}:
+//   "start" [imu]   discard any session and collect for that device (default 0)
+//   "capture"       hold the device still in a new orientation; the sense task
+//                   accumulates TL_ACAL_POSE_SAMPLES samples, poll GET for the verdict
+//   "solve" [cross] fit, apply and persist; the level zero (/calibrate) should
+//                   be redone afterwards since the readings it came from change
+//   "cancel"        end the session, terms unchanged
+//   "reset" [imu]   drop the terms of that device (plain LSB scale)
+// GET: session state, accepted poses, faces covered and the active terms
+static void accelTrimJson(JsonObject o, const AccelTrim& t) {
+  o["valid"] = t.valid; o["cross"] = t.cross;
+  JsonArray off = o["offset_g"].to<JsonArray>(), sc = o["scale"].to<JsonArray>(), cr = o["cross_terms"].to<JsonArray>();
+  for (int k = 0; k < 3; ++k) { off.add(t.b[k]); sc.add(t.m[4 * k]); }
+  cr.add(t.m[1]); cr.add(t.m[2]); cr.add(t.m[5]);   // xy, xz, yz
+}
+
+static void handleAccelCalibration() {
+  const bool post = server.method() == HTTP_POST;
+  JsonDocument body(&g_reqAlloc);
+  if (post && !parseBody(body)) { sendJson(400, "{\"error\":\"bad json\"}"); return; }
+  // Everything the reply needs, copied under StateLock (the sense task feeds
+  // the calibrator every tick); the document is built once it is released
+  struct {
+    AccelCalibrator::State state;
+    AccelCalibrator::Capture last;
+    uint8_t imu, faces, poseCount;
+    uint16_t captured, target;
+    uint32_t samples;
+    AccelCalibrator::Pose pose[TL_ACAL_MAX_POSES];
+    bool present[TL_IMU_MAX];
+    AccelTrim trim[TL_IMU_MAX];
+  } cal;
+  AccelCalibrator::Result fit;
+  bool solved = false;
+  int errCode = 0;
+  const char* err = nullptr;
+  int saveIdx = -1;   // device whose new trim goes to NVS once StateLock is released
+  AccelTrim saveTrim;
+  {
+    StateLock lock;
+    if (post) {
+      const char* action = body["action"] | "";
+      const int idx = body["imu"] | (int)accelCal.imu();
+      if (idx < 0 || idx >= TL_IMU_MAX || !imuBus.present(idx)) { errCode = 400; err = "{\"error\":\"imu not present\"}"; }
+      else if (!strcmp(action, "start")) accelCal.start(idx);
+      else if (!strcmp(action, "capture")) {
+        if (!accelCal.capture()) {
+          errCode = 409;
+          err = accelCal.state() == AccelCalibrator::IDLE ? "{\"error\":\"no session, start first\"}"
+              : accelCal.lastCapture() == AccelCalibrator::CAP_FULL ? "{\"error\":\"pose limit reached\"}"
+              : "{\"error\":\"capture in progress\"}";
+        }
+      }
+      else if (!strcmp(action, "solve")) {
+        if (accelCal.state() != AccelCalibrator::COLLECTING) { errCode = 409; err = "{\"error\":\"no session or capture in progress\"}"; }
+        else {
+          fit = accelCal.solve(body["cross"] | false);
+          solved = true;
+          if (fit.error == AccelCalibrator::OK) {
+            imuBus.setAccelTrim(accelCal.imu(), fit.trim);
+            saveIdx = accelCal.imu(); saveTrim = fit.trim;
+            accelCal.cancel();
+          }
+        }
+      }
+      else if (!strcmp(action, "cancel")) accelCal.cancel();
+      else if (!strcmp(action, "reset")) { imuBus.setAccelTrim(idx, AccelTrim{}); saveIdx = idx; saveTrim = AccelTrim{}; }
+      else { errCode = 400; err = "{\"error\":\"action must be start|capture|solve|cancel|reset\"}"; }
+    }
+    if (!err) {
+      cal.state = accelCal.state(); cal.last = accelCal.lastCapture();
+      cal.imu = accelCal.imu(); cal.faces = accelCal.faces(); cal.poseCount = accelCal.poseCount();
+      cal.captured = accelCal.captured(); cal.target = accelCal.target();
+      cal.samples = accelCal.samples();
+      for (uint8_t i = 0; i < cal.poseCount; ++i) cal.pose[i] = accelCal.pose(i);
+      for (uint8_t i = 0; i < TL_IMU_MAX; ++i) {
+        cal.present[i] = imuBus.present(i);
+        if (cal.present[i]) cal.trim[i] = imuBus.device(i).trim;
+      }
+    }
+  }
+  if (err) { sendJson(errCode, err); return; }
+  if (saveIdx >= 0) saveAccelTrim(saveIdx, saveTrim);
+
+  JsonDocument doc(&g_reqAlloc);
+  if (solved) {
+    JsonObject f = doc["fit"].to<JsonObject>();
+    f["error"] = AccelCalibrator::errorName(fit.error);
+    f["rms_g"] = fit.rmsG; f["max_g"] = fit.maxG; f["rms_before_g"] = fit.rmsRawG;
+    if (fit.error == AccelCalibrator::OK || fit.error == AccelCalibrator::IMPLAUSIBLE) accelTrimJson(f["terms"].to<JsonObject>(), fit.trim);
+    if (fit.error == AccelCalibrator::OK) f["relevel"] = true;
+  }
+  static const char* const states[] = { "idle", "collecting", "capturing" };
+  doc["state"] = states[cal.state];
+  doc["imu"] = cal.imu;
+  doc["captured"] = cal.captured; doc["target"] = cal.target;
+  doc["last_capture"] = AccelCalibrator::captureName(cal.last);
+  doc["samples"] = cal.samples;
+  doc["need_poses"] = AccelCalibrator::params(false); doc["need_poses_cross"] = AccelCalibrator::params(true);
+  FixedString<16> faces;
+  static const char* const names[] = { "+X", "-X", "+Y", "-Y", "+Z", "-Z" };
+  for (int k = 0; k < 6; ++k) if (cal.faces & (1u << k)) faces.append(names[k]);
+  doc["faces"] = faces.c_str();
+  JsonArray poses = doc["poses"].to<JsonArray>();
+  for (uint8_t i = 0; i < cal.poseCount; ++i) {
+    const AccelCalibrator::Pose& p = cal.pose[i];
+    JsonObject o = poses.add<JsonObject>();
+    JsonArray u = o["u"].to<JsonArray>(); u.add(p.u[0]); u.add(p.u[1]); u.add(p.u[2]);
+    o["sd_g"] = p.sd; o["n"] = p.n;
+  }
+  JsonArray active = doc["active"].to<JsonArray>();
+  for (uint8_t i = 0; i < TL_IMU_MAX; ++i) {
+    if (!cal.present[i]) continue;
+    JsonObject o = active.add<JsonObject>(); o["imu"] = i;
+    accelTrimJson(o, cal.trim[i]);
+  }
+  sendJson(200, doc);
+}
+
+// GET: basis info; POST: set forward_hint=+X|-X|+Y|-Y and rebuild basis using saved UP.
+// Optional imu=<slot> (query on GET, body on POST) selects the device; default 0.
 static void handleOrientation() {
   if (server.method() == HTTP_GET) {
-    JsonDocument doc;
-    doc["mode"] = g_basis.valid ? "basis" : "unset";
-    doc["forward_hint"] = g_forwardHint;
+    const char* v;
+    const int idx = server.findArg("imu", &v) ? atoi(v) : 0;
+    if (idx < 0 || idx >= TL_IMU_MAX) { sendJson(400, "{\"error\":\"imu out of range\"}"); return; }
+    const ImuChannel& ch = g_imu[idx];
+    const SensorState st = g_state.read();
+    JsonDocument doc(&g_reqAlloc);
+    doc["imu"] = idx;
+    doc["mode"] = ch.basis.valid ? "basis" : "unset";
+    doc["forward_hint"] = ch.forwardHint.c_str();
+    doc["pitch"] = st.axle[idx].pitch;
+    doc["roll"]  = st.axle[idx].roll;
 
     JsonObject basis = doc["basis"].to<JsonObject>();
-    { JsonArray f = basis["forward"].to<JsonArray>(); f.add(g_basis.fwd[0]); f.add(g_basis.fwd[1]); f.add(g_basis.fwd[2]); }
-    { JsonArray r = basis["right"].to<JsonArray>();   r.add(g_basis.rgt[0]); r.add(g_basis.rgt[1]); r.add(g_basis.rgt[2]); }
-    { JsonArray u = basis["up"].to<JsonArray>();      u.add(g_basis.up[0]);  u.add(g_basis.up[1]);  u.add(g_basis.up[2]); }
+    { JsonArray f = basis["forward"].to<JsonArray>(); f.add(ch.basis.fwd[0]); f.add(ch.basis.fwd[1]); f.add(ch.basis.fwd[2]); }
+    { JsonArray r = basis["right"].to<JsonArray>();   r.add(ch.basis.rgt[0]); r.add(ch.basis.rgt[1]); r.add(ch.basis.rgt[2]); }
+    { JsonArray u = basis["up"].to<JsonArray>();      u.add(ch.basis.up[0]);  u.add(ch.basis.up[1]);  u.add(ch.basis.up[2]); }
 
-    String json; serializeJson(doc, json); sendJson(200, json);
+    sendJson(200, doc);
     return;
   }
 
   if (server.method() == HTTP_POST) {
-    String hint = g_forwardHint;
-
-    if (server.hasArg("plain") && server.arg("plain").length() > 0) {
-      JsonDocument body;
-      if (!deserializeJson(body, server.arg("plain"))) {
-        if (body["forward_hint"].is<const char*>()) {
-          hint = String((const char*)body["forward_hint"]);
-        }
-      }
+    int idx = 0;
+    JsonDocument body(&g_reqAlloc);
+    const bool parsed = parseBody(body);
+    if (parsed) idx = body["imu"] | 0;
+    if (idx < 0 || idx >= TL_IMU_MAX || !imuBus.present(idx)) {
+      sendJson(400, "{\"error\":\"imu not present\"}");
+      return;
     }
 
-    hint.trim(); hint.toUpperCase();
+    FixedString<8> hint = g_imu[idx].forwardHint.c_str();
+    if (parsed && body["forward_hint"].is<const char*>()) hint.assignTrimmed((const char*)body["forward_hint"]);
+    hint.toUpperCase();
     if (!(hint == "+X" || hint == "-X" || hint == "+Y" || hint == "-Y")) {
       sendJson(400, "{\"error\":\"forward_hint must be +X|-X|+Y|-Y\"}");
       return;
     }
-    g_forwardHint = hint;
 
-    prefs.begin("ori2", true);
+    // Saved UP in and basis out touch flash, so both stay outside StateLock
+    prefs.begin(basisNs(idx), true);
     float up_s[3] = { prefs.getFloat("upx", 0), prefs.getFloat("upy", 0), prefs.getFloat("upz", 1) };
     prefs.end();
-    if (norm3(up_s) < 1e-6f) { mpu.update(); up_s[0]=mpu.getAccX(); up_s[1]=mpu.getAccY(); up_s[2]=mpu.getAccZ(); }
-    normalize3(up_s);
-
-    buildBasisFromUpAndHint(up_s);
-    saveBasis(up_s);
+    ImuChannel& ch = g_imu[idx];
+    {
+      StateLock lock;
+      if (norm3(up_s) < 1e-6f && imuBus.readOne(idx)) {
+        const ImuSample& smp = imuBus.sample(idx); up_s[0]=smp.ax; up_s[1]=smp.ay; up_s[2]=smp.az;
+      }
+      normalize3(up_s);
+      ch.forwardHint = hint.c_str();
+      buildBasisFromUpAndHint(ch, up_s);
+    }
+    saveBasis(idx, up_s);
 
-    sendJson(200, String("{\"status\":\"ok\",\"forward_hint\":\"") + g_forwardHint + "\"}");
+    FixedString<64> resp;
+    resp.appendf("{\"status\":\"ok\",\"imu\":%d,\"forward_hint\":\"%s\"}", idx, ch.forwardHint.c_str());
+    sendJson(200, resp.c_str());
     return;
   }
 
@@ -469,65 +1025,738 @@ static void handleOrientation() {
 }
 
 // /wifi (POST)
-static bool asciiPrintable(const String& s){ for (size_t i=0;i<s.length();++i){ char c=s[i]; if(c<0x20||c>0x7E) return false; } return true; }
+static bool asciiPrintable(const char* s){ for (; *s; ++s){ if (*s<0x20||*s>0x7E) return false; } return true; }
 static void handleWifiUpdate() {
-  addCORS();
-  if (!server.hasArg("plain") || server.arg("plain").isEmpty()){
-    server.send(400,"application/json","{\"error\":\"no body\"}");
+  if (!server.bodyLen()){
+    sendJson(400,"{\"error\":\"no body\"}");
     return;
   }
-  JsonDocument body;
-  if (deserializeJson(body, server.arg("plain"))) {
-    server.send(400,"application/json","{\"error\":\"bad json\"}");
+  JsonDocument body(&g_reqAlloc);
+  if (!parseBody(body)) {
+    sendJson(400,"{\"error\":\"bad json\"}");
     return;
   }
-  String newSsid = String(body["ssid"]|""); String newPwd  = String(body["password"]|""); newSsid.trim();
-  if (newSsid.length()<1 || newSsid.length()>32 || !asciiPrintable(newSsid)){
-    server.send(400,"application/json","{\"error\":\"ssid must be 1..32 printable ASCII\"}");
+  FixedString<32> newSsid; newSsid.assignTrimmed(body["ssid"]|""); FixedString<63> newPwd = body["password"]|"";
+  if (newSsid.empty() || newSsid.truncated() || !asciiPrintable(newSsid.c_str())){
+    sendJson(400,"{\"error\":\"ssid must be 1..32 printable ASCII\"}");
     return;
   }
-  if (newPwd.length()>0 && (newPwd.length()<8 || !asciiPrintable(newPwd))){
-    server.send(400,"application/json","{\"error\":\"password must be >=8 printable ASCII or empty\"}");
+  if (!newPwd.empty() && (newPwd.length()<8 || newPwd.truncated() || !asciiPrintable(newPwd.c_str()))){
+    sendJson(400,"{\"error\":\"password must be 8..63 printable ASCII or empty\"}");
     return;
   }
-  prefs.begin("wifi", false); prefs.putString("ssid", newSsid); prefs.putString("password", newPwd); prefs.end();
+  prefs.begin("wifi", false); prefs.putString("ssid", newSsid.c_str()); prefs.putString("password", newPwd.c_str()); prefs.end();
 
   // Schedule hot-apply (uses global g_wifiPending)
-  g_wifiPending.apply    = true;
-  g_wifiPending.ssid     = newSsid;
-  g_wifiPending.password = newPwd;
-  g_wifiPending.at_ms    = millis() + 500;
+  {
+    StateLock lock;
+    g_wifiPending.apply    = true;
+    g_wifiPending.ssid     = newSsid;
+    g_wifiPending.password = newPwd;
+    g_wifiPending.at_ms    = millis() + 500;
+  }
 
-  String resp = String("{\"status\":\"ok\",\"ssid\":\"") + newSsid + "\"}";
-  server.send(200,"application/json",resp);
+  JsonDocument resp(&g_reqAlloc); resp["status"]="ok"; resp["ssid"]=newSsid.c_str();
+  sendJson(200, resp);
+}
+
+// /station GET: link and multicast status; POST: {enabled, ssid, password, rate_hz}
+// (all optional). Rate applies at once; link changes are applied by loop().
+static void handleStation() {
+  if (server.method() == HTTP_GET) {
+    JsonDocument doc(&g_reqAlloc);
+    { StateLock lock; doc["enabled"] = g_sta.enabled; doc["ssid"] = g_sta.ssid.c_str(); }
+    doc["connected"] = mcast.up();
+    if (mcast.up()) {
+      const IPAddress ip = WiFi.localIP();
+      FixedString<15> dotted;
+      dotted.appendf("%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+      doc["ip"] = dotted.c_str();
+    }
+    doc["group"]   = TL_MCAST_GROUP;
+    doc["port"]    = TL_MCAST_PORT;
+    doc["rate_hz"] = mcast.rate();
+    doc["sent"]    = mcast.stats().sent;
+    doc["errors"]  = mcast.stats().errors;
+    sendJson(200, doc);
+    return;
+  }
+
+  JsonDocument body(&g_reqAlloc);
+  if (!parseBody(body)) {
+    sendJson(400, "{\"error\":\"bad json\"}");
+    return;
+  }
+  StationConfig next; { StateLock lock; next = g_sta; }
+  if (body["enabled"].is<bool>()) next.enabled = body["enabled"];
+  if (body["ssid"].is<const char*>()) next.ssid.assignTrimmed((const char*)body["ssid"]);
+  if (body["password"].is<const char*>()) next.password = (const char*)body["password"];
+  if (next.ssid.truncated() || (next.enabled && (next.ssid.empty() || !asciiPrintable(next.ssid.c_str())))) {
+    sendJson(400, "{\"error\":\"ssid must be 1..32 printable ASCII\"}");
+    return;
+  }
+  if (next.password.truncated() || (!next.password.empty() && (next.password.length()<8 || !asciiPrintable(next.password.c_str())))) {
+    sendJson(400, "{\"error\":\"password must be 8..63 printable ASCII or empty\"}");
+    return;
+  }
+  int rate = mcast.rate();
+  if (!body["rate_hz"].isNull()) {
+    rate = body["rate_hz"] | 0;
+    if (rate < 1 || rate > TL_SAMPLE_HZ) { sendJson(400, "{\"error\":\"rate_hz out of range\"}"); return; }
+  }
+
+  prefs.begin("sta", false);
+  prefs.putBool("enabled", next.enabled); prefs.putString("ssid", next.ssid.c_str());
+  prefs.putString("password", next.password.c_str()); prefs.putUShort("rate", (uint16_t)rate);
+  prefs.end();
+  mcast.setRate((uint16_t)rate);
+  {
+    StateLock lock;
+    if (next.enabled != g_sta.enabled || next.ssid != g_sta.ssid || next.password != g_sta.password) g_staPending = true;
+    g_sta = next;
+  }
+
+  JsonDocument resp(&g_reqAlloc); resp["status"]="ok"; resp["enabled"]=next.enabled; resp["rate_hz"]=rate;
+  sendJson(200, resp);
+}
+
+// /spectrum (GET): single-sided amplitude spectra of the last window, dominant
+// peak per channel and the sway metric. ?max_hz= trims the bin arrays.
+static void handleSpectrum() {
+  float maxHz = 0.5f * TL_SAMPLE_HZ;
+  const char* v;
+  if (server.findArg("max_hz", &v)) { float m = strtof(v, nullptr); if (m > 0 && m < maxHz) maxHz = m; }
+  const size_t kMax = (size_t)(maxHz / SpectrumAnalyzer::binHz());
+
+  static const char* const names[SpectrumAnalyzer::CHANNELS] = { "lateral", "roll_rate", "yaw_rate" };
+  static const char* const units[SpectrumAnalyzer::CHANNELS] = { "g", "dps", "dps" };
+  JsonDocument doc(&g_reqAlloc);
+  if (!spectrum.lockResult(100)) { sendJson(503, "{\"error\":\"busy\"}"); return; }
+  if (!spectrum.resultMs()) { spectrum.unlockResult(); sendJson(503, "{\"error\":\"window not full yet\"}"); return; }
+  doc["n"]      = TL_FFT_N;
+  doc["fs_hz"]  = TL_SAMPLE_HZ;
+  doc["bin_hz"] = SpectrumAnalyzer::binHz();
+  doc["age_ms"] = millis() - spectrum.resultMs();
+  JsonObject sw = doc["sway"].to<JsonObject>();
+  sw["hz"] = spectrum.sway().hz; sw["amp"] = spectrum.sway().amp;
+  for (int c = 0; c < SpectrumAnalyzer::CHANNELS; ++c) {
+    const SpectrumAnalyzer::Channel ch = (SpectrumAnalyzer::Channel)c;
+    JsonObject o = doc[names[c]].to<JsonObject>();
+    o["unit"]    = units[c];
+    o["peak_hz"] = spectrum.dominant(ch).hz;
+    o["peak"]    = spectrum.dominant(ch).amp;
+    JsonArray a = o["amp"].to<JsonArray>();
+    const float* bins = spectrum.bins(ch);
+    for (size_t k = 0; k <= kMax && k < SpectrumAnalyzer::kBins; ++k) a.add(bins[k]);
+  }
+  spectrum.unlockResult();
+  sendJson(200, doc);
+}
+
+// /sway GET: thresholds, live bank amplitudes, alert state and log;
+// POST: {yaw_dps, lat_g, hold_ms} (any subset), persisted
+static void loadSwayConfig() {
+  SwayDetector::Config c;
+  prefs.begin("sway", true);
+  c.yawDps = prefs.getFloat("yaw_dps", c.yawDps);
+  c.latG   = prefs.getFloat("lat_g", c.latG);
+  c.holdMs = prefs.getUInt("hold_ms", c.holdMs);
+  prefs.end();
+  swayAlert.setConfig(c);
+}
+
+static void handleSway() {
+  if (server.method() == HTTP_POST) {
+    JsonDocument body(&g_reqAlloc);
+    if (!parseBody(body)) {
+      sendJson(400, "{\"error\":\"bad json\"}");
+      return;
+    }
+    SwayDetector::Config c;
+    { StateLock lock; c = swayAlert.config(); }   // only this handler writes it
+    if (!body["yaw_dps"].isNull()) c.yawDps = body["yaw_dps"] | 0.0f;
+    if (!body["lat_g"].isNull())   c.latG   = body["lat_g"]   | 0.0f;
+    if (!body["hold_ms"].isNull()) c.holdMs = body["hold_ms"] | 0u;
+    if (!(c.yawDps > 0) || !(c.latG > 0) || c.holdMs > 60000) {
+      sendJson(400, "{\"error\":\"yaw_dps and lat_g must be > 0, hold_ms <= 60000\"}");
+      return;
+    }
+    { StateLock lock; swayAlert.setConfig(c); }
+    prefs.begin("sway", false);
+    prefs.putFloat("yaw_dps", c.yawDps); prefs.putFloat("lat_g", c.latG); prefs.putUInt("hold_ms", c.holdMs);
+    prefs.end();
+  }
+
+  // Copied under the lock (the sense task pushes every tick), serialized after
+  SwayDetector::Config c;
+  SwayDetector::State st;
+  float hzs[SwayDetector::kBins], yaws[SwayDetector::kBins], lats[SwayDetector::kBins];
+  SwayDetector::Event events[TL_SWAY_ALERT_LOG_LEN];
+  size_t nEvents;
+  {
+    StateLock lock;
+    c = swayAlert.config();
+    st = swayAlert.state();
+    for (int i = 0; i < SwayDetector::kBins; ++i) {
+      hzs[i]  = swayAlert.binHz(i);
+      yaws[i] = swayAlert.amplitude(SwayDetector::YAW, i);
+      lats[i] = swayAlert.amplitude(SwayDetector::LATERAL, i);
+    }
+    nEvents = swayAlert.logCount();
+    for (size_t i = 0; i < nEvents; ++i) events[i] = swayAlert.logAt(i);
+  }
+
+  JsonDocument doc(&g_reqAlloc);
+  doc["uptime_ms"] = millis();
+  JsonObject cfg = doc["config"].to<JsonObject>();
+  cfg["yaw_dps"] = c.yawDps; cfg["lat_g"] = c.latG; cfg["hold_ms"] = c.holdMs;
+  JsonObject s = doc["state"].to<JsonObject>();
+  s["active"] = st.active; s["since_ms"] = st.sinceMs; s["count"] = st.alerts;
+  s["hz"] = st.hz; s["yaw_dps"] = st.yawDps; s["lat_g"] = st.latG;
+  JsonObject bank = doc["bank"].to<JsonObject>();
+  JsonArray hz = bank["hz"].to<JsonArray>(), yaw = bank["yaw_dps"].to<JsonArray>(), lat = bank["lat_g"].to<JsonArray>();
+  for (int i = 0; i < SwayDetector::kBins; ++i) { hz.add(hzs[i]); yaw.add(yaws[i]); lat.add(lats[i]); }
+  JsonArray log = doc["log"].to<JsonArray>();
+  for (size_t i = 0; i < nEvents; ++i) {
+    const SwayDetector::Event& e = events[i];
+    JsonObject o = log.add<JsonObject>();
+    o["start_ms"] = e.startMs; o["end_ms"] = e.endMs;
+    o["hz"] = e.hz; o["yaw_dps"] = e.yawDps; o["lat_g"] = e.latG;
+  }
+  sendJson(200, doc);
+}
+
+// /recorder GET: state, trigger threshold, last capture; POST: {"trigger":true}
+// and/or {"accel_g":x} (persisted). /recorder/capture: the newest window as
+// RecHeader + RecSample[] (tools/rec_dump converts it to CSV)
+static void loadRecorderConfig() {
+  prefs.begin("rec", true);
+  recorder.setAccelThreshold(prefs.getFloat("accel_g", TL_REC_TRIG_ACCEL_G));
+  prefs.end();
+}
+
+static void handleRecorder() {
+  if (!recorder.enabled()) { sendJson(503, "{\"error\":\"no PSRAM\"}"); return; }
+  if (server.method() == HTTP_POST) {
+    JsonDocument body(&g_reqAlloc);
+    if (!parseBody(body)) {
+      sendJson(400, "{\"error\":\"bad json\"}");
+      return;
+    }
+    if (!body["accel_g"].isNull()) {
+      const float g = body["accel_g"] | 0.0f;
+      if (!(g > 0.05f) || g > 16.0f) { sendJson(400, "{\"error\":\"accel_g must be in (0.05, 16]\"}"); return; }
+      recorder.setAccelThreshold(g);
+      prefs.begin("rec", false); prefs.putFloat("accel_g", g); prefs.end();
+    }
+    if (body["trigger"] | false) recorder.requestTrigger();
+  }
+
+  JsonDocument doc(&g_reqAlloc);
+  doc["uptime_ms"] = millis();
+  doc["capturing"] = recorder.capturing();
+  doc["accel_g"]   = recorder.accelThreshold();
+  doc["ring_s"]    = TL_REC_RING_S;
+  doc["pre_s"]     = TL_REC_PRE_S;
+  doc["post_s"]    = TL_REC_POST_S;
+  doc["captures"]  = recorder.stats().captures;
+  SharedFrame* f = recorder.acquireCapture();
+  if (f) {
+    RecHeader h; memcpy(&h, f->json(), sizeof(h));
+    static const char* const kinds[] = { "none", "accel", "sway", "manual" };
+    JsonObject c = doc["last"].to<JsonObject>();
+    c["trigger"]    = kinds[h.kind < 4 ? h.kind : 0];
+    c["trigger_ms"] = h.triggerMs;
+    c["value"]      = h.value;
+    c["samples"]    = h.count;
+    c["bytes"]      = f->jsonLen;
+    f->unref();
+  }
+  sendJson(200, doc);
+}
+
+static void handleRecorderCapture() {
+  SharedFrame* f = recorder.acquireCapture();
+  if (!f) { sendJson(404, "{\"error\":\"no capture yet\"}"); return; }
+  server.sendHeader("Content-Disposition", "attachment; filename=\"tl_capture.bin\"");
+  noStore(); server.sendFrame(200, "application/octet-stream", f);
+}
+
+// /profile GET: the acquisition profile in use, what its registers amount to
+// and the presets; POST {"name":..} switches to a preset, any other field of
+// the GET "profile" object overrides that value (on top of the named preset,
+// or of the current profile without a name). Applied between two sense ticks
+// and persisted; refused while an accel calibration pose is being captured
+static AcqProfile defaultProfile() {
+  const AcqProfile* p = acqPreset(TL_ACQ_PROFILE);
+  return p ? *p : kAcqPresets[0];
+}
+
+static void saveProfile(const AcqProfile& p) {
+  prefs.begin("acq", false);
+  prefs.putString("name", p.name);
+  prefs.putUChar("dlpf", p.dlpf); prefs.putUChar("div", p.smplrtDiv);
+  prefs.putUChar("gyro", p.gyroRange); prefs.putUChar("acc", p.accRange);
+  prefs.putUShort("avg_tau", p.levelAvgTauMs);
+  prefs.putUShort("apk_tau", p.accelPeakTauMs); prefs.putUShort("rpk_tau", p.rollPeakTauMs);
+  prefs.putFloat("dead_g", p.accelDeadbandG);
+  prefs.putUChar("pub_hz", p.publishHz); prefs.putUShort("poll_ms", p.uiPollMs);
+  prefs.end();
+}
+
+static AcqProfile loadProfile() {
+  prefs.begin("acq", true);
+  const AcqProfile* preset = acqPreset(prefs.getString("name", TL_ACQ_PROFILE).c_str());
+  const AcqProfile base = preset ? *preset : defaultProfile();
+  AcqProfile p = base;
+  p.dlpf = prefs.getUChar("dlpf", p.dlpf);         p.smplrtDiv = prefs.getUChar("div", p.smplrtDiv);
+  p.gyroRange = prefs.getUChar("gyro", p.gyroRange); p.accRange = prefs.getUChar("acc", p.accRange);
+  p.levelAvgTauMs  = prefs.getUShort("avg_tau", p.levelAvgTauMs);
+  p.accelPeakTauMs = prefs.getUShort("apk_tau", p.accelPeakTauMs);
+  p.rollPeakTauMs  = prefs.getUShort("rpk_tau", p.rollPeakTauMs);
+  p.accelDeadbandG = prefs.getFloat("dead_g", p.accelDeadbandG);
+  p.publishHz = prefs.getUChar("pub_hz", p.publishHz); p.uiPollMs = prefs.getUShort("poll_ms", p.uiPollMs);
+  prefs.end();
+  return acqProfileError(p) ? base : p;
+}
+
+// Caller holds StateLock (or runs before the tasks start): the sense task is
+// between two ticks, so registers, scales and coefficients change together
+static bool applyProfile(const AcqProfile& p) {
+  const bool ok = imuBus.configure(p.dlpf, p.smplrtDiv, p.gyroRange, p.accRange, acqSettleMs(p));
+  g_acq = p;
+  return ok;
+}
+
+template <class T> static bool takeField(JsonVariantConst v, T& out) {
+  if (v.isNull()) return true;
+  if (!v.is<T>()) return false;
+  out = v.as<T>();
+  return true;
+}
+
+static void handleProfile() {
+  if (server.method() == HTTP_POST) {
+    JsonDocument body(&g_reqAlloc);
+    if (!parseBody(body)) {
+      sendJson(400, "{\"error\":\"bad json\"}");
+      return;
+    }
+    AcqProfile p = g_acq;
+    if (!body["name"].isNull()) {
+      const AcqProfile* preset = acqPreset(body["name"] | "");
+      if (!preset) { sendJson(400, "{\"error\":\"unknown profile\"}"); return; }
+      p = *preset;
+    }
+    const bool typed = takeField(body["dlpf"], p.dlpf) && takeField(body["smplrt_div"], p.smplrtDiv)
+                    && takeField(body["gyro_range"], p.gyroRange) && takeField(body["acc_range"], p.accRange)
+                    && takeField(body["avg_tau_ms"], p.levelAvgTauMs)
+                    && takeField(body["accel_peak_tau_ms"], p.accelPeakTauMs)
+                    && takeField(body["roll_peak_tau_ms"], p.rollPeakTauMs)
+                    && takeField(body["accel_deadband_g"], p.accelDeadbandG)
+                    && takeField(body["publish_hz"], p.publishHz) && takeField(body["ui_poll_ms"], p.uiPollMs);
+    if (!typed) { sendJson(400, "{\"error\":\"profile values must be numbers in range\"}"); return; }
+    if (const char* err = acqProfileError(p)) {
+      JsonDocument e(&g_reqAlloc); e["error"] = err;
+      sendJson(400, e);
+      return;
+    }
+    int rollback = 0;   // 1: back on the previous profile, 2: the IMU refused that too
+    {
+      StateLock lock;
+      if (accelCal.state() == AccelCalibrator::CAPTURING) {
+        sendJson(409, "{\"error\":\"accel calibration pose in progress\"}");
+        return;
+      }
+      const AcqProfile prev = g_acq;
+      if (applyProfile(p)) { g_acqSwitches++; g_acqPending = true; }
+      else rollback = applyProfile(prev) ? 1 : 2;
+    }
+    // A rollback the IMU refused too leaves its registers on neither profile
+    if (rollback == 2) DEBUG_PRINTLN("IMU: profile rollback failed, registers unknown");
+    if (rollback) {
+      sendJson(500, rollback == 1 ? "{\"error\":\"IMU did not take the profile\",\"rolled_back\":true}"
+                                  : "{\"error\":\"IMU did not take the profile or the rollback\",\"rolled_back\":false}");
+      return;
+    }
+    saveProfile(p);
+  }
+
+  const AcqProfile& p = g_acq;   // only written on this task
+  JsonDocument doc(&g_reqAlloc);
+  JsonObject o = doc["profile"].to<JsonObject>();
+  o["name"] = p.name;
+  o["dlpf"] = p.dlpf; o["smplrt_div"] = p.smplrtDiv;
+  o["gyro_range"] = p.gyroRange; o["acc_range"] = p.accRange;
+  o["avg_tau_ms"] = p.levelAvgTauMs;
+  o["accel_peak_tau_ms"] = p.accelPeakTauMs; o["roll_peak_tau_ms"] = p.rollPeakTauMs;
+  o["accel_deadband_g"] = p.accelDeadbandG;
+  o["publish_hz"] = p.publishHz; o["ui_poll_ms"] = p.uiPollMs;
+  JsonObject r = doc["derived"].to<JsonObject>();
+  r["dlpf_hz"] = acqDlpfHz(p.dlpf);
+  r["output_hz"] = acqOutputHz(p);
+  r["accel_range_g"] = acqAccRangeG(p.accRange);
+  r["gyro_range_dps"] = acqGyroRangeDps(p.gyroRange);
+  r["settle_ms"] = acqSettleMs(p);
+  r["sample_hz"] = TL_SAMPLE_HZ;
+  JsonArray presets = doc["presets"].to<JsonArray>();
+  for (uint8_t i = 0; i < kAcqPresetCount; ++i) presets.add(kAcqPresets[i].name);
+  sendJson(200, doc);
+}
+
+// ---------------- Firmware update ----------------
+// POST /update: the raw image as the body (curl --data-binary), with
+// "Authorization: Bearer <TL_OTA_TOKEN>" and "X-Firmware-MD5: <hex>". The body
+// is checked before the first byte is written and streamed to flash as it
+// arrives; 200 and a reboot into the new slot once the MD5 matches.
+// GET /update: running slot, its rollback state and the last upload
+extern "C" bool verifyRollbackLater() { return true; }   // the core leaves the image pending; ota.service() confirms it
+
+// Constant time in the token length, so a wrong guess does not leak how much matched
+static bool otaAuthorized() {
+  const char* v; size_t n;
+  static const char kToken[] = TL_OTA_TOKEN;
+  const size_t tn = sizeof(kToken) - 1;
+  if (!tn || !server.header("Authorization", &v, &n) || n != 7 + tn || strncasecmp(v, "Bearer ", 7)) return false;
+  uint8_t diff = 0;
+  for (size_t i = 0; i < tn; ++i) diff |= (uint8_t)(v[7 + i] ^ kToken[i]);
+  return diff == 0;
+}
+
+static void sendOtaError(int code, const char* error) {
+  JsonDocument d(&g_reqAlloc); d["error"] = error;
+  sendJson(code, d);
+}
+
+static void handleUpdateUpload() {
+  const HttpServer::Upload& up = server.upload();
+  switch (up.status) {
+    case HttpServer::Upload::START: {
+      if (!TL_OTA_TOKEN[0]) { sendOtaError(403, "OTA disabled: set TL_OTA_TOKEN"); return; }
+      if (!otaAuthorized()) { server.sendHeader("WWW-Authenticate", "Bearer"); sendOtaError(401, "unauthorized"); return; }
+      const char* v; size_t n;
+      FixedString<32> md5;
+      if (server.header("X-Firmware-MD5", &v, &n)) md5.assign(v, n);
+      switch (ota.begin(up.total, md5.c_str())) {
+        case OtaUpdate::BEGUN:       break;
+        case OtaUpdate::BUSY:        sendOtaError(409, "update in progress"); return;
+        case OtaUpdate::NO_SLOT:     sendOtaError(500, "no OTA partition"); return;
+        case OtaUpdate::TOO_LARGE:   sendOtaError(413, "image larger than the OTA slot"); return;
+        case OtaUpdate::BAD_MD5:     sendOtaError(400, "X-Firmware-MD5 must be 32 hex digits"); return;
+        case OtaUpdate::FLASH_ERROR: sendOtaError(500, ota.last().error.c_str()); return;
+      }
+      g_otaSenseGapUs = 0;
+      log_i("ota: receiving %u bytes into the inactive slot", (unsigned)up.total);
+      return;
+    }
+    case HttpServer::Upload::WRITE:
+      if (!ota.write(up.buf, up.len)) sendOtaError(500, ota.last().error.c_str());
+      return;
+    case HttpServer::Upload::END:
+      return;   // handleUpdate() verifies and answers
+    case HttpServer::Upload::ABORTED:
+      ota.abort("connection closed");
+      return;
+  }
+}
+
+static void otaResultJson(JsonObject o, const OtaUpdate::Result& r) {
+  o["ok"] = r.ok; o["size"] = r.size; o["bytes"] = r.bytes;
+  o["ms"] = r.ms; o["flash_ms"] = r.flashMs; o["kib_s"] = r.kibPerS();
+  if (!r.error.empty()) o["error"] = r.error.c_str();
+}
+
+static void handleUpdate() {
+  JsonDocument doc(&g_reqAlloc);
+  if (server.method() == HTTP_POST) {
+    if (!ota.receiving()) { sendOtaError(400, "expected the image as the request body"); return; }
+    const bool ok = ota.end();
+    otaResultJson(doc["upload"].to<JsonObject>(), ota.last());
+    doc["sense_gap_max_us"] = g_otaSenseGapUs;
+    if (ok) doc["rebooting_in_ms"] = TL_OTA_REBOOT_DELAY_MS;
+    sendJson(ok ? 200 : 400, doc);
+    return;
+  }
+  doc["enabled"] = TL_OTA_TOKEN[0] != 0;
+  doc["running"] = OtaUpdate::running();
+  doc["image_state"] = OtaUpdate::imageState();
+  if (const char* rb = OtaUpdate::rolledBackFrom()) doc["rolled_back_from"] = rb;
+  doc["slot_bytes"] = OtaUpdate::slotSize();
+  doc["receiving"] = ota.receiving();
+  const OtaUpdate::Stats& s = ota.stats();
+  doc["attempts"] = s.attempts; doc["ok"] = s.ok; doc["failed"] = s.failed;
+  if (s.attempts) {
+    otaResultJson(doc["last"].to<JsonObject>(), ota.last());
+    doc["sense_gap_max_us"] = g_otaSenseGapUs;
+  }
+  sendJson(200, doc);
+}
+
+// Heap fragmentation watch: loop() samples the largest free block once a
+// second; a falling minimum under steady traffic means something is leaving holes
+static uint32_t g_heapLargestMin = UINT32_MAX;
+static uint32_t g_heapLargestBoot = 0;   // first sample, after setup()
+
+// /diag (GET): HTTP/DNS counters, service latency and per-task load
+static void handleDiag() {
+  const HttpServer::Stats& st = server.stats();
+  JsonDocument doc(&g_reqAlloc);
+  doc["uptime_ms"] = millis();
+  doc["heap_free"] = ESP.getFreeHeap();
+  JsonObject heap = doc["heap"].to<JsonObject>();
+  {
+    const uint32_t freeB = ESP.getFreeHeap(), largest = ESP.getMaxAllocHeap();
+    heap["free"]         = freeB;
+    heap["min_free"]     = ESP.getMinFreeHeap();
+    heap["largest"]      = largest;
+    heap["frag_pct"]     = freeB ? 100.0f * (1.0f - (float)largest / (float)freeB) : 0.0f;
+    heap["largest_boot"] = g_heapLargestBoot;
+    heap["largest_min"]  = g_heapLargestMin == UINT32_MAX ? largest : g_heapLargestMin;
+  }
+  JsonObject http = doc["http"].to<JsonObject>();
+  http["accepted"]     = st.accepted;
+  http["active"]       = st.active;
+  http["peak_active"]  = st.peakActive;
+  http["requests"]     = st.requests;
+  http["not_found"]    = st.notFound;
+  http["bad_requests"] = st.badRequests;
+  http["preflights"]   = st.preflights;
+  http["dispatch_cycles_avg"] = st.requests ? (uint32_t)(st.dispatchCycles / st.requests) : 0;
+  http["timeouts"]     = st.timeouts;
+  http["last_us"]      = st.lastUs;
+  http["avg_us"]       = st.requests ? (uint32_t)(st.sumUs / st.requests) : 0;
+  http["max_us"]       = st.maxUs;
+  http["reused"]       = st.reused;
+  http["pipelined"]    = st.pipelined;
+  http["ka_idle_closed"] = st.kaIdleClosed;
+  http["ka_max_closed"]  = st.kaMaxClosed;
+  const RequestArena::Stats& as = server.arena().stats();
+  http["arena_bytes"]     = server.arena().capacity();
+  http["arena_peak"]      = as.peak;
+  http["arena_overflows"] = as.overflows;
+  http["arena_spills"]    = st.arenaSpills;
+  http["uploads"]         = st.uploads;
+  http["upload_aborts"]   = st.uploadAborts;
+  const CaptiveDns::Stats& ds = dnsServer.stats();
+  JsonObject dns = doc["dns"].to<JsonObject>();
+  dns["queries"]      = ds.queries;
+  dns["answered"]     = ds.answered;
+  dns["empty"]        = ds.empty;
+  dns["own_domain"]   = ds.ownDomain;
+  dns["rate_limited"] = ds.rateLimited;
+  dns["malformed"]    = ds.malformed;
+  JsonArray tasks = doc["tasks"].to<JsonArray>();
+  for (TaskLoad* t : { &g_senseLoad, &server.load(), &dnsServer.load(), &g_loopLoad }) {
+    JsonObject o = tasks.add<JsonObject>();
+    o["name"]       = t->name;
+    o["core"]       = t->core;
+    o["prio"]       = t->handle ? (int)uxTaskPriorityGet(t->handle) : -1;
+    o["cpu_pct"]    = t->windowPct();
+    o["max_us"]     = (uint32_t)t->maxUs;
+    o["stack_free"] = t->stackFree();
+  }
+  JsonObject imu = doc["imu"].to<JsonObject>();
+  {
+    StateLock lock;
+    imu["cycle_us"]     = imuBus.lastCycleUs();
+    imu["cycle_max_us"] = imuBus.maxCycleUs();
+    imu["profile"]      = g_acq.name;
+    imu["profile_switches"] = g_acqSwitches;
+    JsonArray devs = imu["devices"].to<JsonArray>();
+    for (uint8_t i=0;i<TL_IMU_MAX;i++){
+      const ImuBus::Device& d = imuBus.device(i);
+      JsonObject o = devs.add<JsonObject>();
+      o["addr"]     = d.addr;
+      o["present"]  = d.present;
+      o["reads"]    = d.reads;
+      o["errors"]   = d.errors;
+      o["read_us"]  = d.lastReadUs;
+      o["read_max_us"] = d.maxReadUs;
+      o["skew_us"]  = d.skewUs;
+      o["acc_lsb_per_g"]    = d.accLsbPerG;
+      o["gyro_lsb_per_dps"] = d.gyroLsbPerDps;
+      o["settling"] = d.settling;
+    }
+  }
+  JsonObject state = doc["state"].to<JsonObject>();
+  {
+    const SeqLock<SensorState>::Stats ls = g_state.stats();
+    state["bytes"]          = (uint32_t)sizeof(SensorState);
+    state["writes"]         = ls.writes;
+    state["read_retries"]   = ls.retries;
+    state["write_avg_ns"]   = g_stateWriteAvgCycles * 1000 / ESP.getCpuFreqMHz();
+    state["write_max_ns"]   = g_stateWriteMaxCycles * 1000 / ESP.getCpuFreqMHz();
+  }
+  const McastTelemetry::Stats& ms = mcast.stats();
+  JsonObject mc = doc["mcast"].to<JsonObject>();
+  mc["up"]       = mcast.up();
+  mc["rate_hz"]  = mcast.rate();
+  mc["sent"]     = ms.sent;
+  mc["errors"]   = ms.errors;
+  mc["link_ups"] = ms.linkUps;
+  const SpectrumAnalyzer::Stats& ss = spectrum.stats();
+  JsonObject sp = doc["spectrum"].to<JsonObject>();
+  sp["kernel"]   = SpectrumAnalyzer::kernel();
+  sp["runs"]     = ss.runs;
+  sp["last_us"]  = ss.lastUs;
+  sp["max_us"]   = ss.maxUs;
+  sp["avg_us"]   = ss.runs ? (uint32_t)(ss.sumUs / ss.runs) : 0;
+  sp["cpu_pct"]  = ss.runs ? (float)(ss.sumUs / ss.runs) * TL_SPECTRUM_HZ / 10000.0f : 0.0f;  // of one core
+  sp["deferred"] = ss.deferred;
+  JsonObject sw = doc["sway"].to<JsonObject>();
+  {
+    StateLock lock;
+    const SwayDetector::Stats& sws = swayAlert.stats();
+    const uint32_t avgCycles = sws.samples ? (uint32_t)(sws.cycles / sws.samples) : 0;
+    sw["samples"]    = sws.samples;
+    sw["avg_cycles"] = avgCycles;
+    sw["max_cycles"] = sws.maxCycles;
+    sw["avg_ns"]     = avgCycles * 1000 / ESP.getCpuFreqMHz();
+  }
+  JsonObject rec = doc["recorder"].to<JsonObject>();
+  {
+    const FlightRecorder::Stats& rs = recorder.stats();
+    const uint32_t avgCycles = rs.samples ? (uint32_t)(rs.cycles / rs.samples) : 0;
+    rec["enabled"]    = recorder.enabled();
+    rec["written"]    = recorder.written();
+    rec["triggers"]   = rs.triggers;
+    rec["ignored"]    = rs.ignored;
+    rec["captures"]   = rs.captures;
+    rec["lost"]       = rs.lost;
+    rec["avg_cycles"] = avgCycles;
+    rec["max_cycles"] = rs.maxCycles;
+    rec["avg_ns"]     = avgCycles * 1000 / ESP.getCpuFreqMHz();
+    rec["psram_free"] = ESP.getFreePsram();
+  }
+  JsonObject pw = doc["power"].to<JsonObject>();
+  {
+    const PowerPolicy::Stats& ps = power.stats();
+    const uint64_t total = ps.idleMs + ps.activeMs;
+    pw["mode"]       = power.decision().mode == PowerPolicy::IDLE ? "idle" : "active";
+    pw["cpu_mhz"]    = getCpuFrequencyMhz();
+    pw["publish_hz"] = power.decision().publishHz;
+    pw["since_ms"]   = power.sinceMs();
+    pw["ap_clients"] = WiFi.softAPgetStationNum();
+    pw["to_idle"]    = ps.toIdle;
+    pw["to_active"]  = ps.toActive;
+    pw["refused"]    = ps.refused;
+    pw["idle_pct"]   = total ? (float)(100.0 * (double)ps.idleMs / (double)total) : 0.0f;
+  }
+  JsonObject upd = doc["ota"].to<JsonObject>();
+  {
+    const OtaUpdate::Stats& os = ota.stats();
+    upd["running"]     = OtaUpdate::running();
+    upd["image_state"] = OtaUpdate::imageState();
+    upd["attempts"]    = os.attempts;
+    upd["ok"]          = os.ok;
+    upd["failed"]      = os.failed;
+    upd["last_kib_s"]  = ota.last().kibPerS();
+  }
+  JsonObject tel = doc["telemetry"].to<JsonObject>();
+  tel["frames"]        = g_frameSeq;
+  tel["subscribers"]   = st.subscribers;
+  tel["stream_frames"] = st.streamFrames;
+  tel["stream_skips"]  = st.streamSkips;
+  tel["key_holds"]     = st.keyHolds;
+  tel["stream_stalls"] = st.streamStalls;
+  tel["frame_bytes"]   = g_frameSeq ? (uint32_t)(g_frameBytes / g_frameSeq) : 0;
+  {
+    const DeltaEncoder::Stats& ds = g_deltaEnc.stats();
+    JsonObject de = tel["delta"].to<JsonObject>();
+    de["keys"]        = ds.keys;
+    de["deltas"]      = ds.deltas;
+    de["still"]       = ds.still;
+    de["overflows"]   = ds.overflows;
+    de["key_bytes"]   = ds.keys ? (uint32_t)(ds.keyBytes / ds.keys) : 0;
+    de["delta_bytes"] = ds.deltas ? (uint32_t)(ds.deltaBytes / ds.deltas) : 0;
+    de["max_delta"]   = ds.maxDelta;
+    const uint64_t enc = ds.keyBytes + ds.deltaBytes;
+    de["ratio"]       = enc ? (float)g_frameBytes / (float)enc : 0.0f;
+  }
+  sendJson(200, doc);
+}
+
+// ---------------- Power ----------------
+// loop() feeds the policy on every pass and applies its decision: the clock
+// changes here on TL_NET_CORE, the sense task only follows g_publishHz
+static void wakeLoop() { if (g_loopLoad.handle) xTaskNotifyGive(g_loopLoad.handle); }
+
+static uint16_t applyPower() {
+  // Sense load over >= 1 s windows (spectrum runs make shorter ones jumpy)
+  static uint32_t busyLast = 0, wallLast = 0;
+  static float sensePct = 0;
+  const uint32_t nowUs = micros(), busy = g_senseLoad.busyUs;
+  if ((uint32_t)(nowUs - wallLast) >= 1000000) {
+    sensePct = 100.0f * (float)(busy - busyLast) / (float)(nowUs - wallLast);
+    busyLast = busy; wallLast = nowUs;
+  }
+
+  PowerPolicy::Inputs in;
+  in.apClients     = WiFi.softAPgetStationNum();
+  in.subscribers   = server.stats().subscribers;
+  in.stationLinked = mcast.up();
+  in.requests      = server.stats().requests;
+  in.sensePct      = sensePct;
+  in.cpuMhz        = getCpuFrequencyMhz();
+  const PowerPolicy::Decision& d = power.update(in, millis());
+  if (d.cpuMhz != in.cpuMhz && setCpuFrequencyMhz(d.cpuMhz)) {
+    DEBUG_PRINT("Power: "); DEBUG_PRINT(d.mode == PowerPolicy::IDLE ? "idle " : "active "); DEBUG_PRINTLN(d.cpuMhz);
+  }
+  g_publishHz = d.publishHz;
+  return d.loopMs;
 }
 
 // ---------------- Wi-Fi, mDNS, AP ----------------
 static void setupWifiEvents() {
+  // Client joins and leaves wake loop() so the power policy reacts at once
   WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t info) {
     DEBUG_PRINT("AP client connected AID="); DEBUG_PRINTLN(info.wifi_ap_staconnected.aid);
+    wakeLoop();
   }, ARDUINO_EVENT_WIFI_AP_STACONNECTED);
   WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t info) {
     DEBUG_PRINT("AP client disconnected AID="); DEBUG_PRINTLN(info.wifi_ap_stadisconnected.aid);
+    wakeLoop();
   }, ARDUINO_EVENT_WIFI_AP_STADISCONNECTED);
+  WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t) {
+    mcast.setInterface(WiFi.localIP());
+    DEBUG_PRINT("Station IP: "); DEBUG_PRINTLN(WiFi.localIP());
+  }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t) {
+    mcast.setInterface(IPAddress());
+  }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+// Joins or leaves the vehicle network per g_sta; the AP stays up either way
+static void applyStation() {
+  StationConfig sta; { StateLock lock; sta = g_sta; }
+  if (sta.enabled && sta.ssid.length()) {
+    WiFi.mode(WIFI_AP_STA);
+    mcast.begin();
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(sta.ssid.c_str(), sta.password.length() ? sta.password.c_str() : nullptr);
+    DEBUG_PRINT("Station joining "); DEBUG_PRINTLN(sta.ssid.c_str());
+  } else if (WiFi.getMode() & WIFI_STA) {
+    mcast.setInterface(IPAddress());
+    WiFi.disconnect(false);
+    WiFi.mode(WIFI_AP);
+  }
 }
 
 static bool startMDNSHost(){
-  String label = mdnsHostLabel();
   MDNS.end();   // end previous instance if any
   delay(10);
-  if (MDNS.begin(label.c_str())) {
+  if (MDNS.begin(g_mdnsLabel.c_str())) {
     MDNS.addService("http","tcp",TL_HTTP_PORT);
-    DEBUG_PRINT("mDNS up: http://"); DEBUG_PRINT(label); DEBUG_PRINTLN(".local");
+    DEBUG_PRINT("mDNS up: http://"); DEBUG_PRINT(g_mdnsLabel.c_str()); DEBUG_PRINTLN(".local");
     return true;
   }
   DEBUG_PRINTLN("mDNS failed");
   return false;
 }
 
-static bool startAP(const String& ssid, const String& pwd) {
+static bool startAP(const char* ssid, const char* pwd) {
   WiFi.mode(WIFI_AP);
-  WiFi.softAPsetHostname(mdnsHostLabel().c_str());
+  WiFi.softAPsetHostname(g_mdnsLabel.c_str());
   WiFi.setTxPower(TL_AP_TX_POWER);
 
   IPAddress ip, gw, mask;
@@ -536,12 +1765,12 @@ static bool startAP(const String& ssid, const String& pwd) {
   mask.fromString(TL_AP_NETMASK);
   WiFi.softAPConfig(ip, gw, mask);
 
-  bool ok = (pwd.length()==0) ? WiFi.softAP(ssid.c_str()) : WiFi.softAP(ssid.c_str(), pwd.c_str());
+  bool ok = (!*pwd) ? WiFi.softAP(ssid) : WiFi.softAP(ssid, pwd);
   apIP = WiFi.softAPIP();
   DEBUG_PRINT("softAP("); DEBUG_PRINT(ssid); DEBUG_PRINT(", ****) -> "); DEBUG_PRINTLN(ok?"OK":"FAIL");
   DEBUG_PRINT("AP IP address: "); DEBUG_PRINTLN(apIP);
 
-  if (ok) { startCaptiveDNS(); startMDNSHost(); }
+  if (ok) { startCaptiveDNS(); startMDNSHost(); applyStation(); }
   return ok;
 }
 
@@ -551,17 +1780,73 @@ static void setupWifi() {
   String ssid = prefs.getString("ssid", TL_DEFAULT_SSID);
   String password = prefs.getString("password", TL_DEFAULT_PASSWORD);
   prefs.end();
-  startAP(ssid, password);
+  prefs.begin("sta", true);
+  g_sta.enabled  = prefs.getBool("enabled", false);
+  g_sta.ssid     = prefs.getString("ssid", "").c_str();
+  g_sta.password = prefs.getString("password", "").c_str();
+  mcast.setRate(prefs.getUShort("rate", TL_MCAST_DEFAULT_HZ));
+  prefs.end();
+  startAP(ssid.c_str(), password.c_str());
 }
 
+// ---------------- Route table ----------------
+// Declared once: path, methods, handler, policy. API routes get CORS (OPTIONS
+// preflight is answered from this table) and persistent connections; captive
+// probes close after the redirect. Compiled into a perfect-hash dispatcher.
+static constexpr uint32_t M_GET = methodBit(HTTP_GET), M_POST = methodBit(HTTP_POST);
+static constexpr uint8_t API = ROUTE_CORS | ROUTE_KEEPALIVE;
+
+static constexpr Route kRoutes[] = {
+  // API
+  { "/sensor",            M_GET,          handleSensor,           API },
+  { "/stream",            M_GET,          handleStream,           ROUTE_CORS },
+  { "/time",              M_GET,          handleTime,             API },
+  { "/calibrate",         M_POST,         handleCalibrate,        API },
+  { "/calibration",       M_GET,          handleGetCalibration,   API },
+  { "/calibration/reset", M_POST,         handleResetCalibration, API },
+  { "/calibrate/accel",   M_GET | M_POST, handleAccelCalibration, API },
+  { "/orientation",       M_GET | M_POST, handleOrientation,      API },
+  { "/wifi",              M_POST,         handleWifiUpdate,       API },
+  { "/station",           M_GET | M_POST, handleStation,          API },
+  { "/spectrum",          M_GET,          handleSpectrum,         API },
+  { "/sway",              M_GET | M_POST, handleSway,             API },
+  { "/recorder",          M_GET | M_POST, handleRecorder,         API },
+  { "/recorder/capture",  M_GET,          handleRecorderCapture,  API },
+  { "/profile",           M_GET | M_POST, handleProfile,          API },
+  { "/diag",              M_GET,          handleDiag,             API },
+  { "/update",            M_GET | M_POST, handleUpdate,           ROUTE_UPLOAD, handleUpdateUpload },
+  // Web UI
+  { TL_WEB_UI_PATH,       M_GET,          handleUI,               ROUTE_KEEPALIVE },
+  // Captive probes
+  { "/",                                            METHODS_ANY, redirectAny, 0 },
+  // Android
+  { "/generate_204",                                METHODS_ANY, redirectAny, 0 },
+  { "/gen_204",                                     METHODS_ANY, redirectAny, 0 },
+  { "/google/generate_204",                         METHODS_ANY, redirectAny, 0 },
+  { "/connectivity-check",                          METHODS_ANY, redirectAny, 0 },
+  { "/connectivitycheck.gstatic.com/generate_204",  METHODS_ANY, redirectAny, 0 },
+  // Apple
+  { "/hotspot-detect.html",                         METHODS_ANY, redirectAny, 0 },
+  { "/success.html",                                METHODS_ANY, redirectAny, 0 },
+  { "/library/test/success.html",                   METHODS_ANY, redirectAny, 0 },
+  { "/captive.apple.com",                           METHODS_ANY, redirectAny, 0 },
+  // Windows
+  { "/ncsi.txt",                                    METHODS_ANY, redirectAny, 0 },
+  { "/connecttest.txt",                             METHODS_ANY, redirectAny, 0 },
+  { "/www.msftconnecttest.com/connecttest.txt",     METHODS_ANY, redirectAny, 0 },
+  // Chrome and misc
+  { "/canonical.html",                              METHODS_ANY, redirectAny, 0 },
+};
+static constexpr auto kDispatch = makeDispatcher(kRoutes);
+static_assert(kDispatch.ok, "route table: duplicate path (no perfect hash)");
+
 // ---------------- IMU bring up ----------------
 static bool initIMU() {
-  Wire.setClock(400000);
+  Wire.setClock(TL_I2C_CLOCK_HZ);
   Wire.setTimeOut(1000);
-  byte status = mpu.begin(MPU_ADDR);
-  if (status != 0) { DEBUG_PRINTLN("MPU begin failed"); return false; }
-  for (int i=0;i<30;i++){ mpu.update(); delay(5); }
-  return true;
+  const uint8_t found = imuBus.begin();
+  DEBUG_PRINT("IMUs found: "); DEBUG_PRINTLN(found);
+  return found > 0;
 }
 
 // ---------------- Arduino ----------------
@@ -569,60 +1854,91 @@ void setup() {
 #ifdef DEBUG_SERIAL
   Serial.begin(115200); delay(200);
 #endif
+  g_stateMutex = xSemaphoreCreateMutex();
+  initHostNames();
   Wire.begin(TL_I2C_SDA_PIN, TL_I2C_SCL_PIN); delay(10);
   initIMU();
-
-  float up_loaded[3];
-  if (!loadBasis(up_loaded)) {
-    for (int i=0;i<30;i++){ mpu.update(); delay(5); }
-    float up_s[3] = { mpu.getAccX(), mpu.getAccY(), mpu.getAccZ() };
-    normalize3(up_s); buildBasisFromUpAndHint(up_s); saveBasis(up_s);
+  for (uint8_t i=0;i<TL_IMU_MAX;i++) if (imuBus.present(i)) loadAccelTrim(i);
+  // Before the rest samples below, so the zeros come through the profile's filter
+  if (!applyProfile(loadProfile())) DEBUG_PRINTLN("IMU: profile not applied");
+  DEBUG_PRINT("Profile: "); DEBUG_PRINTLN(g_acq.name);
+  power.setActivePublishHz(g_acq.publishHz);
+  g_publishHz = g_acq.publishHz;
+
+  // Per device: saved basis or one from the current UP, saved zeros or bootstrap
+  RestMean rest[TL_IMU_MAX];
+  sampleAtRest(rest, 30, 5);
+  for (uint8_t i=0;i<TL_IMU_MAX;i++){
+    if (!imuBus.present(i)) continue;
+    float up_loaded[3];
+    if (!loadBasis(i, up_loaded) && rest[i].n) {
+      float up_s[3] = { rest[i].a[0], rest[i].a[1], rest[i].a[2] };
+      normalize3(up_s); buildBasisFromUpAndHint(g_imu[i], up_s); saveBasis(i, up_s);
+    }
+    loadOrBootstrapCalibration(i, rest[i]);
   }
+  loadSwayConfig();
+  loadRecorderConfig();
 
-  loadOrBootstrapCalibration();
   setupWifi();
 
-  // API routes
-  server.on("/sensor", HTTP_GET, handleSensor);
-  server.on("/calibrate", HTTP_POST, handleCalibrate);
-  server.on("/calibration", HTTP_GET, handleGetCalibration);
-  server.on("/calibration/reset", HTTP_POST, handleResetCalibration);
-  server.on("/orientation", HTTP_GET, handleOrientation);
-  server.on("/orientation", HTTP_POST, handleOrientation);
-  server.on("/wifi", HTTP_POST, handleWifiUpdate);
-
-  // Web UI
-  server.on(TL_WEB_UI_PATH, HTTP_GET, [=](){ server.send_P(200, "text/html", INDEX_HTML); });
-
-  // CORS preflight
-  server.on("/sensor", HTTP_OPTIONS, [](){ addCORS(); server.send(204); });
-  server.on("/calibrate", HTTP_OPTIONS, [](){ addCORS(); server.send(204); });
-  server.on("/calibration", HTTP_OPTIONS, [](){ addCORS(); server.send(204); });
-  server.on("/calibration/reset", HTTP_OPTIONS, [](){ addCORS(); server.send(204); });
-  server.on("/orientation", HTTP_OPTIONS, [](){ addCORS(); server.send(204); });
-  server.on("/wifi", HTTP_OPTIONS, [](){ addCORS(); server.send(204); });
-
-  // Captive portal + global redirect
-  registerCaptiveRoutes();
+  // Routes come from the constexpr table; anything else gets the captive redirect
+  server.setRoutes([](const char* path){ return kDispatch.find(path); });
+  server.onNotFound(redirectAny);
 
+  // Serves from its own task; loop() no longer calls handleClient()
   server.begin();
+  startTasks();
 }
 
+// Runs on TL_NET_CORE: Wi-Fi housekeeping and the power policy; sampling and
+// DNS have their own tasks
 void loop() {
-  dnsServer.processNextRequest();
-  server.handleClient();
-  mpu.update();
+  const uint32_t t0 = micros();
 
   // Apply pending Wi-Fi change
-  if (g_wifiPending.apply && (int32_t)(millis()-g_wifiPending.at_ms)>=0){
-    g_wifiPending.apply=false;
+  WifiPending pending;
+  if (g_wifiPending.apply) {
+    StateLock lock;
+    if (g_wifiPending.apply && (int32_t)(millis()-g_wifiPending.at_ms)>=0){ pending = g_wifiPending; g_wifiPending.apply=false; }
+  }
+  if (pending.apply){
     MDNS.end();
     WiFi.softAPdisconnect(true);
     delay(150);
-    if (!startAP(g_wifiPending.ssid, g_wifiPending.password)) {
+    if (!startAP(pending.ssid.c_str(), pending.password.c_str())) {
       WiFi.softAPdisconnect(true);
       delay(150);
       startAP(TL_DEFAULT_SSID, TL_DEFAULT_PASSWORD);
     }
   }
+  bool staPending = false;
+  if (g_staPending) { StateLock lock; staPending = g_staPending; g_staPending = false; }
+  if (staPending) applyStation();
+  if (g_acqPending) {
+    uint8_t hz;
+    { StateLock lock; hz = g_acq.publishHz; g_acqPending = false; }
+    power.setActivePublishHz(hz);
+  }
+
+  // Freeze a completed recorder window off the sense task
+  recorder.service();
+
+  static uint32_t lastHeapMs = 0;
+  if ((uint32_t)(millis() - lastHeapMs) >= 1000) {
+    lastHeapMs = millis();
+    const uint32_t largest = ESP.getMaxAllocHeap();
+    if (!g_heapLargestBoot) g_heapLargestBoot = largest;
+    if (largest < g_heapLargestMin) g_heapLargestMin = largest;
+  }
+
+  // Reboot into a freshly written image; confirm this one once the sense task is ticking
+  static uint32_t lastSenseBusy = 0;
+  const uint32_t senseBusy = g_senseLoad.busyUs;
+  ota.service(millis(), senseBusy != lastSenseBusy);
+  lastSenseBusy = senseBusy;
+
+  const uint16_t loopMs = applyPower();
+  g_loopLoad.add(micros() - t0);
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(loopMs));   // Wi-Fi client events cut this short
 }
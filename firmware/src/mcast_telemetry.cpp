@@ -0,0 +1,54 @@
+// mcast_telemetry.cpp : UDP multicast telemetry sender (see mcast_telemetry.h)
+
+#include "mcast_telemetry.h"
+
+#include <lwip/sockets.h>
+
+bool McastTelemetry::begin() {
+  if (_fd >= 0) return true;
+  int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd < 0) { log_e("mcast: socket() failed"); return false; }
+  uint8_t ttl = TL_MCAST_TTL;
+  setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+  uint8_t loop = 0;
+  setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  _group = inet_addr(TL_MCAST_GROUP);
+  _fd = fd;
+  return true;
+}
+
+void McastTelemetry::setInterface(IPAddress ip) {
+  if (_fd < 0 || (uint32_t)ip == 0) { _up.store(false, std::memory_order_relaxed); return; }
+  struct in_addr ifa = {};
+  ifa.s_addr = (uint32_t)ip;   // IPAddress holds network byte order
+  if (setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &ifa, sizeof(ifa)) != 0) {
+    log_e("mcast: IP_MULTICAST_IF failed");
+    _up.store(false, std::memory_order_relaxed);
+    return;
+  }
+  _stats.linkUps++;
+  _up.store(true, std::memory_order_relaxed);
+}
+
+void McastTelemetry::setRate(uint16_t hz) {
+  _rateHz = hz < 1 ? 1 : hz > TL_SAMPLE_HZ ? TL_SAMPLE_HZ : hz;
+}
+
+bool McastTelemetry::due(uint32_t nowMs) {
+  if (!up() || (int32_t)(nowMs - _nextMs) < 0) return false;
+  _nextMs = nowMs + 1000 / _rateHz;
+  return true;
+}
+
+void McastTelemetry::send(const TelemetryPacket& pkt) {
+  if (_fd < 0) return;
+  uint8_t buf[TelemetryPacket::kLen];
+  pkt.encode(buf);
+  struct sockaddr_in dst = {};
+  dst.sin_family = AF_INET;
+  dst.sin_port = htons(TL_MCAST_PORT);
+  dst.sin_addr.s_addr = _group;
+  if (sendto(_fd, buf, sizeof(buf), 0, (struct sockaddr*)&dst, sizeof(dst)) == (int)sizeof(buf)) _stats.sent++;
+  else _stats.errors++;
+}
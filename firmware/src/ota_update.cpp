@@ -0,0 +1,107 @@
+// ota_update.cpp : streamed firmware update (see ota_update.h)
+
+#include "ota_update.h"
+
+#include <Update.h>
+#include <esp_ota_ops.h>
+
+static bool isMd5Hex(const char* s) {
+  size_t n = 0;
+  for (; s[n]; ++n) if (!isxdigit((unsigned char)s[n])) return false;
+  return n == 32;
+}
+
+OtaUpdate::Begin OtaUpdate::begin(size_t size, const char* md5hex) {
+  if (_state != IDLE) return BUSY;
+  if (!md5hex || !isMd5Hex(md5hex)) return BAD_MD5;
+  const esp_partition_t* slot = esp_ota_get_next_update_partition(nullptr);
+  if (!slot) return NO_SLOT;
+  if (size > slot->size) return TOO_LARGE;
+
+  _last = Result();
+  _last.size = size;
+  if (!Update.begin(size, U_FLASH)) { _last.error = Update.errorString(); return FLASH_ERROR; }
+  Update.setMD5(md5hex);
+  _stats.attempts++;
+  _startMs = millis(); _flashUs = 0;
+  _state = RECEIVING;
+  return BEGUN;
+}
+
+bool OtaUpdate::write(const uint8_t* buf, size_t len) {
+  if (_state != RECEIVING) return false;
+  const uint32_t t0 = micros();
+  const size_t w = Update.write(const_cast<uint8_t*>(buf), len);
+  _flashUs += micros() - t0;
+  _last.bytes += w;
+  if (w != len) { fail(Update.errorString()); return false; }
+  return true;
+}
+
+bool OtaUpdate::end() {
+  if (_state != RECEIVING) return false;
+  const uint32_t t0 = micros();
+  const bool ok = Update.end();   // MD5 check, then esp_ota_set_boot_partition
+  _flashUs += micros() - t0;
+  if (!ok) { fail(Update.errorString()); return false; }
+  _last.ok = true;
+  _last.ms = millis() - _startMs;
+  _last.flashMs = _flashUs / 1000;
+  _stats.ok++;
+  _rebootAtMs = millis() + TL_OTA_REBOOT_DELAY_MS;   // lets the 200 reach the client
+  _state = REBOOTING;
+  return true;
+}
+
+void OtaUpdate::abort(const char* why) {
+  if (_state == RECEIVING) fail(why);
+}
+
+void OtaUpdate::fail(const char* why) {
+  if (Update.isRunning()) Update.abort();
+  _last.ok = false;
+  _last.error = why;
+  _last.ms = millis() - _startMs;
+  _last.flashMs = _flashUs / 1000;
+  _stats.failed++;
+  _state = IDLE;
+}
+
+void OtaUpdate::service(uint32_t nowMs, bool healthy) {
+  if (_state == REBOOTING && (int32_t)(nowMs - _rebootAtMs) >= 0) ESP.restart();
+  if (_confirmed || !healthy || nowMs < TL_OTA_CONFIRM_MS) return;
+  esp_ota_img_states_t st;
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &st) == ESP_OK && st == ESP_OTA_IMG_PENDING_VERIFY) {
+    if (esp_ota_mark_app_valid_cancel_rollback() != ESP_OK) return;
+    log_i("ota: running image confirmed");
+  }
+  _confirmed = true;
+}
+
+const char* OtaUpdate::running() {
+  const esp_partition_t* p = esp_ota_get_running_partition();
+  return p ? p->label : "?";
+}
+
+const char* OtaUpdate::imageState() {
+  esp_ota_img_states_t st;
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &st) != ESP_OK) return "factory";
+  switch (st) {
+    case ESP_OTA_IMG_NEW:            return "new";
+    case ESP_OTA_IMG_PENDING_VERIFY: return "pending_verify";
+    case ESP_OTA_IMG_VALID:          return "valid";
+    case ESP_OTA_IMG_INVALID:        return "invalid";
+    case ESP_OTA_IMG_ABORTED:        return "aborted";
+    default:                         return "undefined";
+  }
+}
+
+const char* OtaUpdate::rolledBackFrom() {
+  const esp_partition_t* p = esp_ota_get_last_invalid_partition();
+  return p ? p->label : nullptr;
+}
+
+size_t OtaUpdate::slotSize() {
+  const esp_partition_t* p = esp_ota_get_next_update_partition(nullptr);
+  return p ? p->size : 0;
+}
@@ -0,0 +1,52 @@
+// power_policy.cpp : presence-driven CPU clock and work policy (see power_policy.h)
+
+#include "power_policy.h"
+
+const PowerPolicy::Decision& PowerPolicy::update(const Inputs& in, uint32_t nowMs) {
+  if (!_started) {
+    // Boot counts as presence: someone just powered the unit
+    _started = true;
+    _requests = in.requests;
+    _seenMs = _sinceMs = _lastMs = nowMs;
+    enter(ACTIVE, nowMs);
+    _stats.toActive = 0;
+  }
+
+  const uint32_t dt = nowMs - _lastMs;
+  (_dec.mode == IDLE ? _stats.idleMs : _stats.activeMs) += dt;
+  _lastMs = nowMs;
+
+  const bool present = in.apClients > 0 || in.subscribers > 0 || in.stationLinked || in.requests != _requests;
+  _requests = in.requests;
+  if (present) _seenMs = nowMs;
+
+  if (present) {
+    if (_dec.mode != ACTIVE) enter(ACTIVE, nowMs);
+    return _dec;
+  }
+  if (_dec.mode == IDLE || (uint32_t)(nowMs - _seenMs) < _cfg.idleAfterMs) return _dec;
+
+  // Load scales with the clock: what the sense task measured at cpuMhz
+  // becomes sensePct * cpuMhz / idleMhz at the idle clock
+  const float atIdle = in.cpuMhz ? in.sensePct * (float)in.cpuMhz / (float)_cfg.idleMhz : in.sensePct;
+  if (atIdle > _cfg.senseMaxPct) { _stats.refused++; _seenMs = nowMs; return _dec; }
+  enter(IDLE, nowMs);
+  return _dec;
+}
+
+void PowerPolicy::enter(Mode m, uint32_t nowMs) {
+  _dec.mode = m;
+  if (m == ACTIVE) {
+    _dec.cpuMhz = _cfg.activeMhz; _dec.publishHz = _cfg.activePublishHz; _dec.loopMs = _cfg.activeLoopMs;
+    _stats.toActive++;
+  } else {
+    _dec.cpuMhz = _cfg.idleMhz; _dec.publishHz = _cfg.idlePublishHz; _dec.loopMs = _cfg.idleLoopMs;
+    _stats.toIdle++;
+  }
+  _sinceMs = nowMs;
+}
+
+void PowerPolicy::setActivePublishHz(uint8_t hz) {
+  _cfg.activePublishHz = hz;
+  if (_dec.mode == ACTIVE) _dec.publishHz = hz;
+}
@@ -0,0 +1,124 @@
+// spectrum.cpp : windowed FFT analysis (see spectrum.h)
+
+#include "spectrum.h"
+
+#if defined(ESP_PLATFORM) && __has_include(<esp_dsp.h>)
+  #include <esp_dsp.h>
+  #define TL_FFT_ESP_DSP 1
+#else
+  #include "fft_kernel.h"
+  #define TL_FFT_ESP_DSP 0
+  static float s_twiddle[TL_FFT_N];
+#endif
+
+static float s_ampScale[2];   // single-sided amplitude: [0] DC/Nyquist, [1] other bins
+
+const char* SpectrumAnalyzer::kernel() { return TL_FFT_ESP_DSP ? "esp-dsp" : "portable"; }
+
+bool SpectrumAnalyzer::begin() {
+  float wsum = 0;
+  for (size_t i = 0; i < TL_FFT_N; ++i) {
+    _window[i] = 0.5f - 0.5f * cosf(2.0f * PI * (float)i / (float)TL_FFT_N);   // periodic Hann
+    wsum += _window[i];
+  }
+  s_ampScale[0] = 1.0f / wsum;
+  s_ampScale[1] = 2.0f / wsum;
+#if TL_FFT_ESP_DSP
+  if (dsps_fft2r_init_fc32(nullptr, TL_FFT_N) != ESP_OK) { log_e("spectrum: esp-dsp init failed"); return false; }
+#else
+  fftTwiddles(s_twiddle, TL_FFT_N);
+#endif
+  _resultMutex = xSemaphoreCreateMutex();
+  return _resultMutex != nullptr;
+}
+
+void SpectrumAnalyzer::push(float lateral, float rollRate, float yawRate) {
+  _ring[LATERAL][_head]   = lateral;
+  _ring[ROLL_RATE][_head] = rollRate;
+  _ring[YAW_RATE][_head]  = yawRate;
+  _head = (_head + 1) & (TL_FFT_N - 1);
+  if (_filled < TL_FFT_N) _filled++;
+  _sinceRun++;
+}
+
+// Oldest sample first, mean removed (DC leakage would mask low-frequency sway), windowed
+void SpectrumAnalyzer::loadPair(Channel re, Channel im) {
+  float meanRe = 0, meanIm = 0;
+  for (size_t i = 0; i < TL_FFT_N; ++i) {
+    meanRe += _ring[re][i];
+    if (im < CHANNELS) meanIm += _ring[im][i];
+  }
+  meanRe /= TL_FFT_N; meanIm /= TL_FFT_N;
+  for (size_t i = 0; i < TL_FFT_N; ++i) {
+    const size_t j = (_head + i) & (TL_FFT_N - 1);
+    _buf[2 * i]     = (_ring[re][j] - meanRe) * _window[i];
+    _buf[2 * i + 1] = im < CHANNELS ? (_ring[im][j] - meanIm) * _window[i] : 0.0f;
+  }
+}
+
+void SpectrumAnalyzer::transform() {
+#if TL_FFT_ESP_DSP
+  dsps_fft2r_fc32(_buf, TL_FFT_N);
+  dsps_bit_rev_fc32(_buf, TL_FFT_N);
+#else
+  fftBitReverse(_buf, TL_FFT_N);
+  fftRadix2(_buf, TL_FFT_N, s_twiddle);
+#endif
+}
+
+// Largest bin in [minHz, maxHz] (DC excluded), refined with the Hann
+// two-bin ratio estimate: offset d = (2r - 1) / (r + 1) towards the larger
+// neighbour, amplitude corrected for the window's scalloping at d
+SpectrumAnalyzer::Peak SpectrumAnalyzer::findPeak(const float* amp, float minHz, float maxHz) const {
+  Peak p;
+  size_t lo = (size_t)ceilf(minHz / binHz()), hi = (size_t)floorf(maxHz / binHz());
+  if (lo < 1) lo = 1;
+  if (hi > kBins - 2) hi = kBins - 2;
+  if (lo > hi) return p;
+  size_t k = lo;
+  for (size_t i = lo + 1; i <= hi; ++i) if (amp[i] > amp[k]) k = i;
+  const float b = amp[k];
+  if (b <= 0) return p;
+  const float side = amp[k + 1] >= amp[k - 1] ? 1.0f : -1.0f;
+  const float r = (side > 0 ? amp[k + 1] : amp[k - 1]) / b;
+  const float d = side * fmaxf(0.0f, (2.0f * r - 1.0f) / (r + 1.0f));   // r < 0.5: noise, stay on bin
+  const float x = PI * fabsf(d);
+  p.hz = ((float)k + d) * binHz();
+  p.amp = x > 1e-4f ? b * x * (1.0f - d * d) / sinf(x) : b;
+  return p;
+}
+
+void SpectrumAnalyzer::compute() {
+  if (!due()) return;
+  if (xSemaphoreTake(_resultMutex, 0) != pdTRUE) { _stats.deferred++; return; }
+  const uint32_t t0 = micros();
+
+  loadPair(LATERAL, ROLL_RATE);
+  transform();
+  fftSplitPair(_buf, TL_FFT_N, _amp[LATERAL], _amp[ROLL_RATE]);
+  loadPair(YAW_RATE, CHANNELS);
+  transform();
+  fftSplitPair(_buf, TL_FFT_N, _amp[YAW_RATE], nullptr);
+
+  const float nyquist = 0.5f * (float)TL_SAMPLE_HZ;
+  for (int c = 0; c < CHANNELS; ++c) {
+    float* a = _amp[c];
+    a[0] *= s_ampScale[0]; a[kBins - 1] *= s_ampScale[0];
+    for (size_t k = 1; k < kBins - 1; ++k) a[k] *= s_ampScale[1];
+    _dom[c] = findPeak(a, binHz(), nyquist);
+  }
+  _sway = findPeak(_amp[LATERAL], TL_SWAY_MIN_HZ, TL_SWAY_MAX_HZ);
+  _resultMs = millis();
+  _sinceRun = 0;
+  xSemaphoreGive(_resultMutex);
+
+  const uint32_t us = micros() - t0;
+  _stats.runs++; _stats.lastUs = us; _stats.sumUs += us;
+  if (us > _stats.maxUs) _stats.maxUs = us;
+}
+
+bool SpectrumAnalyzer::lockResult(uint32_t waitMs) {
+  return _resultMutex && xSemaphoreTake(_resultMutex, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+}
+
+void SpectrumAnalyzer::unlockResult() { xSemaphoreGive(_resultMutex); }
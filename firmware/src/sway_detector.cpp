@@ -0,0 +1,85 @@
+// sway_detector.cpp : streaming Goertzel sway detector (see sway_detector.h)
+
+#include "sway_detector.h"
+
+void SwayDetector::begin(float sampleHz) {
+  _r = expf(-1.0f / (TL_SWAY_ALERT_TAU_S * sampleHz));
+  _ampScale = 2.0f * (1.0f - _r);
+  _dcAlpha = 1.0f - expf(-1.0f / (TL_SWAY_ALERT_DC_TAU_S * sampleHz));
+  for (int i = 0; i < kBins; ++i) {
+    _hz[i] = TL_SWAY_ALERT_MIN_HZ + (TL_SWAY_ALERT_MAX_HZ - TL_SWAY_ALERT_MIN_HZ) * i / (kBins > 1 ? kBins - 1 : 1);
+    const float w = 2.0f * PI * _hz[i] / sampleHz;
+    for (int c = 0; c < CHANNELS; ++c) _res[c][i] = Resonator{ 2.0f * _r * cosf(w), _r * _r, 0, 0 };
+  }
+}
+
+// |z|^2 of z = y[n] - r e^{-jw} y[n-1]:  y1^2 + r^2 y2^2 - 2 r cos(w) y1 y2
+static inline float power(float y1, float y2, float c, float r2) { return y1 * y1 + r2 * y2 * y2 - c * y1 * y2; }
+
+float SwayDetector::amplitude(Channel ch, int i) const {
+  const Resonator& q = _res[ch][i];
+  const float p = power(q.y1, q.y2, q.c, q.r2);
+  return p > 0 ? _ampScale * sqrtf(p) : 0.0f;
+}
+
+void SwayDetector::push(float yawRate, float lateral, uint32_t nowMs) {
+  const uint32_t c0 = ESP.getCycleCount();
+  const float in[CHANNELS] = { yawRate, lateral };
+  for (int c = 0; c < CHANNELS; ++c) {
+    _dc[c] += _dcAlpha * (in[c] - _dc[c]);
+    const float x = in[c] - _dc[c];
+    float best = 0; int bestBin = 0;
+    for (int i = 0; i < kBins; ++i) {
+      Resonator& q = _res[c][i];
+      const float y = x + q.c * q.y1 - q.r2 * q.y2;
+      q.y2 = q.y1; q.y1 = y;
+      const float p = power(q.y1, q.y2, q.c, q.r2);
+      if (p > best) { best = p; bestBin = i; }
+    }
+    _peak2[c] = best; _peakBin[c] = bestBin;
+  }
+  detect(nowMs);
+  const uint32_t cyc = ESP.getCycleCount() - c0;
+  _stats.samples++; _stats.cycles += cyc;
+  if (cyc > _stats.maxCycles) _stats.maxCycles = cyc;
+}
+
+void SwayDetector::detect(uint32_t nowMs) {
+  const float yaw = _ampScale * sqrtf(_peak2[YAW]);
+  const float lat = _ampScale * sqrtf(_peak2[LATERAL]);
+  _state.yawDps = yaw; _state.latG = lat;
+  _state.hz = _hz[(yaw / _cfg.yawDps >= lat / _cfg.latG) ? _peakBin[YAW] : _peakBin[LATERAL]];
+
+  const bool over  = yaw >= _cfg.yawDps || lat >= _cfg.latG;
+  const bool under = yaw < 0.7f * _cfg.yawDps && lat < 0.7f * _cfg.latG;
+  if (over && !_over) _overSinceMs = nowMs;
+  if (under && !_under) _underSinceMs = nowMs;
+  _over = over; _under = under;
+
+  if (!_state.active) {
+    if (over && nowMs - _overSinceMs >= _cfg.holdMs) {
+      _state.active = true;
+      _state.sinceMs = _overSinceMs;
+      _state.alerts++;
+      Event& e = _log[_logHead];
+      e = Event{ _overSinceMs, 0, _state.hz, yaw, lat };
+      _logHead = (_logHead + 1) % TL_SWAY_ALERT_LOG_LEN;
+      if (_logLen < TL_SWAY_ALERT_LOG_LEN) _logLen++;
+      log_w("sway alert at %lu ms: %.2f Hz, yaw %.1f dps, lateral %.3f g", (unsigned long)_overSinceMs, _state.hz, yaw, lat);
+    }
+    return;
+  }
+
+  Event& e = _log[(_logHead + TL_SWAY_ALERT_LOG_LEN - 1) % TL_SWAY_ALERT_LOG_LEN];
+  if (yaw > e.yawDps) { e.yawDps = yaw; e.hz = _state.hz; }
+  if (lat > e.latG) e.latG = lat;
+  if (under && nowMs - _underSinceMs >= _cfg.holdMs) {
+    _state.active = false;
+    e.endMs = nowMs;
+    log_w("sway cleared at %lu ms (%lu ms)", (unsigned long)nowMs, (unsigned long)(nowMs - e.startMs));
+  }
+}
+
+const SwayDetector::Event& SwayDetector::logAt(size_t i) const {
+  return _log[(_logHead + TL_SWAY_ALERT_LOG_LEN - _logLen + i) % TL_SWAY_ALERT_LOG_LEN];
+}
@@ -0,0 +1,60 @@
+// bench_fft.cpp : cost of the portable FFT path (fft_kernel.h, spectrum.cpp)
+// - Kernel: bit reversal + radix-2 + real-pair split per transform size
+// - SpectrumAnalyzer::compute(): both transforms, scaling and the four peak
+//   searches for the three channels at TL_FFT_N, and the share of one core
+//   that is at TL_SPECTRUM_HZ
+// - Host figures; the target runs esp-dsp where it is available and reports
+//   its own cost in /diag "spectrum"
+//
+// Sources: ../../src/spectrum.cpp stubs/arduino_host.cpp
+
+#include "spectrum.h"
+#include "fft_kernel.h"
+
+#include <chrono>
+#include <vector>
+
+#include "host_test.h"
+
+static double usSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main() {
+  printf("kernel (one complex transform + real-pair split)\n");
+  for (size_t n = 128; n <= 2048; n <<= 1) {
+    std::vector<float> d(2 * n), src(2 * n), tw(n), mx(n / 2 + 1), my(n / 2 + 1);
+    fftTwiddles(tw.data(), n);
+    for (size_t i = 0; i < 2 * n; ++i) src[i] = sinf(0.37f * i);
+    const int reps = (int)(2000000 / n);
+    float sink = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      std::copy(src.begin(), src.end(), d.begin());
+      fftBitReverse(d.data(), n);
+      fftRadix2(d.data(), n, tw.data());
+      fftSplitPair(d.data(), n, mx.data(), my.data());
+      sink += mx[n / 4];
+    }
+    const double us = usSince(t0) / reps;
+    printf("  n=%-5zu %8.2f us  (%.2f ns per n log2 n)\n", n, us, 1000 * us / (n * log2((double)n)));
+    CHECK(sink == sink && us > 0);
+  }
+
+  printf("SpectrumAnalyzer::compute(), N=%d, 3 channels (kernel %s)\n", TL_FFT_N, SpectrumAnalyzer::kernel());
+  static SpectrumAnalyzer s;
+  CHECK(s.begin());
+  for (int i = 0; i < TL_FFT_N; ++i) s.push(sinf(0.1f * i), cosf(0.2f * i), sinf(0.3f * i));
+  constexpr int kRuns = 2000;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRuns; ++r) {
+    for (uint32_t j = 0; j < TL_SAMPLE_HZ / TL_SPECTRUM_HZ; ++j) s.push(0.01f * j, 0, 0);
+    s.compute();
+  }
+  const double us = usSince(t0) / kRuns;
+  const SpectrumAnalyzer::Stats& st = s.stats();
+  printf("  %.1f us per spectrum (stats avg %.1f us, max %u us), %.4f%% of a core at %d Hz\n",
+         us, (double)st.sumUs / st.runs, (unsigned)st.maxUs, us * TL_SPECTRUM_HZ / 1e4, TL_SPECTRUM_HZ);
+  CHECK(st.runs == (uint32_t)kRuns && st.deferred == 0);
+  return testExit();
+}
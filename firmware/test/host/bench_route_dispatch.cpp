@@ -0,0 +1,97 @@
+// bench_route_dispatch.cpp : route lookup cost, perfect hash vs. the old linear handler walk
+// - "after": makeDispatcher() over the same paths as kRoutes in main.cpp
+// - "before": the handler list the WebServer-based firmware registered (14
+//   captive probes, then the API routes and one OPTIONS handler per API path),
+//   matched the way WebServer does: method (or HTTP_ANY), then the URI string
+// - Lookups per class: an API poll, a late-registered API path, a captive
+//   probe, a path nobody serves (walks the whole list before onNotFound)
+// - Checks that every path resolves to its own entry and misses miss; the
+//   timings are host figures, the ratio is what carries over to the target
+//
+// Sources:
+
+#include "route_table.h"
+
+#include <chrono>
+#include <initializer_list>
+
+#include "host_test.h"
+
+static void h() {}
+
+static constexpr uint32_t M_GET = methodBit(HTTP_GET), M_POST = methodBit(HTTP_POST);
+static constexpr uint8_t API = ROUTE_CORS | ROUTE_KEEPALIVE;
+// Keep in step with kRoutes in main.cpp
+static constexpr Route kRoutes[] = {
+  { "/sensor", M_GET, h, API }, { "/stream", M_GET, h, ROUTE_CORS }, { "/time", M_GET, h, API },
+  { "/calibrate", M_POST, h, API }, { "/calibration", M_GET, h, API }, { "/calibration/reset", M_POST, h, API },
+  { "/calibrate/accel", M_GET | M_POST, h, API }, { "/orientation", M_GET | M_POST, h, API },
+  { "/wifi", M_POST, h, API }, { "/station", M_GET | M_POST, h, API }, { "/spectrum", M_GET, h, API },
+  { "/sway", M_GET | M_POST, h, API }, { "/recorder", M_GET | M_POST, h, API },
+  { "/recorder/capture", M_GET, h, API }, { "/profile", M_GET | M_POST, h, API }, { "/diag", M_GET, h, API },
+  { "/update", M_GET | M_POST, h, ROUTE_UPLOAD, h }, { "/ui", M_GET, h, ROUTE_KEEPALIVE },
+  { "/", METHODS_ANY, h, 0 }, { "/generate_204", METHODS_ANY, h, 0 }, { "/gen_204", METHODS_ANY, h, 0 },
+  { "/google/generate_204", METHODS_ANY, h, 0 }, { "/connectivity-check", METHODS_ANY, h, 0 },
+  { "/connectivitycheck.gstatic.com/generate_204", METHODS_ANY, h, 0 }, { "/hotspot-detect.html", METHODS_ANY, h, 0 },
+  { "/success.html", METHODS_ANY, h, 0 }, { "/library/test/success.html", METHODS_ANY, h, 0 },
+  { "/captive.apple.com", METHODS_ANY, h, 0 }, { "/ncsi.txt", METHODS_ANY, h, 0 },
+  { "/connecttest.txt", METHODS_ANY, h, 0 }, { "/www.msftconnecttest.com/connecttest.txt", METHODS_ANY, h, 0 },
+  { "/canonical.html", METHODS_ANY, h, 0 },
+};
+static constexpr auto kDispatch = makeDispatcher(kRoutes);
+static_assert(kDispatch.ok, "duplicate path");
+
+// The old registration order: server.on(uri, method, fn) per handler
+struct OldHandler { const char* uri; HTTPMethod method; };
+static const OldHandler kOld[] = {
+  { "/", HTTP_ANY }, { "/generate_204", HTTP_ANY }, { "/gen_204", HTTP_ANY }, { "/google/generate_204", HTTP_ANY },
+  { "/connectivity-check", HTTP_ANY }, { "/connectivitycheck.gstatic.com/generate_204", HTTP_ANY },
+  { "/hotspot-detect.html", HTTP_ANY }, { "/success.html", HTTP_ANY }, { "/library/test/success.html", HTTP_ANY },
+  { "/captive.apple.com", HTTP_ANY }, { "/ncsi.txt", HTTP_ANY }, { "/connecttest.txt", HTTP_ANY },
+  { "/www.msftconnecttest.com/connecttest.txt", HTTP_ANY }, { "/canonical.html", HTTP_ANY },
+  { "/sensor", HTTP_GET }, { "/calibrate", HTTP_POST }, { "/calibration", HTTP_GET }, { "/calibration/reset", HTTP_POST },
+  { "/orientation", HTTP_GET }, { "/orientation", HTTP_POST }, { "/wifi", HTTP_POST }, { "/ui", HTTP_GET },
+  { "/sensor", HTTP_OPTIONS }, { "/calibrate", HTTP_OPTIONS }, { "/calibration", HTTP_OPTIONS },
+  { "/calibration/reset", HTTP_OPTIONS }, { "/orientation", HTTP_OPTIONS }, { "/wifi", HTTP_OPTIONS },
+};
+
+static const OldHandler* oldLookup(HTTPMethod m, const char* uri) {
+  for (const OldHandler& o : kOld)
+    if ((o.method == HTTP_ANY || o.method == m) && !strcmp(o.uri, uri)) return &o;
+  return nullptr;
+}
+
+// Optimization barrier: the compiler must assume the path changes every call
+template <class F> static double nsPerCall(const char* path, F&& f) {
+  constexpr long kIters = 5000000;
+  const char* volatile p = path;
+  uintptr_t sink = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < kIters; ++i) sink += (uintptr_t)f((const char*)p);
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / kIters;
+  volatile uintptr_t keep = sink; (void)keep;
+  return ns;
+}
+
+int main() {
+  printf("correctness\n");
+  for (const Route& r : kRoutes) CHECK(kDispatch.find(r.path) == &r);
+  for (const char* miss : { "", "/x", "/sensor/", "/Sensor", "/favicon.ico", "/generate_20", "/ui?x" })
+    CHECK(kDispatch.find(miss) == nullptr);
+  printf("  %zu routes in %zu slots, seed %u\n", sizeof(kRoutes) / sizeof(kRoutes[0]), kDispatch.kSlots, (unsigned)kDispatch.seed);
+
+  printf("lookup cost, host ns (the target reports its own as /diag http.dispatch_cycles_avg)\n");
+  const struct { const char* what; const char* path; HTTPMethod m; } cases[] = {
+    { "API poll",        "/sensor",         HTTP_GET },
+    { "late API path",   "/wifi",           HTTP_POST },
+    { "captive probe",   "/canonical.html", HTTP_GET },
+    { "unknown path",    "/favicon.ico",    HTTP_GET },
+  };
+  for (const auto& c : cases) {
+    const double before = nsPerCall(c.path, [&](const char* p) { return oldLookup(c.m, p); });
+    const double after = nsPerCall(c.path, [](const char* p) { return kDispatch.find(p); });
+    printf("  %-14s %-16s before %6.1f ns  after %5.1f ns  (%.1fx)\n", c.what, c.path, before, after, before / after);
+    CHECK(after < before);
+  }
+  return testExit();
+}
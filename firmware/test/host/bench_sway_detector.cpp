@@ -0,0 +1,79 @@
+// bench_sway_detector.cpp : SwayDetector (streaming Goertzel bank) cost and behaviour
+// - Scenarios at TL_SAMPLE_HZ with a gyro bias and a 7 Hz vibration on yaw:
+//   quiet, in-band yaw sway, out-of-band yaw tone, lateral-only sway. Checks
+//   that alerts raise and clear where they should and the log records them
+// - A steady in-band tone reads its own amplitude on the nearest bin
+// - push() cost per sample (2 channels x TL_SWAY_ALERT_BINS, detection
+//   included), wall clock and from the detector's own cycle stats (host
+//   cycles are 240 MHz equivalents, see stubs/Arduino.h)
+//
+// Sources: ../../src/sway_detector.cpp stubs/arduino_host.cpp
+
+#include "sway_detector.h"
+
+#include <chrono>
+
+#include "host_test.h"
+
+static SwayDetector g_det;
+static uint32_t g_ms = 0;
+static uint32_t g_raised = 0, g_cleared = 0;
+
+// secs of yaw = bias + yawA sin(2 pi f t) + vibration, lateral = latA sin(...) + tilt
+static void run(double secs, double hz, double yawA, double latA, double bias) {
+  for (int i = 0; i < secs * TL_SAMPLE_HZ; ++i, g_ms += 1000 / TL_SAMPLE_HZ) {
+    const double t = g_ms / 1000.0;
+    const bool was = g_det.state().active;
+    g_det.push((float)(bias + yawA * sin(2 * M_PI * hz * t) + 0.3 * sin(2 * M_PI * 7 * t)),
+               (float)(0.02 + latA * sin(2 * M_PI * hz * t + 1)), g_ms);
+    if (g_det.state().active != was) (was ? g_cleared : g_raised)++;
+  }
+}
+
+int main() {
+  g_det.begin(TL_SAMPLE_HZ);
+  printf("scenarios\n");
+  run(10, 1.0, 0, 0, 1.5);
+  printf("  quiet, 1.5 dps bias: yaw %.2f dps, lat %.3f g\n", g_det.state().yawDps, g_det.state().latG);
+  CHECK(g_raised == 0 && g_det.state().yawDps < 0.5f * TL_SWAY_ALERT_YAW_DPS);
+
+  run(12, 1.0, 6, 0.04, 1.5);
+  printf("  1.0 Hz yaw 6 dps: active %d, %.2f Hz, yaw %.2f dps\n", g_det.state().active, g_det.state().hz, g_det.state().yawDps);
+  CHECK(g_raised == 1 && g_det.state().active);
+  CHECK_NEAR(g_det.state().hz, 1.0, 0.01);
+  CHECK_NEAR(g_det.state().yawDps, 6.0, 0.3);   // a steady tone reads its own amplitude
+
+  run(15, 1.0, 0, 0, 1.5);
+  CHECK(g_cleared == 1 && !g_det.state().active);
+
+  run(10, 3.0, 8, 0, 1.5);
+  printf("  3 Hz yaw 8 dps (out of band): yaw %.2f dps\n", g_det.state().yawDps);
+  CHECK(g_raised == 1);
+
+  run(10, 1.25, 0, 0.08, 0);
+  printf("  1.25 Hz lateral 0.08 g: active %d, %.2f Hz, lat %.3f g\n", g_det.state().active, g_det.state().hz, g_det.state().latG);
+  CHECK(g_raised == 2 && g_det.state().active);
+  CHECK_NEAR(g_det.state().hz, 1.25, 0.01);
+  run(15, 1.0, 0, 0, 0);
+  CHECK(g_cleared == 2);
+
+  CHECK(g_det.logCount() == 2);
+  for (size_t i = 0; i < g_det.logCount(); ++i) {
+    const SwayDetector::Event& e = g_det.logAt(i);
+    printf("  log %zu: %u..%u ms, %.2f Hz, yaw %.2f dps, lat %.3f g\n", i, (unsigned)e.startMs, (unsigned)e.endMs, e.hz, e.yawDps, e.latG);
+    CHECK(e.endMs > e.startMs);
+  }
+
+  printf("push() cost (2 ch x %d bins, detection included)\n", SwayDetector::kBins);
+  SwayDetector d;
+  d.begin(TL_SAMPLE_HZ);
+  constexpr int kSamples = 5000000;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < kSamples; ++i) d.push(sinf(0.01f * i), cosf(0.02f * i), (uint32_t)i * 10);
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / kSamples;
+  const SwayDetector::Stats& st = d.stats();
+  printf("  %.1f ns per sample wall clock; stats avg %.0f cycles (%.1f ns), %.4f%% of a core at %d Hz\n",
+         ns, (double)st.cycles / st.samples, (double)st.cycles / st.samples / 0.24, ns * TL_SAMPLE_HZ / 1e7, TL_SAMPLE_HZ);
+  CHECK(st.samples == (uint32_t)kSamples && st.cycles > 0);
+  return testExit();
+}
@@ -0,0 +1,26 @@
+#pragma once
+// host_test.h : minimal check macros shared by the host tests
+// - CHECK() records a failure and carries on, so one run lists every miss
+// - testExit() prints the tally; return it from main()
+
+#include <stdio.h>
+
+static int g_checks = 0, g_failures = 0;
+
+#define CHECK(cond) do { \
+    ++g_checks; \
+    if (!(cond)) { ++g_failures; printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); } \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tol) do { \
+    ++g_checks; \
+    const double a_ = (a), b_ = (b); \
+    if (!(a_ - b_ <= (tol) && b_ - a_ <= (tol))) { \
+      ++g_failures; printf("  FAIL %s:%d: %s = %g, want %g +- %g\n", __FILE__, __LINE__, #a, a_, b_, (double)(tol)); \
+    } \
+  } while (0)
+
+static inline int testExit() {
+  printf("  %d checks, %d failed\n", g_checks, g_failures);
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+// http_client.h : blocking loopback HTTP/1.1 client for the server tests
+// - Responses are framed by Content-Length; bytes past one response stay
+//   buffered for the next read, so pipelined answers can be taken in order
+// - Every read has a deadline: a server that stops answering fails the test
+//   instead of hanging it
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+// A port nothing listens on right now (bound to 0, read back, released)
+static inline uint16_t freeLoopbackPort() {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t l = sizeof(a);
+  bind(fd, (sockaddr*)&a, sizeof(a));
+  getsockname(fd, (sockaddr*)&a, &l);
+  close(fd);
+  return ntohs(a.sin_port);
+}
+
+static inline double msSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+struct HttpResponse {
+  int status = 0;
+  std::string head, body;
+
+  // Header value, case-insensitive name; empty if absent
+  std::string header(const char* name) const {
+    const size_t n = strlen(name);
+    for (size_t p = head.find("\r\n"); p != std::string::npos; p = head.find("\r\n", p + 2)) {
+      if (head.size() > p + 2 + n && head[p + 2 + n] == ':' && !strncasecmp(head.c_str() + p + 2, name, n)) {
+        size_t v = p + 3 + n;
+        while (v < head.size() && head[v] == ' ') ++v;
+        return head.substr(v, head.find("\r\n", v) - v);
+      }
+    }
+    return std::string();
+  }
+};
+
+class HttpClient {
+public:
+  explicit HttpClient(uint16_t port, int rcvBuf = 0) {
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvBuf > 0) setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(_fd, (sockaddr*)&a, sizeof(a)) != 0) { close(_fd); _fd = -1; }
+  }
+  ~HttpClient() { if (_fd >= 0) close(_fd); }
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
+
+  bool ok() const { return _fd >= 0; }
+  int fd() const { return _fd; }
+
+  bool sendRaw(const std::string& s) {
+    for (size_t off = 0; off < s.size();) {
+      const ssize_t w = ::send(_fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+      if (w <= 0) return false;
+      off += w;
+    }
+    return true;
+  }
+
+  // One response; false on timeout, close or garbage
+  bool read(HttpResponse& r, int timeoutMs = 2000) {
+    const auto t0 = std::chrono::steady_clock::now();
+    size_t headEnd;
+    while ((headEnd = _buf.find("\r\n\r\n")) == std::string::npos)
+      if (!fill(timeoutMs - (int)msSince(t0))) return false;
+    r.head = _buf.substr(0, headEnd + 2);
+    r.status = r.head.size() > 12 ? atoi(r.head.c_str() + 9) : 0;
+    const size_t len = strtoul(r.header("Content-Length").c_str(), nullptr, 10);
+    while (_buf.size() < headEnd + 4 + len)
+      if (!fill(timeoutMs - (int)msSince(t0))) return false;
+    r.body = _buf.substr(headEnd + 4, len);
+    _buf.erase(0, headEnd + 4 + len);
+    return r.status > 0;
+  }
+
+  // Raw bytes as they come (SSE); false on timeout or close
+  bool readSome(std::string& out, int timeoutMs = 2000) {
+    if (_buf.empty() && !fill(timeoutMs)) return false;
+    out.swap(_buf); _buf.clear();
+    return true;
+  }
+
+  // True once the server has closed (EOF or reset) within timeoutMs; pending data is discarded
+  bool closedByPeer(int timeoutMs = 2000) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (;;) {
+      const int left = timeoutMs - (int)msSince(t0);
+      if (left <= 0) return false;
+      pollfd p = { _fd, POLLIN, 0 };
+      if (poll(&p, 1, left) <= 0) return false;
+      char b[4096];
+      const ssize_t n = recv(_fd, b, sizeof b, 0);
+      if (n <= 0) return true;
+    }
+  }
+
+private:
+  bool fill(int timeoutMs) {
+    if (timeoutMs <= 0) return false;
+    pollfd p = { _fd, POLLIN, 0 };
+    if (poll(&p, 1, timeoutMs) <= 0) return false;
+    char b[4096];
+    const ssize_t n = recv(_fd, b, sizeof b, 0);
+    if (n <= 0) return false;
+    _buf.append(b, n);
+    return true;
+  }
+
+  int _fd = -1;
+  std::string _buf;
+};
+
+// One request on a fresh connection
+static inline HttpResponse httpRequest(uint16_t port, const std::string& req, int timeoutMs = 2000) {
+  HttpResponse r;
+  HttpClient c(port);
+  if (c.ok() && c.sendRaw(req)) c.read(r, timeoutMs);
+  return r;
+}
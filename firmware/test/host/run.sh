@@ -0,0 +1,36 @@
+#!/bin/sh
+# run.sh : builds and runs the host tests and benchmarks in this directory
+# - Each test_*.cpp / bench_*.cpp names the firmware sources it links on a
+#   "// Sources:" line (relative to this directory) and any extra compiler or
+#   linker flags on a "// Flags:" line
+# - stubs/ stands in for the Arduino core, FreeRTOS and lwIP (host sockets)
+# - Tests exit non-zero on failure; benchmarks print their figures and fail
+#   only on their sanity checks. Binaries go to build/
+#
+# Usage:  ./run.sh                         every test and benchmark
+#         ./run.sh test_seqlock bench_fft  just these
+#         CXX=clang++ CXXFLAGS="-O1 -fsanitize=address,undefined" ./run.sh
+
+cd "$(dirname "$0")" || exit 2
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2 -g}
+mkdir -p build
+
+names=$*
+[ -n "$names" ] || names=$(ls test_*.cpp bench_*.cpp 2>/dev/null | sed 's/\.cpp$//')
+
+failed=""
+for n in $names; do
+  n=${n%.cpp}
+  srcs=$(sed -n 's#^// Sources:##p' "$n.cpp")
+  flags=$(sed -n 's#^// Flags:##p' "$n.cpp")
+  echo "== $n"
+  if ! $CXX -std=gnu++17 $CXXFLAGS -Wall -Wextra -Wno-unused-parameter -pthread \
+         -I../../include -Istubs -o "build/$n" "$n.cpp" $srcs $flags; then
+    failed="$failed $n(build)"; continue
+  fi
+  "./build/$n" || failed="$failed $n"
+done
+
+if [ -n "$failed" ]; then echo "FAILED:$failed"; exit 1; fi
+echo "all passed"
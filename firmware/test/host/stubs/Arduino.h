@@ -0,0 +1,131 @@
+#pragma once
+// Arduino.h (host) : the subset of the Arduino-ESP32 core the firmware
+// modules under test use, backed by the C/C++ runtime
+// - millis()/micros() count from process start; ESP.getCycleCount() is a
+//   240 MHz cycle count derived from the monotonic clock, so cycle figures
+//   from the modules read as target-clock equivalents of host time
+// - String is a thin std::string wrapper with the members the firmware calls
+// - Implementations in arduino_host.cpp
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+using std::max; using std::min;
+
+#define PROGMEM
+#define PGM_P const char*
+#define strlen_P strlen
+#define IRAM_ATTR
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// Logging is off unless a test defines TL_HOST_LOG
+#ifdef TL_HOST_LOG
+#define log_e(fmt, ...) fprintf(stderr, "E " fmt "\n", ##__VA_ARGS__)
+#define log_w(fmt, ...) fprintf(stderr, "W " fmt "\n", ##__VA_ARGS__)
+#define log_i(fmt, ...) fprintf(stderr, "I " fmt "\n", ##__VA_ARGS__)
+#else
+#define log_e(...) ((void)0)
+#define log_w(...) ((void)0)
+#define log_i(...) ((void)0)
+#endif
+
+typedef uint8_t byte;
+
+class String {
+public:
+  String() {}
+  String(const char* c) : _s(c ? c : "") {}
+  String(const std::string& s) : _s(s) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+  explicit String(unsigned v) : _s(std::to_string(v)) {}
+  explicit String(long v) : _s(std::to_string(v)) {}
+  explicit String(unsigned long v) : _s(std::to_string(v)) {}
+  explicit String(float v, int d = 2) { char b[32]; snprintf(b, sizeof b, "%.*f", d, v); _s = b; }
+
+  size_t length() const { return _s.size(); }
+  const char* c_str() const { return _s.c_str(); }
+  bool isEmpty() const { return _s.empty(); }
+  bool reserve(size_t n) { _s.reserve(n); return true; }
+  bool concat(const char* p, size_t n) { _s.append(p, n); return true; }
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o) { _s += o; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+  friend String operator+(const char* a, const String& b) { return String(std::string(a) + b._s); }
+  bool operator==(const char* o) const { return _s == o; }
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator!=(const char* o) const { return _s != o; }
+  bool operator!=(const String& o) const { return _s != o._s; }
+  char operator[](size_t i) const { return _s[i]; }
+  int indexOf(char c) const { const size_t p = _s.find(c); return p == std::string::npos ? -1 : (int)p; }
+  bool startsWith(const char* p) const { return _s.rfind(p, 0) == 0; }
+  void toLowerCase() { for (auto& c : _s) c = (char)tolower((unsigned char)c); }
+  void toUpperCase() { for (auto& c : _s) c = (char)toupper((unsigned char)c); }
+  void trim() {
+    const size_t b = _s.find_first_not_of(" \t\r\n");
+    _s = b == std::string::npos ? std::string() : _s.substr(b, _s.find_last_not_of(" \t\r\n") - b + 1);
+  }
+  long toInt() const { return atol(_s.c_str()); }
+  float toFloat() const { return (float)atof(_s.c_str()); }
+  void remove(unsigned i) { _s.erase(i); }
+
+private:
+  std::string _s;
+};
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+struct HWSerial {
+  void begin(int) {}
+  template <class T> void print(T) {}
+  template <class T> void println(T) {}
+  void println() {}
+  void printf(const char*, ...) {}
+};
+extern HWSerial Serial;
+
+struct EspClass {
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getFreeHeap() { return 0; }
+  uint32_t getMinFreeHeap() { return 0; }
+  uint32_t getMaxAllocHeap() { return 0; }
+  uint32_t getFreePsram() { return 0; }
+  void restart() { exit(0); }
+  const char* getSdkVersion() { return "host"; }
+};
+extern EspClass ESP;
+
+#define INPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+inline void pinMode(int, int) {}
+inline int digitalRead(int) { return 0; }
+inline int digitalPinToInterrupt(int p) { return p; }
+inline void attachInterrupt(int, void (*)(), int) {}
+
+bool setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+inline void* ps_malloc(size_t n) { return malloc(n); }
+inline bool psramFound() { return true; }
+#define SET_LOOP_TASK_STACK_SIZE(sz) size_t getArduinoLoopTaskStackSize(void) { return sz; }
@@ -0,0 +1,53 @@
+#pragma once
+// ArduinoJson.h (host, syntax only) : a permissive stand-in for the v7 API
+// the firmware uses, for check.sh; it type-checks calls, not JSON semantics,
+// and nothing links against it
+#include <Arduino.h>
+
+namespace ArduinoJson {
+class Allocator {
+public:
+  virtual void* allocate(size_t n) = 0;
+  virtual void deallocate(void* p) = 0;
+  virtual void* reallocate(void* p, size_t n) = 0;
+protected:
+  ~Allocator() = default;
+};
+}
+
+struct JsonVariant {
+  template <class T> JsonVariant& operator=(const T&) { return *this; }
+  JsonVariant operator[](const char*) const { return {}; }
+  JsonVariant operator[](int) const { return {}; }
+  template <class T> T to() const { return T(); }
+  template <class T> T as() const { return T(); }
+  template <class T> bool is() const { return true; }
+  template <class T> T operator|(T d) const { return d; }
+  const char* operator|(const char* d) const { return d; }
+  operator const char*() const { return ""; }
+  operator float() const { return 0; }
+  operator int() const { return 0; }
+  operator bool() const { return false; }
+  bool isNull() const { return true; }
+  template <class T> bool add(const T&) { return true; }
+  template <class T> T add() { return T(); }
+  size_t size() const { return 0; }
+};
+using JsonVariantConst = JsonVariant;
+struct JsonObject : JsonVariant { using JsonVariant::operator=; };
+struct JsonArray : JsonVariant { using JsonVariant::operator=; JsonVariant begin() const; };
+struct JsonDocument : JsonVariant {
+  JsonDocument(ArduinoJson::Allocator* = nullptr) {}
+  void clear();
+};
+
+struct DeserializationError {
+  operator bool() const { return false; }
+  const char* c_str() const { return ""; }
+};
+DeserializationError deserializeJson(JsonDocument& doc, const String& in);
+DeserializationError deserializeJson(JsonDocument& doc, const char* in);
+DeserializationError deserializeJson(JsonDocument& doc, const char* in, size_t n);
+size_t serializeJson(const JsonVariant& v, String& out);
+size_t serializeJson(const JsonVariant& v, char* out, size_t n);
+size_t measureJson(const JsonVariant& v);
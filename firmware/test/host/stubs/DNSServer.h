@@ -0,0 +1,13 @@
+#pragma once
+// DNSServer.h (host, syntax only) : declarations for check.sh; nothing links against it
+#include <IPAddress.h>
+
+enum class DNSReplyCode { NoError = 0 };
+
+struct DNSServer {
+  bool start(uint16_t port, const char* domain, IPAddress ip);
+  void stop();
+  void setTTL(uint32_t ttl);
+  void setErrorReplyCode(DNSReplyCode code);
+  void processNextRequest();
+};
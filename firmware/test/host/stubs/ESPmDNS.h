@@ -0,0 +1,10 @@
+#pragma once
+// ESPmDNS.h (host, syntax only) : declarations for check.sh; nothing links against it
+#include <stdint.h>
+
+struct MDNSResponder {
+  bool begin(const char* host);
+  void end();
+  bool addService(const char* service, const char* proto, uint16_t port);
+};
+extern MDNSResponder MDNS;
@@ -0,0 +1,5 @@
+#pragma once
+// HTTP_Method.h (host) : method enum of the Arduino-ESP32 WebServer (http_parser numbering)
+enum http_method { HTTP_DELETE = 0, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_OPTIONS = 6, HTTP_PATCH = 28 };
+typedef enum http_method HTTPMethod;
+#define HTTP_ANY (HTTPMethod)(255)
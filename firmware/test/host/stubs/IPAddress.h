@@ -0,0 +1,13 @@
+#pragma once
+// IPAddress.h (host, syntax only) : declarations for check.sh; nothing links against it
+#include <Arduino.h>
+
+struct IPAddress {
+  IPAddress();
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+  IPAddress(uint32_t v);
+  bool fromString(const char* s);
+  operator uint32_t() const;
+  uint8_t operator[](int i) const;
+  String toString() const;
+};
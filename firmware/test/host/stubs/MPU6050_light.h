@@ -0,0 +1,45 @@
+#pragma once
+// MPU6050_light.h (host) : the bring-up and register writes ImuBus uses from
+// the library, as the library issues them on the (fake) Wire bus
+// - begin(): SMPLRT_DIV 0, CONFIG 0, gyro and accel ranges, then PWR_MGMT_1
+//   (wake, PLL on gyro X); returns that last write's status
+// - set*Config() take the library's 0..3 range numbering; anything else
+//   returns 1 without touching the bus
+
+#include <Wire.h>
+
+class MPU6050 {
+public:
+  explicit MPU6050(TwoWire& w) : _wire(&w) {}
+
+  void setAddress(uint8_t addr) { _addr = addr; }
+  uint8_t getAddress() { return _addr; }
+
+  byte begin(int gyroConfig = 1, int accConfig = 0) {
+    writeData(0x19, 0x00);
+    writeData(0x1A, 0x00);
+    setGyroConfig(gyroConfig);
+    setAccConfig(accConfig);
+    return writeData(0x6B, 0x01);
+  }
+  byte setGyroConfig(int n) { return n >= 0 && n <= 3 ? writeData(0x1B, (byte)(n << 3)) : 1; }
+  byte setAccConfig(int n) { return n >= 0 && n <= 3 ? writeData(0x1C, (byte)(n << 3)) : 1; }
+
+  byte writeData(byte reg, byte data) {
+    _wire->beginTransmission(_addr);
+    _wire->write(reg);
+    _wire->write(data);
+    return _wire->endTransmission(true);
+  }
+  byte readData(byte reg) {
+    _wire->beginTransmission(_addr);
+    _wire->write(reg);
+    _wire->endTransmission(false);
+    _wire->requestFrom(_addr, (uint8_t)1);
+    return (byte)_wire->read();
+  }
+
+private:
+  TwoWire* _wire;
+  uint8_t _addr = 0x68;
+};
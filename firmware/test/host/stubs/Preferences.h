@@ -0,0 +1,28 @@
+#pragma once
+// Preferences.h (host, syntax only) : declarations for check.sh; nothing links against it
+#include <Arduino.h>
+
+struct Preferences {
+  bool begin(const char* ns, bool readOnly = false);
+  void end();
+  bool isKey(const char* key);
+  bool remove(const char* key);
+  bool clear();
+  size_t putBool(const char* key, bool v);
+  bool getBool(const char* key, bool def = false);
+  size_t putUChar(const char* key, uint8_t v);
+  uint8_t getUChar(const char* key, uint8_t def = 0);
+  size_t putUShort(const char* key, uint16_t v);
+  uint16_t getUShort(const char* key, uint16_t def = 0);
+  size_t putUInt(const char* key, uint32_t v);
+  uint32_t getUInt(const char* key, uint32_t def = 0);
+  size_t putFloat(const char* key, float v);
+  float getFloat(const char* key, float def = 0);
+  size_t putString(const char* key, const char* v);
+  size_t putString(const char* key, const String& v);
+  String getString(const char* key, const String& def = String());
+  size_t getString(const char* key, char* buf, size_t len);
+  size_t putBytes(const char* key, const void* v, size_t len);
+  size_t getBytes(const char* key, void* buf, size_t len);
+  size_t getBytesLength(const char* key);
+};
@@ -0,0 +1,22 @@
+#pragma once
+// Update.h (host, syntax only) : declarations for check.sh; nothing links against it
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+#define UPDATE_ERROR_OK 0
+
+class UpdateClass {
+public:
+  bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = 0, const char* label = NULL);
+  size_t write(uint8_t* data, size_t len);
+  bool end(bool evenIfRemaining = false);
+  void abort();
+  bool setMD5(const char* expected);
+  uint8_t getError();
+  const char* errorString();
+  bool isRunning();
+  size_t progress();
+  size_t size();
+};
+extern UpdateClass Update;
@@ -0,0 +1,39 @@
+#pragma once
+// WiFi.h (host, syntax only) : declarations for check.sh; nothing links against it
+#include <IPAddress.h>
+
+#include <functional>
+
+typedef int WiFiEvent_t;
+typedef union {
+  struct { int aid; } wifi_ap_staconnected;
+  struct { int aid; } wifi_ap_stadisconnected;
+} WiFiEventInfo_t;
+enum {
+  ARDUINO_EVENT_WIFI_AP_STACONNECTED, ARDUINO_EVENT_WIFI_AP_STADISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, ARDUINO_EVENT_WIFI_STA_CONNECTED
+};
+enum wifi_mode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+enum { WIFI_POWER_8_5dBm = 34 };
+#define WL_CONNECTED 3
+
+struct WiFiClass {
+  void onEvent(std::function<void(WiFiEvent_t, WiFiEventInfo_t)> cb, int event);
+  bool mode(wifi_mode_t m);
+  wifi_mode_t getMode();
+  bool setTxPower(int power);
+  bool setSleep(bool enable);
+  bool setHostname(const char* name);
+  bool softAPsetHostname(const char* name);
+  bool softAPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet);
+  bool softAP(const char* ssid, const char* pass = nullptr);
+  IPAddress softAPIP();
+  bool softAPdisconnect(bool wifiOff);
+  uint8_t softAPgetStationNum();
+  int begin(const char* ssid, const char* pass = nullptr);
+  int status();
+  IPAddress localIP();
+  bool disconnect(bool wifiOff = false);
+  bool setAutoReconnect(bool enable);
+};
+extern WiFiClass WiFi;
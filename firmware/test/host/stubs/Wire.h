@@ -0,0 +1,103 @@
+#pragma once
+// Wire.h (host) : TwoWire backed by a fake I2C bus of register-file devices
+// - attach(addr) puts a device on the bus with MPU-6050 power-on registers;
+//   writes land in its register file from the pointer the first byte sets,
+//   reads return consecutive registers from there (burst reads wrap the way
+//   the part's auto-increment does, within 128 registers)
+// - Every transaction busy-waits its bus time, (address + bytes) x 9 bit
+//   clocks at the setClock() rate, so timing measured around Wire calls
+//   comes out at what the wires would take
+// - fail(addr, n) NACKs the next n transactions to that address
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  // ---------------- fake bus ----------------
+  void attach(uint8_t addr) {
+    Slave& s = _slave[addr & 0x7F];
+    s = Slave();
+    s.present = true;
+    s.regs[0x6B] = 0x40;   // PWR_MGMT_1: asleep
+    s.regs[0x75] = 0x68;   // WHO_AM_I
+  }
+  void detach(uint8_t addr) { _slave[addr & 0x7F].present = false; }
+  uint8_t* regs(uint8_t addr) { return _slave[addr & 0x7F].regs; }
+  // Output registers 0x3B..0x48 (big-endian): accel xyz, temperature, gyro xyz
+  void setOutputs(uint8_t addr, const int16_t v[7]) {
+    uint8_t* r = regs(addr) + 0x3B;
+    for (int i = 0; i < 7; ++i) { r[2 * i] = (uint8_t)(v[i] >> 8); r[2 * i + 1] = (uint8_t)v[i]; }
+  }
+  void fail(uint8_t addr, uint32_t n) { _slave[addr & 0x7F].failures = n; }
+  uint32_t transactions() const { return _transactions; }
+
+  // ---------------- Arduino API ----------------
+  bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) { if (freq) setClock(freq); return true; }
+  void setClock(uint32_t hz) { _hz = hz ? hz : 100000; }
+  void setTimeOut(uint16_t) {}
+
+  void beginTransmission(uint8_t addr) { _addr = addr & 0x7F; _txLen = 0; }
+  size_t write(uint8_t b) {
+    if (_txLen >= sizeof(_tx)) return 0;
+    _tx[_txLen++] = b;
+    return 1;
+  }
+  size_t write(const uint8_t* p, size_t n) {
+    size_t w = 0;
+    while (w < n && write(p[w])) ++w;
+    return w;
+  }
+  // 0 on ACK, 2 address NACK (Arduino numbering)
+  uint8_t endTransmission(bool stop = true) {
+    clockOut(1 + _txLen);
+    Slave& s = _slave[_addr];
+    if (!take(s)) return 2;
+    if (_txLen > 0) {
+      s.ptr = _tx[0] & 0x7F;
+      for (size_t i = 1; i < _txLen; ++i) { s.regs[s.ptr] = _tx[i]; s.ptr = (s.ptr + 1) & 0x7F; }
+    }
+    return 0;
+  }
+  // Bytes received: len, or 0 on NACK
+  uint8_t requestFrom(uint8_t addr, uint8_t len) {
+    _rxLen = _rxPos = 0;
+    clockOut(1 + len);
+    Slave& s = _slave[addr & 0x7F];
+    if (!take(s)) return 0;
+    for (; _rxLen < len && _rxLen < sizeof(_rx); ++_rxLen) { _rx[_rxLen] = s.regs[s.ptr]; s.ptr = (s.ptr + 1) & 0x7F; }
+    return (uint8_t)_rxLen;
+  }
+  int available() const { return (int)(_rxLen - _rxPos); }
+  int read() { return _rxPos < _rxLen ? _rx[_rxPos++] : -1; }
+
+private:
+  struct Slave {
+    bool present = false;
+    uint8_t regs[128] = {};
+    uint8_t ptr = 0;
+    uint32_t failures = 0;
+  };
+
+  bool take(Slave& s) {
+    ++_transactions;
+    if (!s.present) return false;
+    if (s.failures) { --s.failures; return false; }
+    return true;
+  }
+  void clockOut(size_t bytes) {
+    const uint32_t us = (uint32_t)((uint64_t)bytes * 9 * 1000000 / _hz);
+    const uint32_t t0 = micros();
+    while (micros() - t0 < us) {}
+  }
+
+  Slave _slave[128];
+  uint32_t _hz = 100000;
+  uint8_t _addr = 0;
+  uint8_t _tx[32];
+  size_t _txLen = 0;
+  uint8_t _rx[128];
+  size_t _rxLen = 0, _rxPos = 0;
+  uint32_t _transactions = 0;
+};
+
+inline TwoWire Wire;
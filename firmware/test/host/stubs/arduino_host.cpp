@@ -0,0 +1,102 @@
+// arduino_host.cpp : host implementations behind the stub headers (see Arduino.h)
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+HWSerial Serial;
+EspClass ESP;
+
+static const auto kStart = std::chrono::steady_clock::now();
+
+int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - kStart).count();
+}
+uint32_t millis() { return (uint32_t)(esp_timer_get_time() / 1000); }
+uint32_t micros() { return (uint32_t)esp_timer_get_time(); }
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+uint32_t EspClass::getCycleCount() {
+  const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kStart).count();
+  return (uint32_t)(ns * 240 / 1000);
+}
+
+static uint32_t g_cpuMhz = 240;
+bool setCpuFrequencyMhz(uint32_t mhz) { g_cpuMhz = mhz; return true; }
+uint32_t getCpuFrequencyMhz() { return g_cpuMhz; }
+
+// ---------------- FreeRTOS ----------------
+static std::recursive_mutex g_critical;
+void hostEnterCritical() { g_critical.lock(); }
+void hostExitCritical() { g_critical.unlock(); }
+
+namespace {
+struct HostTask {
+  std::mutex m;
+  std::condition_variable cv;
+  uint32_t notified = 0;
+  UBaseType_t prio = 0;
+};
+thread_local HostTask* t_self = nullptr;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t) {
+  HostTask* t = new HostTask;   // lives as long as the process, like a firmware task
+  t->prio = prio;
+  if (handle) *handle = t;
+  std::thread([fn, arg, t] { t_self = t; fn(arg); }).detach();
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+TickType_t xTaskGetTickCount() { return millis(); }
+void vTaskDelayUntil(TickType_t* prev, TickType_t period) {
+  *prev += period;
+  const int32_t wait = (int32_t)(*prev - xTaskGetTickCount());
+  if (wait > 0) delay(wait);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (!t_self) t_self = new HostTask;
+  return t_self;
+}
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t prio) {
+  static_cast<HostTask*>(task ? task : xTaskGetCurrentTaskHandle())->prio = prio;
+}
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+  return static_cast<HostTask*>(task ? task : xTaskGetCurrentTaskHandle())->prio;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+  HostTask* t = static_cast<HostTask*>(xTaskGetCurrentTaskHandle());
+  std::unique_lock<std::mutex> l(t->m);
+  if (wait == portMAX_DELAY) t->cv.wait(l, [t] { return t->notified > 0; });
+  else t->cv.wait_for(l, std::chrono::milliseconds(wait), [t] { return t->notified > 0; });
+  const uint32_t n = t->notified;
+  if (n) t->notified = clear ? 0 : n - 1;
+  return n;
+}
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  HostTask* t = static_cast<HostTask*>(task);
+  { std::lock_guard<std::mutex> l(t->m); t->notified++; }
+  t->cv.notify_one();
+  return pdPASS;
+}
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+  xTaskNotifyGive(task);
+  if (woken) *woken = pdFALSE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::timed_mutex; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait) {
+  std::timed_mutex* mx = static_cast<std::timed_mutex*>(m);
+  if (wait == portMAX_DELAY) { mx->lock(); return pdTRUE; }
+  return mx->try_lock_for(std::chrono::milliseconds(wait)) ? pdTRUE : pdFALSE;
+}
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m) { static_cast<std::timed_mutex*>(m)->unlock(); return pdTRUE; }
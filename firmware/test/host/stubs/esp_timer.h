@@ -0,0 +1,4 @@
+#pragma once
+// esp_timer.h (host) : microseconds since process start, 64 bit
+#include <stdint.h>
+int64_t esp_timer_get_time();
@@ -0,0 +1,29 @@
+#pragma once
+// freertos/FreeRTOS.h (host) : types and macros; ticks are milliseconds and
+// every critical section shares one recursive mutex
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void* QueueHandle_t;
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffu
+#define tskNO_AFFINITY 0x7fffffff
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define portTICK_PERIOD_MS 1
+#define configMAX_PRIORITIES 25
+
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+void hostEnterCritical();
+void hostExitCritical();
+#define portENTER_CRITICAL(m) hostEnterCritical()
+#define portEXIT_CRITICAL(m) hostExitCritical()
+#define portYIELD_FROM_ISR(...) ((void)0)
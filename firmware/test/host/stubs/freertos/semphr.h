@@ -0,0 +1,7 @@
+#pragma once
+// freertos/semphr.h (host) : mutexes on std::timed_mutex
+#include "FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m);
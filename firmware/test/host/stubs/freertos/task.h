@@ -0,0 +1,20 @@
+#pragma once
+// freertos/task.h (host) : tasks are detached std::threads; priorities and
+// core affinity are recorded, not enforced
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* prev, TickType_t period);
+TickType_t xTaskGetTickCount();
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t prio);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+inline void vTaskDelete(TaskHandle_t) {}
+inline BaseType_t xPortGetCoreID() { return 0; }
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
@@ -0,0 +1,207 @@
+// test_accel_cal.cpp : AccelCalibrator on synthetic ellipsoids
+// - A known sensor model (scale, cross-axis, offset) turns unit-g directions
+//   into readings: u = M^-1 a + b, Gaussian noise, quantized at 16384 LSB/g
+// - Diagonal truth: six faces fit the diagonal model; the cross model is
+//   refused on faces alone and with tilts only in one plane (NEED_TILT), and
+//   fits once every axis pair is tilted
+// - Cross truth: faces plus corners; the cross fit recovers the terms and
+//   beats the diagonal fit on random directions, and ImuBus's fused form
+//   (a = G raw - o) matches the direct model
+// - Session rules: duplicate and moving poses are refused, too few poses
+//   is FEW_POSES, a 40% scale error is IMPLAUSIBLE and nothing is applied
+//
+// Sources: ../../src/accel_cal.cpp
+
+#include "accel_cal.h"
+
+#include <math.h>
+
+#include <random>
+
+#include "host_test.h"
+
+static std::mt19937 g_rng(39);
+
+struct Truth { double m[3][3], b[3], inv[3][3]; };
+
+static Truth model(double sx, double sy, double sz, double xy, double xz, double yz, double bx, double by, double bz) {
+  Truth t = { { { sx, xy, xz }, { xy, sy, yz }, { xz, yz, sz } }, { bx, by, bz }, {} };
+  const double (&q)[3][3] = t.m;
+  const double det = q[0][0] * (q[1][1] * q[2][2] - q[1][2] * q[2][1]) - q[0][1] * (q[1][0] * q[2][2] - q[1][2] * q[2][0])
+                   + q[0][2] * (q[1][0] * q[2][1] - q[1][1] * q[2][0]);
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c) {
+      const int r1 = (c + 1) % 3, r2 = (c + 2) % 3, c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+      t.inv[r][c] = (q[r1][c1] * q[r2][c2] - q[r1][c2] * q[r2][c1]) / det;
+    }
+  return t;
+}
+
+// Reading for the true specific force a (unit length, g)
+static void reading(const Truth& t, const double a[3], double noise, float u[3]) {
+  std::normal_distribution<double> n(0, noise > 0 ? noise : 1e-12);
+  for (int r = 0; r < 3; ++r) {
+    double v = t.b[r] + (noise > 0 ? n(g_rng) : 0);
+    for (int c = 0; c < 3; ++c) v += t.inv[r][c] * a[c];
+    u[r] = (float)(lround(v * 16384) / 16384.0);
+  }
+}
+
+// Hold the device still along (x, y, z) for one capture
+static void pose(AccelCalibrator& cal, const Truth& t, double x, double y, double z, double noise = 0.004, uint16_t n = 200) {
+  const double l = sqrt(x * x + y * y + z * z);
+  const double a[3] = { x / l, y / l, z / l };
+  cal.capture(n);
+  for (uint16_t i = 0; i < n; ++i) { float u[3]; reading(t, a, noise, u); cal.push(u[0], u[1], u[2]); }
+}
+
+static const double kFaces[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+// RMS and max of |a| - 1 after correction, noise-free readings in random directions
+static double directionError(const Truth& t, const AccelTrim& k, double* maxErr) {
+  std::normal_distribution<double> n(0, 1);
+  double sum = 0;
+  *maxErr = 0;
+  constexpr int kDirs = 5000;
+  for (int i = 0; i < kDirs; ++i) {
+    double a[3] = { n(g_rng), n(g_rng), n(g_rng) };
+    const double l = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    for (double& v : a) v /= l;
+    float u[3];
+    reading(t, a, 0, u);
+    double m2 = 0;
+    for (int r = 0; r < 3; ++r) {
+      double v = 0;
+      for (int c = 0; c < 3; ++c) v += k.m[3 * r + c] * (u[c] - k.b[c]);
+      m2 += v * v;
+    }
+    const double e = sqrt(m2) - 1;
+    sum += e * e;
+    *maxErr = fmax(*maxErr, fabs(e));
+  }
+  return sqrt(sum / kDirs);
+}
+
+// Largest difference between fitted and true terms
+static double termError(const Truth& t, const AccelTrim& k) {
+  double e = 0;
+  for (int r = 0; r < 3; ++r) {
+    e = fmax(e, fabs(k.b[r] - t.b[r]));
+    for (int c = 0; c < 3; ++c) e = fmax(e, fabs(k.m[3 * r + c] - t.m[r][c]));
+  }
+  return e;
+}
+
+static void testDiagonal() {
+  printf("diagonal truth\n");
+  const Truth t = model(0.97, 1.03, 1.015, 0, 0, 0, 0.06, -0.045, 0.09);
+  AccelCalibrator cal;
+  cal.start(0);
+  for (const auto& f : kFaces) pose(cal, t, f[0], f[1], f[2]);
+  CHECK(cal.poseCount() == 6 && cal.faces() == 0x3f && cal.samples() == 1200);
+
+  const AccelCalibrator::Result r = cal.solve(false);
+  double maxErr, maxRaw;
+  const double rms = directionError(t, r.trim, &maxErr), rmsRaw = directionError(t, AccelTrim{}, &maxRaw);
+  printf("  6 faces, diagonal fit: %s, terms within %.1e, |a|-1 rms %.1e max %.1e (uncorrected rms %.1e)\n",
+         AccelCalibrator::errorName(r.error), termError(t, r.trim), rms, maxErr, rmsRaw);
+  CHECK(r.error == AccelCalibrator::OK && r.trim.valid && !r.trim.cross);
+  CHECK(termError(t, r.trim) < 1e-3 && rms < 1e-3 && rms < rmsRaw / 20);
+  CHECK(r.rmsG < r.rmsRawG);
+
+  // Cross terms: faces alone cannot separate them
+  AccelCalibrator::Result rc = cal.solve(true);
+  CHECK(rc.error == AccelCalibrator::SINGULAR || rc.error == AccelCalibrator::FEW_POSES || rc.error == AccelCalibrator::NEED_TILT);
+  CHECK(!rc.trim.valid);
+  // Nine poses, but every tilt in the xy plane: still refused, and says why
+  pose(cal, t, 1, 1, 0); pose(cal, t, 1, -1, 0); pose(cal, t, -1, 1, 0);
+  rc = cal.solve(true);
+  printf("  + 3 xy-plane tilts, cross fit: %s\n", AccelCalibrator::errorName(rc.error));
+  CHECK(rc.error == AccelCalibrator::NEED_TILT && !rc.trim.valid);
+  pose(cal, t, 1, 0, 1); pose(cal, t, 0, 1, 1);
+  rc = cal.solve(true);
+  printf("  + xz and yz tilts, cross fit: %s, terms within %.1e\n", AccelCalibrator::errorName(rc.error), termError(t, rc.trim));
+  CHECK(rc.error == AccelCalibrator::OK && rc.trim.cross && termError(t, rc.trim) < 1.5e-3);
+  CHECK(cal.solve(false).error == AccelCalibrator::OK);
+}
+
+static void testCross() {
+  printf("cross-axis truth\n");
+  const Truth t = model(0.96, 1.03, 1.02, 0.015, -0.01, 0.02, 0.05, -0.07, 0.11);
+  AccelCalibrator cal;
+  cal.start(1);
+  for (const auto& f : kFaces) pose(cal, t, f[0], f[1], f[2]);
+  for (int sx = -1; sx <= 1; sx += 2)
+    for (int sy = -1; sy <= 1; sy += 2)
+      for (int sz = -1; sz <= 1; sz += 2) pose(cal, t, sx, sy, sz);
+  CHECK(cal.poseCount() == 14 && cal.imu() == 1);
+
+  double maxDiag, maxCross;
+  const AccelCalibrator::Result rd = cal.solve(false), r = cal.solve(true);
+  const double rmsDiag = directionError(t, rd.trim, &maxDiag), rmsCross = directionError(t, r.trim, &maxCross);
+  printf("  14 poses: diagonal fit rms %.1e max %.1e; cross fit %s, terms within %.1e, rms %.1e max %.1e\n",
+         rmsDiag, maxDiag, AccelCalibrator::errorName(r.error), termError(t, r.trim), rmsCross, maxCross);
+  CHECK(rd.error == AccelCalibrator::OK);
+  CHECK(r.error == AccelCalibrator::OK && r.trim.cross && termError(t, r.trim) < 1.5e-3);
+  CHECK(rmsCross < 1e-3 && rmsCross < rmsDiag / 5);
+
+  // ImuBus folds the terms into the count scale: a = G raw - o, G = M / LSB, o = M b
+  const float lsb = 16384;
+  float G[9], o[3];
+  for (int i = 0; i < 3; ++i) {
+    for (int c = 0; c < 3; ++c) G[3 * i + c] = r.trim.m[3 * i + c] / lsb;
+    o[i] = r.trim.m[3 * i] * r.trim.b[0] + r.trim.m[3 * i + 1] * r.trim.b[1] + r.trim.m[3 * i + 2] * r.trim.b[2];
+  }
+  std::uniform_int_distribution<int> counts(-30000, 30000);
+  double worst = 0;
+  for (int k = 0; k < 1000; ++k) {
+    const int16_t raw[3] = { (int16_t)counts(g_rng), (int16_t)counts(g_rng), (int16_t)counts(g_rng) };
+    for (int i = 0; i < 3; ++i) {
+      const float fused = G[3 * i] * raw[0] + G[3 * i + 1] * raw[1] + G[3 * i + 2] * raw[2] - o[i];
+      double direct = 0;
+      for (int c = 0; c < 3; ++c) direct += r.trim.m[3 * i + c] * ((double)raw[c] / lsb - r.trim.b[c]);
+      worst = fmax(worst, fabs(fused - direct));
+    }
+  }
+  printf("  fused vs direct: %.1e g at most\n", worst);
+  CHECK(worst < 1e-5);
+}
+
+static void testSession() {
+  printf("session rules\n");
+  const Truth t = model(1, 1, 1, 0, 0, 0, 0, 0, 0);
+  AccelCalibrator cal;
+  CHECK(!cal.capture());   // no session
+  cal.start(0);
+  pose(cal, t, 0, 0, 1);
+  CHECK(cal.lastCapture() == AccelCalibrator::CAP_ACCEPTED && cal.poseCount() == 1);
+  pose(cal, t, 0.1, 0, 1);   // 5.7 deg from the first
+  CHECK(cal.lastCapture() == AccelCalibrator::CAP_DUPLICATE && cal.poseCount() == 1);
+  pose(cal, t, 1, 0, 0, 0.05);   // shaken
+  CHECK(cal.lastCapture() == AccelCalibrator::CAP_MOVING && cal.poseCount() == 1 && cal.samples() == 200);
+  CHECK(cal.solve(false).error == AccelCalibrator::FEW_POSES);
+
+  CHECK(cal.capture(50) && cal.state() == AccelCalibrator::CAPTURING && !cal.capture());
+  for (int i = 0; i < 49; ++i) cal.push(1, 0, 0);
+  CHECK(cal.captured() == 49 && cal.state() == AccelCalibrator::CAPTURING);
+  cal.push(1, 0, 0);
+  CHECK(cal.state() == AccelCalibrator::COLLECTING && cal.lastCapture() == AccelCalibrator::CAP_ACCEPTED);
+  cal.cancel();
+  CHECK(cal.state() == AccelCalibrator::IDLE && !cal.capture());
+
+  // A 40% scale error is a broken part or a bad session, not a calibration
+  const Truth bad = model(1.4, 1, 1, 0, 0, 0, 0, 0, 0);
+  AccelCalibrator c2;
+  c2.start(0);
+  for (const auto& f : kFaces) pose(c2, bad, f[0], f[1], f[2]);
+  const AccelCalibrator::Result r = c2.solve(false);
+  printf("  40%% scale error: %s (x scale %.3f)\n", AccelCalibrator::errorName(r.error), r.trim.m[0]);
+  CHECK(r.error == AccelCalibrator::IMPLAUSIBLE && !r.trim.valid);
+}
+
+int main() {
+  testDiagonal();
+  testCross();
+  testSession();
+  return testExit();
+}
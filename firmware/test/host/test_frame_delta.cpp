@@ -0,0 +1,259 @@
+// test_frame_delta.cpp : DeltaEncoder against a reference decoder
+// - The decoder follows the UI's: a keyframe replaces the held steps and
+//   values, a delta applies its changes to the keyframe it names and is
+//   undecodable when that is not the one held (the UI's cue to resync)
+// - Round trip: every decoded field stays within its deadband of the value
+//   encoded, also with frames dropped on the way (SSE fan-out to a slow
+//   subscriber) since deltas never build on each other
+// - Keyframes: on the key interval, on a field-count change, and after a
+//   frame that did not fit (overflows); a client that missed one resyncs on
+//   the next
+// - A change of more than 2^31 steps since the keyframe comes through exact
+// - Compression: stationary and towing traces at TL_PUBLISH_HZ over the
+//   firmware's own field table (stream_fields.h, both IMUs), bytes against
+//   the same values sent as a full JSON object per frame
+//
+// Sources: ../../src/frame_delta.cpp
+
+#include "frame_delta.h"
+#include "stream_fields.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "host_test.h"
+
+static constexpr uint8_t kN = kStreamFieldCount;
+
+struct Decoder {
+  bool haveKey = false;
+  uint32_t keySeq = 0, undecodable = 0, keys = 0;
+  std::vector<long long> keyQ;
+  std::vector<double> step, val;
+
+  // True when val holds this frame
+  bool take(const char* t) {
+    if (t[0] == '{') {
+      keys++; haveKey = true;
+      keySeq = strtoul(strstr(t, "\"key\":") + 6, nullptr, 10);
+      step.clear(); keyQ.clear();
+      char* p = (char*)strstr(t, "\"step\":[") + 8;
+      while (*p != ']') { step.push_back(strtod(p, &p)); if (*p == ',') p++; }
+      p = (char*)strstr(t, "\"q\":[") + 5;
+      while (*p != ']') { keyQ.push_back(strtoll(p, &p, 10)); if (*p == ',') p++; }
+      val.resize(step.size());
+      for (size_t i = 0; i < step.size(); ++i) val[i] = keyQ[i] * step[i];
+      return true;
+    }
+    char* p = (char*)t + 1;
+    long long h[4];
+    for (long long& x : h) { x = strtoll(p, &p, 10); if (*p == ',') p++; }
+    if (!haveKey || (uint32_t)(h[0] - h[1]) != keySeq) { undecodable++; return false; }
+    std::vector<long long> q = keyQ;
+    while (*p != ']') {
+      const long i = strtol(p, &p, 10); p++;
+      const long long d = strtoll(p, &p, 10);
+      if (*p == ',') p++;
+      if (i < 0 || (size_t)i >= q.size()) { undecodable++; return false; }
+      q[i] += d;
+    }
+    for (size_t i = 0; i < q.size(); ++i) val[i] = q[i] * step[i];
+    return true;
+  }
+};
+
+// Decoded error past what the deadband allows, worst field (<= 0 is within)
+static double excess(const Decoder& d, const float* v, uint8_t n) {
+  double worst = -1;
+  for (uint8_t i = 0; i < n; ++i) {
+    const double dbq = fmax(1, lround(kStreamFields[i].deadband / kStreamFields[i].step));
+    worst = fmax(worst, fabs(d.val[i] - v[i]) - dbq * kStreamFields[i].step * 1.0001);
+  }
+  return worst;
+}
+
+static size_t fullBytes(const float* v, uint8_t n) {
+  std::string s = "{";
+  char b[48];
+  for (uint8_t i = 0; i < n; ++i) { snprintf(b, sizeof b, "%s\"%s\":%.7g", i ? "," : "", kStreamFields[i].name, (double)v[i]); s += b; }
+  return s.size() + 1;
+}
+
+static uint8_t field(const char* name) {
+  for (uint8_t i = 0; i < kN; ++i) if (!strcmp(kStreamFields[i].name, name)) return i;
+  printf("no field %s\n", name);
+  abort();
+}
+
+// Every field of the table, from the same derivations the sense task uses
+// (streamValues() order), with MPU6050 noise figures per frame
+struct Motion {
+  std::mt19937 rng{45};
+  std::normal_distribution<float> n{0, 1};
+  bool towing;
+  float pAvg = 1.2f, rAvg = -0.7f, rearPAvg = 0.9f, rearRAvg = -1.1f;
+  float accPeak[4] = {}, rollPeak[4] = {};
+  const uint8_t first = field("pos_pitch_raw"), rear = field("axles.0.pitch");
+  explicit Motion(bool tow) : towing(tow) {}
+
+  static void hold(float* peak, float pos, float neg, float decay) {
+    peak[0] = fmaxf(peak[0] * decay, fmaxf(0, pos)); peak[1] = fmaxf(peak[1] * decay, fmaxf(0, -pos));
+    peak[2] = fmaxf(peak[2] * decay, fmaxf(0, -neg)); peak[3] = fmaxf(peak[3] * decay, fmaxf(0, neg));
+  }
+
+  void at(double t, float* v) {
+    const float w = 2 * (float)M_PI, dt = 1.0f / TL_PUBLISH_HZ;
+    float pitch = 1.2f, roll = -0.7f, dp = 0, dr = 0, yaw = 0, dyaw = 0, lon = 0, lat = 0, vert = 0;
+    float swayAmp = 0.002f, swayYaw = 0.05f;
+    const float aN = towing ? 0.06f : 0.004f, gN = towing ? 1.2f : 0.08f, angN = towing ? 0.8f : 0.05f;
+    if (towing) {
+      pitch += 2.0f * sinf(w * t / 40); dp = 2.0f * w / 40 * cosf(w * t / 40);
+      roll += sinf(w * t / 25) + 0.4f * sinf(w * 0.8f * t); dr = w / 25 * cosf(w * t / 25) + 0.4f * w * 0.8f * cosf(w * 0.8f * t);
+      yaw = 5.0f * sinf(w * t / 30) + 2.0f * sinf(w * 0.8f * t);
+      dyaw = 5.0f * w / 30 * cosf(w * t / 30) + 2.0f * w * 0.8f * cosf(w * 0.8f * t);
+      lon = 0.05f * sinf(w * t / 20); lat = 0.03f * sinf(w * 0.8f * t); vert = 0.04f * n(rng);
+      swayAmp = 0.03f; swayYaw = 2.0f;
+    }
+    const float d2r = (float)M_PI / 180;
+    const float gF = -sinf(pitch * d2r), gR = sinf(roll * d2r), gU = cosf(roll * d2r) * cosf(pitch * d2r);
+    const float rateP = dp + gN * n(rng), rateR = dr + gN * n(rng), rateT = dyaw + gN * n(rng);
+    const float aF = lon + aN * n(rng), aR = lat + aN * n(rng), aU = vert + aN * n(rng);
+    const float a = 1 - expf(-dt / (TL_LEVEL_AVG_TAU_MS / 1000.0f));
+    uint8_t k = first;
+    auto put = [&](float x) { v[k++] = x; };
+    const float pRaw = pitch + 0.4f + angN * n(rng), rRaw = roll - 0.3f + angN * n(rng);
+    const float pCal = pRaw - 0.4f, rCal = rRaw + 0.3f;
+    pAvg += a * (pCal - pAvg); rAvg += a * (rCal - rAvg);
+    put(pRaw); put(rRaw); put(pCal); put(rCal); put(pAvg); put(rAvg);
+    put(rateP); put(rateR); put(TL_LEVEL_AVG_TAU_MS);
+    put(gF + aF); put(gR + aR); put(gU + aU);
+    put(rateR + gN * n(rng)); put(rateP + gN * n(rng)); put(yaw + gN * n(rng));
+    put(aF); put(aR); put(aU);
+    hold(accPeak, aU, aR, expf(-dt / (TL_ACCEL_PEAK_TAU_MS / 1000.0f)));
+    for (float x : accPeak) put(x);
+    put(gF); put(gR); put(gU);
+    put(fmaxf(0, rateP)); put(fmaxf(0, -rateP)); put(fmaxf(0, rateR)); put(fmaxf(0, -rateR));
+    put(fmaxf(0, rateT)); put(fmaxf(0, -rateT));
+    hold(rollPeak, rateP, rateR, expf(-dt / (TL_ROLL_PEAK_TAU_MS / 1000.0f)));
+    for (float x : rollPeak) put(x);
+    const float amp = swayAmp * (1 + 0.1f * n(rng));
+    put(amp >= TL_STREAM_SWAY_FLOOR_G ? 0.8f + 0.02f * n(rng) : 0.0f); put(amp);
+    put(0); put(0); put(0); put(swayYaw * (1 + 0.1f * n(rng))); put(amp);   // no alert raised
+    put(1);                                                                  // imu_ok
+    if (k != rear) { printf("Motion fills %u fields before the rear block, the table has %u\n", k, rear); abort(); }
+    const float rP = pitch - 0.3f + angN * n(rng), rR = roll - 0.4f + angN * n(rng);
+    rearPAvg += a * (rP - rearPAvg); rearRAvg += a * (rR - rearRAvg);
+    put(pCal); put(rCal); put(pAvg); put(rAvg); put(1);
+    put(rP); put(rR); put(rearPAvg); put(rearRAvg); put(1);
+    put(rCal - rR); put(rAvg - rearRAvg);
+    if (k != kN) { printf("Motion fills %u fields, the table has %u\n", k, kN); abort(); }
+  }
+};
+
+static void testTraces() {
+  for (bool towing : { false, true }) for (bool rearImu : { false, true }) {
+    const uint8_t nf = rearImu ? kN : kN - kStreamRearFields;
+    printf("%s, %s, %d s at %u Hz\n", towing ? "towing" : "stationary", rearImu ? "two IMUs" : "one IMU",
+           600, (unsigned)TL_PUBLISH_HZ);
+    Motion m(towing);
+    DeltaEncoder enc(kStreamFields, kN);
+    Decoder all, lossy;
+    std::mt19937 drop(7);
+    char buf[TL_STREAM_FRAME_MAX];
+    float v[kN];
+    uint64_t full = 0, sent = 0;
+    double worst = -1, worstLossy = -1;
+    uint32_t frames = 0, shown = 0;
+    const int64_t dtUs = 1000000 / TL_PUBLISH_HZ;
+    for (uint32_t k = 1; k <= 600u * TL_PUBLISH_HZ; ++k) {
+      m.at(k / (double)TL_PUBLISH_HZ, v);
+      const int64_t t = (int64_t)k * dtUs;
+      const size_t len = enc.encode(v, nf, k, t, t + 800, buf, sizeof buf);
+      CHECK(len > 0 && len == strlen(buf));
+      full += fullBytes(v, nf); sent += len + 1; frames++;
+      CHECK(all.take(buf));
+      worst = fmax(worst, excess(all, v, nf));
+      // A subscriber that loses a quarter of the deltas, never a keyframe
+      if (!enc.lastWasKey() && drop() % 4 == 0) continue;
+      if (lossy.take(buf)) { shown++; worstLossy = fmax(worstLossy, excess(lossy, v, nf)); }
+    }
+    const DeltaEncoder::Stats& s = enc.stats();
+    printf("  %u frames: %u keys, %u still deltas, largest delta %u B, %.1f B/frame vs %.1f B full (%.1fx)\n",
+           frames, s.keys, s.still, s.maxDelta, (double)sent / frames, (double)full / frames, (double)full / sent);
+    printf("  worst decoded error past the deadband %.2g, %.2g with 25%% of deltas lost (%u shown)\n", worst, worstLossy, shown);
+    CHECK(worst <= 0 && worstLossy <= 0);
+    CHECK(all.undecodable == 0 && lossy.undecodable == 0);
+    CHECK(s.keys == 600 * 1000 / TL_STREAM_KEY_MS && s.overflows == 0);
+    CHECK((double)full / sent > (towing ? 5.0 : 30.0));
+    if (!towing) CHECK(s.still > frames / 2);
+  }
+}
+
+static void testKeyframes() {
+  printf("keyframes\n");
+  DeltaEncoder enc(kStreamFields, kN, 1000);
+  Decoder d;
+  char buf[TL_STREAM_FRAME_MAX];
+  float v[kN] = {};
+  uint32_t seq = 0;
+  auto send = [&](int64_t tUs, uint8_t n = kN) {
+    const size_t len = enc.encode(v, n, ++seq, tUs, tUs, buf, sizeof buf);
+    return len && d.take(buf);
+  };
+  CHECK(send(0) && enc.lastWasKey());
+  CHECK(send(100000) && !enc.lastWasKey() && !strcmp(buf, "[2,1,100,0]"));
+  CHECK(send(999000) && !enc.lastWasKey());
+  CHECK(send(1000000) && enc.lastWasKey());   // key interval
+  CHECK(send(1100000, kN - kStreamRearFields) && enc.lastWasKey() && d.val.size() == kN - kStreamRearFields);   // field count
+  CHECK(send(1200000, kN - kStreamRearFields) && !enc.lastWasKey());
+
+  // Too small a buffer: nothing written, counted, and the next frame is a key
+  const DeltaEncoder::Stats s0 = enc.stats();
+  v[0] = 12.34f;
+  CHECK(enc.encode(v, kN - kStreamRearFields, ++seq, 1300000, 1300000, buf, 8) == 0);
+  CHECK(enc.stats().overflows == s0.overflows + 1 && enc.stats().deltas == s0.deltas);
+  CHECK(send(1400000, kN - kStreamRearFields) && enc.lastWasKey());
+  CHECK(fabs(d.val[0] - 12.34) < 0.006);
+  const DeltaEncoder::Stats s1 = enc.stats();
+  CHECK(enc.encode(v, kN - kStreamRearFields, ++seq, 1450000, 1450000, buf, 10) == 0);   // a delta that does not fit
+  CHECK(enc.stats().overflows == s1.overflows + 1);
+  CHECK(send(1500000, kN - kStreamRearFields) && enc.lastWasKey());
+
+  // A client that missed a keyframe cannot decode the deltas after it
+  Decoder late;
+  CHECK(late.take(buf));
+  enc.requestKey();
+  CHECK(enc.encode(v, kN - kStreamRearFields, ++seq, 1600000, 1600000, buf, sizeof buf) && enc.lastWasKey());   // lost
+  CHECK(enc.encode(v, kN - kStreamRearFields, ++seq, 1700000, 1700000, buf, sizeof buf) && !enc.lastWasKey());
+  CHECK(!late.take(buf) && late.undecodable == 1);
+  enc.requestKey();
+  CHECK(enc.encode(v, kN - kStreamRearFields, ++seq, 1800000, 1800000, buf, sizeof buf) && late.take(buf));
+  CHECK(enc.encode(v, kN - kStreamRearFields, ++seq, 1900000, 1900000, buf, sizeof buf) && late.take(buf));
+}
+
+static void testWideChange() {
+  printf("change past int32 steps\n");
+  static const StreamField fine[] = { { "x", 1e-6f, 1e-6f } };
+  DeltaEncoder enc(fine, 1);
+  Decoder d;
+  char buf[256];
+  float v = -1500;   // -1.5e9 steps
+  CHECK(enc.encode(&v, 1, 1, 0, 0, buf, sizeof buf) && d.take(buf));
+  v = 1500;          // +3.0e9 steps since the keyframe
+  CHECK(enc.encode(&v, 1, 2, 1000, 1000, buf, sizeof buf) && !enc.lastWasKey());
+  printf("  %s\n", buf);
+  CHECK(!strcmp(buf, "[2,1,1,0,0,3000000000]"));
+  CHECK(d.take(buf) && fabs(d.val[0] - 1500) < 1e-3);
+}
+
+int main() {
+  testKeyframes();
+  testWideChange();
+  testTraces();
+  return testExit();
+}
@@ -0,0 +1,311 @@
+// test_http_server.cpp : HttpServer on host sockets, loopback clients
+// - Routes behave: GET/POST, 404, CORS preflight, keep-alive and pipelining;
+//   query arguments come back decoded, in arena memory
+// - HEAD: the GET handler answers, the head carries its Content-Length and
+//   nothing follows it, so the next response on a keep-alive connection
+//   starts right after; on an event stream the head is followed by a close
+// - Malformed framing (bad or repeated Content-Length, oversize bodies) is
+//   answered 4xx and never reaches a handler
+// - Concurrency: clients that open a connection and stall must not delay the
+//   others; latency is measured alone and under load (keep-alive pollers plus
+//   captive probes on fresh connections), and the stalled slots are reclaimed
+//   by the idle timeout
+// - Streaming: a subscriber that stops reading is closed after
+//   TL_HTTP_STREAM_STALL_MS while a reading one keeps its frames
+//
+// Sources: ../../src/http_server.cpp stubs/arduino_host.cpp
+
+#include "http_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "http_client.h"
+
+static HttpServer* g_server;
+static std::atomic<int> g_echoCalls{0};
+
+static std::atomic<int> g_sensorMethod{-1};
+
+static void handleSensor() { g_sensorMethod = g_server->method(); g_server->send(200, "application/json", "{\"pitch\":1.25,\"roll\":-0.50}"); }
+static void handleEcho() {
+  g_echoCalls++;
+  char n[16]; snprintf(n, sizeof n, "%u", (unsigned)g_server->bodyLen());
+  g_server->send(200, "text/plain", n);
+}
+// ?v= as decoded, "-" if absent; 500 if the value is not NUL-terminated arena memory
+static void handleArg() {
+  const char* v; size_t n;
+  if (!g_server->findArg("v", &v, &n)) { g_server->send(200, "text/plain", g_server->hasArg("v") ? "?" : "-"); return; }
+  if (!g_server->arena().owns(v) || strlen(v) != n) { g_server->send(500, "text/plain", "!"); return; }
+  g_server->send(200, "text/plain", v, n);
+}
+static void handleStream() { g_server->beginStream(); }
+static void redirectAny() {
+  g_server->sendHeader("Location", "http://trailer.local/ui");
+  g_server->send(302, "text/plain", "");
+}
+
+static constexpr uint32_t M_GET = methodBit(HTTP_GET), M_POST = methodBit(HTTP_POST);
+static constexpr uint8_t API = ROUTE_CORS | ROUTE_KEEPALIVE;
+static constexpr Route kRoutes[] = {
+  { "/sensor",        M_GET,       handleSensor, API },
+  { "/echo",          M_POST,      handleEcho,   API },
+  { "/arg",           M_GET,       handleArg,    API },
+  { "/stream",        M_GET,       handleStream, ROUTE_CORS },
+  { "/generate_204",  METHODS_ANY, redirectAny,  0 },
+};
+static constexpr auto kDispatch = makeDispatcher(kRoutes);
+
+static const char kGetSensor[] = "GET /sensor HTTP/1.1\r\nHost: t\r\n\r\n";
+
+static double pct(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void testRoutes(uint16_t port) {
+  printf("routes\n");
+  HttpResponse r = httpRequest(port, kGetSensor);
+  CHECK(r.status == 200 && r.body == "{\"pitch\":1.25,\"roll\":-0.50}");
+  CHECK(r.header("Access-Control-Allow-Origin") == "*");
+  CHECK(httpRequest(port, "GET /nope HTTP/1.1\r\n\r\n").status == 404);
+  CHECK(httpRequest(port, "DELETE /sensor HTTP/1.1\r\n\r\n").status == 404);
+  r = httpRequest(port, "OPTIONS /echo HTTP/1.1\r\n\r\n");
+  CHECK(r.status == 204 && r.header("Access-Control-Allow-Methods") == "POST,OPTIONS");
+  r = httpRequest(port, "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello");
+  CHECK(r.status == 200 && r.body == "5");
+  r = httpRequest(port, "GET /generate_204 HTTP/1.1\r\n\r\n");
+  CHECK(r.status == 302 && r.header("Location") == "http://trailer.local/ui" && r.header("Connection") == "close");
+
+  // Query arguments: decoded into the arena, first occurrence wins, broken escapes kept
+  const struct { const char* query; const char* value; } args[] = {
+    { "?v=a%20b+c", "a b c" }, { "?x=1&v=%41%42&y", "AB" }, { "?v=100%25", "100%" },
+    { "?v=1&v=2", "1" }, { "?v=", "" }, { "?v", "" }, { "?v=%4", "%4" }, { "?v=%zz", "%zz" },
+    { "?vv=1", "-" }, { "", "-" },
+  };
+  for (const auto& a : args) {
+    r = httpRequest(port, std::string("GET /arg") + a.query + " HTTP/1.1\r\n\r\n");
+    CHECK(r.status == 200 && r.body == a.value);
+  }
+}
+
+static void testKeepAlive(uint16_t port) {
+  printf("keep-alive and pipelining\n");
+  HttpClient c(port);
+  HttpResponse a, b, d;
+  // Two requests in one segment, the second with a body: answered in order
+  CHECK(c.sendRaw(std::string(kGetSensor) + "POST /echo HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"));
+  CHECK(c.read(a) && a.status == 200 && a.header("Connection") == "keep-alive");
+  CHECK(c.read(b) && b.status == 200 && b.body == "3");
+  CHECK(c.sendRaw("GET /sensor HTTP/1.1\r\nConnection: close\r\n\r\n"));
+  CHECK(c.read(d) && d.status == 200 && d.header("Connection") == "close");
+  CHECK(c.closedByPeer());
+  CHECK(g_server->stats().pipelined >= 1);
+}
+
+// Each case on its own connection: the answer, then the server closes
+static void testHead(uint16_t port) {
+  printf("HEAD\n");
+  HttpResponse get = httpRequest(port, kGetSensor);
+  CHECK(get.status == 200 && !get.body.empty());
+
+  // HEAD then GET pipelined: the GET's status line follows the HEAD's blank line
+  HttpClient c(port);
+  CHECK(c.sendRaw(std::string("HEAD /sensor HTTP/1.1\r\nHost: t\r\n\r\n") + kGetSensor));
+  std::string raw, more;
+  const std::string getHead = "HTTP/1.1 200";
+  size_t second;
+  auto done = [&] {
+    second = raw.find(getHead, 1);
+    return second != std::string::npos && raw.size() >= get.body.size()
+        && raw.compare(raw.size() - get.body.size(), get.body.size(), get.body) == 0;
+  };
+  while (!done() && c.readSome(more, 1000)) raw += more;
+  const size_t headEnd = raw.find("\r\n\r\n");
+  CHECK(headEnd != std::string::npos && second == headEnd + 4);
+  HttpResponse h;
+  h.head = raw.substr(0, headEnd + 2);
+  CHECK(h.header("Content-Length") == std::to_string(get.body.size()) && h.header("Connection") == "keep-alive");
+  CHECK(g_sensorMethod == HTTP_GET);
+  CHECK(done() && raw.find(get.body) > second);   // the only body is the GET's
+  CHECK(!c.closedByPeer(200));
+
+  // Not a GET route: 404 as before; an event stream: head, then a close
+  CHECK(httpRequest(port, "HEAD /echo HTTP/1.1\r\n\r\n").status == 404);
+  HttpClient s(port);
+  const uint32_t subs = g_server->stats().subscribers;
+  CHECK(s.sendRaw("HEAD /stream HTTP/1.1\r\n\r\n"));
+  raw.clear();
+  while (s.readSome(more, 500)) raw += more;
+  CHECK(raw.find("text/event-stream") != std::string::npos && raw.size() == raw.find("\r\n\r\n") + 4);
+  CHECK(s.closedByPeer() && g_server->stats().subscribers == subs);
+}
+
+static void testFraming(uint16_t port) {
+  printf("request framing\n");
+  const struct { const char* len; int status; } cases[] = {
+    { "-1", 400 },
+    { "+5", 400 },
+    { "", 400 },
+    { "5x", 400 },
+    { "0x10", 400 },
+    { "18446744073709551616", 400 },   // 2^64: overflows size_t
+    { "4294967295", 413 },             // wraps a 32-bit headLen + contentLen
+    { "18446744073709551615", 413 },
+    { "5000", 413 },
+  };
+  const int echoBefore = g_echoCalls;
+  for (const auto& k : cases) {
+    HttpClient c(port);
+    HttpResponse r;
+    CHECK(c.sendRaw(std::string("POST /echo HTTP/1.1\r\nContent-Length: ") + k.len + "\r\n\r\nhello"));
+    const bool got = c.read(r);
+    if (!got || r.status != k.status) printf("  Content-Length \"%s\": got %d\n", k.len, got ? r.status : -1);
+    CHECK(got && r.status == k.status);
+    CHECK(c.closedByPeer());
+  }
+  // Repeated header, equal or not
+  CHECK(httpRequest(port, "POST /echo HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n\r\nhello").status == 400);
+  CHECK(httpRequest(port, "POST /echo HTTP/1.1\r\nContent-Length: 5\r\ncontent-length: 50\r\n\r\nhello").status == 400);
+  // Blanks around the value are fine
+  CHECK(httpRequest(port, "POST /echo HTTP/1.1\r\nContent-Length:  5 \r\n\r\nhello").body == "5");
+  CHECK(g_echoCalls == echoBefore + 1);
+  CHECK(httpRequest(port, "GET /sensor HTTP/1.1\r\n" + std::string(TL_HTTP_RX_BUF, 'x')).status == 431);
+  CHECK(httpRequest(port, kGetSensor).status == 200);
+}
+
+static void testConcurrency(uint16_t port) {
+  printf("concurrency\n");
+  constexpr int kPollers = 3, kPolls = TL_HTTP_KEEPALIVE_MAX_REQUESTS - 1, kProbes = 200;
+  constexpr int kStalled = TL_HTTP_MAX_CLIENTS - kPollers - 1;   // one slot left for the probes
+
+  // Unloaded reference: one keep-alive client
+  std::vector<double> alone;
+  {
+    HttpClient c(port);
+    for (int i = 0; i < kPolls; ++i) {
+      const auto t0 = std::chrono::steady_clock::now();
+      HttpResponse r;
+      if (c.sendRaw(kGetSensor) && c.read(r) && r.status == 200) alone.push_back(msSince(t0));
+    }
+  }
+  CHECK((int)alone.size() == kPolls);
+
+  // Slowloris: half a request each, then silence
+  std::vector<HttpClient*> stalled;
+  for (int i = 0; i < kStalled; ++i) {
+    stalled.push_back(new HttpClient(port));
+    stalled.back()->sendRaw("GET /sensor HTTP/1.1\r\nHost: t\r\n");
+  }
+  const uint32_t timeoutsBefore = g_server->stats().timeouts;
+  const auto stallStart = std::chrono::steady_clock::now();
+
+  std::vector<double> lat[kPollers + 1];
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kPollers; ++t) {
+    threads.emplace_back([&, t] {
+      HttpClient c(port);
+      for (int i = 0; i < kPolls; ++i) {
+        const auto t0 = std::chrono::steady_clock::now();
+        HttpResponse r;
+        if (c.sendRaw(kGetSensor) && c.read(r) && r.status == 200) lat[t].push_back(msSince(t0));
+        else failures++;
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    for (int i = 0; i < kProbes; ++i) {
+      const auto t0 = std::chrono::steady_clock::now();
+      HttpResponse r = httpRequest(port, "GET /generate_204 HTTP/1.1\r\nHost: connectivitycheck.gstatic.com\r\n\r\n");
+      if (r.status == 302) lat[kPollers].push_back(msSince(t0));
+      else failures++;
+    }
+  });
+  for (auto& th : threads) th.join();
+
+  std::vector<double> polls;
+  for (int t = 0; t < kPollers; ++t) polls.insert(polls.end(), lat[t].begin(), lat[t].end());
+  printf("  alone        %4d polls   p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms\n",
+         (int)alone.size(), pct(alone, 0.5), pct(alone, 0.99), pct(alone, 1));
+  printf("  under load   %4d polls   p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms  (%d pollers, %d stalled)\n",
+         (int)polls.size(), pct(polls, 0.5), pct(polls, 0.99), pct(polls, 1), kPollers, kStalled);
+  printf("  probes       %4d conns   p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms\n",
+         (int)lat[kPollers].size(), pct(lat[kPollers], 0.5), pct(lat[kPollers], 0.99), pct(lat[kPollers], 1));
+  CHECK(failures == 0);
+  CHECK((int)polls.size() == kPollers * kPolls);
+  // Nothing waits on the stalled clients: tails stay far below any timeout
+  CHECK(pct(polls, 0.99) < 25.0);
+  CHECK(pct(lat[kPollers], 0.99) < 25.0);
+  CHECK(g_server->stats().peakActive >= kStalled + kPollers);
+
+  // The stalled connections are dropped after TL_HTTP_IDLE_TIMEOUT_MS
+  for (HttpClient* c : stalled) CHECK(c->closedByPeer(TL_HTTP_IDLE_TIMEOUT_MS + 2000));
+  const double held = msSince(stallStart);
+  printf("  stalled slots reclaimed after %.0f ms\n", held);
+  CHECK(held >= TL_HTTP_IDLE_TIMEOUT_MS - 100);
+  CHECK(g_server->stats().timeouts - timeoutsBefore == (uint32_t)kStalled);
+  for (HttpClient* c : stalled) delete c;
+}
+
+// 64 kB frames at 50 Hz fill the send buffer of a non-reading client within seconds
+static void testStreamStall(uint16_t port) {
+  printf("stream stall\n");
+  HttpClient reader(port), gone(port, 4096);
+  CHECK(reader.sendRaw("GET /stream HTTP/1.1\r\n\r\n") && gone.sendRaw("GET /stream HTTP/1.1\r\n\r\n"));
+  std::atomic<bool> run{true};
+  std::atomic<size_t> readerBytes{0};
+  std::thread pub([&] {
+    std::string body(64000, 'x');
+    for (uint32_t seq = 0; run; ++seq) {
+      SharedFrame* f = SharedFrame::create(body.size());
+      memcpy(f->json(), body.data(), body.size());
+      f->jsonLen = body.size(); f->seq = seq;
+      f->seal();
+      g_server->broadcast(f);
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  });
+  std::thread rd([&] {
+    std::string chunk;
+    while (run) if (reader.readSome(chunk, 200)) readerBytes += chunk.size();
+  });
+  // Watch the counter, not the socket: reading would un-stall the client
+  const auto t0 = std::chrono::steady_clock::now();
+  while (g_server->stats().streamStalls == 0 && msSince(t0) < TL_HTTP_STREAM_STALL_MS + 6000)
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const double after = msSince(t0);
+  const bool closed = gone.closedByPeer();
+  const size_t midway = readerBytes;
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  run = false;
+  pub.join(); rd.join();
+  printf("  stalled subscriber closed after %.0f ms; reader took %zu kB meanwhile\n", after, midway / 1024);
+  CHECK(closed);
+  CHECK(after >= TL_HTTP_STREAM_STALL_MS && after < TL_HTTP_STREAM_STALL_MS + 5000);   // + time to fill the buffers
+  CHECK(g_server->stats().streamStalls == 1);
+  CHECK(readerBytes > midway);   // still served after the other one went
+  CHECK(g_server->stats().subscribers == 1);
+}
+
+int main() {
+  const uint16_t port = freeLoopbackPort();
+  static HttpServer server(port);
+  g_server = &server;
+  server.setRoutes([](const char* path) { return kDispatch.find(path); });
+  server.onNotFound([] { g_server->send(404, "text/plain", "not found"); });
+  if (!server.begin()) { printf("server did not start on %u\n", port); return 1; }
+
+  testRoutes(port);
+  testKeepAlive(port);
+  testHead(port);
+  testFraming(port);
+  testConcurrency(port);
+  testStreamStall(port);
+  return testExit();
+}
@@ -0,0 +1,176 @@
+// test_http_soak.cpp : 24 h of probe and poll traffic through HttpServer, heap watched per hour
+// - One simulated hour: the UI polling /sensor?imu= every 2 s on a keep-alive
+//   connection (reopened when the server closes it at
+//   TL_HTTP_KEEPALIVE_MAX_REQUESTS), a phone's captive probe every 30 s on a
+//   fresh connection and /spectrum?max_hz= once a minute. Sent back to back,
+//   not in real time
+// - Handlers work like main.cpp's: arguments through findArg(), bodies built
+//   in the request arena
+// - After the first hour (warm-up) the server task must make no heap calls at
+//   all: malloc() is wrapped and counts calls made on that thread
+// - Heap in use and the heap's footprint (glibc mallinfo2) are sampled every
+//   hour and must not drift: a leak shows as growth in use, fragmentation as
+//   a growing footprint (the host stand-in for the target's largest free
+//   block, which /diag reports)
+// - Under AddressSanitizer the malloc wrapper and mallinfo2 are skipped; the
+//   traffic and leak checks still run
+//
+// Sources: ../../src/http_server.cpp stubs/arduino_host.cpp
+
+#include "http_server.h"
+
+#include <malloc.h>
+
+#include <atomic>
+#include <string>
+
+#include "host_test.h"
+#include "http_client.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+#define TL_SOAK_HEAP 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define TL_SOAK_HEAP 0
+#endif
+#endif
+#ifndef TL_SOAK_HEAP
+#define TL_SOAK_HEAP 1
+#endif
+
+static thread_local bool t_serverTask = false;
+static std::atomic<uint32_t> g_serverMallocs{0};
+
+#if TL_SOAK_HEAP
+extern "C" void* __libc_malloc(size_t n);
+extern "C" void* malloc(size_t n) {
+  if (t_serverTask) g_serverMallocs.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(n);
+}
+#endif
+
+static HttpServer* g_server;
+
+// Body in the arena, sent without a copy
+static void sendArena(const char* type, const char* fmt, double a, double b) {
+  char* out = (char*)g_server->arena().alloc(96);
+  const int n = out ? snprintf(out, 96, fmt, a, b) : -1;
+  if (n < 0 || n >= 96) { g_server->send(500, "text/plain", "arena"); return; }
+  g_server->send(200, type, out, (size_t)n);
+}
+
+static void handleSensor() {
+  t_serverTask = true;
+  const char* v;
+  const int imu = g_server->findArg("imu", &v) ? atoi(v) : 0;
+  if (imu < 0 || imu >= TL_IMU_MAX) { g_server->send(400, "application/json", "{\"error\":\"imu out of range\"}"); return; }
+  sendArena("application/json", "{\"imu\":%.0f,\"pitch\":%.2f}", imu, 1.25);
+}
+static void handleSpectrum() {
+  t_serverTask = true;
+  float maxHz = 0.5f * TL_SAMPLE_HZ;
+  const char* v;
+  if (g_server->findArg("max_hz", &v)) { const float m = strtof(v, nullptr); if (m > 0 && m < maxHz) maxHz = m; }
+  sendArena("application/json", "{\"max_hz\":%.2f,\"bins\":%.0f}", maxHz, maxHz / 0.1953125);
+}
+static void redirectAny() {
+  t_serverTask = true;
+  g_server->sendHeader("Location", "http://trailer.local/ui");
+  g_server->send(302, "text/plain", "");
+}
+
+static constexpr uint32_t M_GET = methodBit(HTTP_GET);
+static constexpr uint8_t API = ROUTE_CORS | ROUTE_KEEPALIVE;
+static constexpr Route kRoutes[] = {
+  { "/sensor",              M_GET,       handleSensor,   API },
+  { "/spectrum",            M_GET,       handleSpectrum, API },
+  { "/generate_204",        METHODS_ANY, redirectAny,    0 },
+  { "/hotspot-detect.html", METHODS_ANY, redirectAny,    0 },
+  { "/connecttest.txt",     METHODS_ANY, redirectAny,    0 },
+};
+static constexpr auto kDispatch = makeDispatcher(kRoutes);
+
+struct HeapSample { size_t inUse = 0, footprint = 0; };
+static HeapSample heapNow() {
+  HeapSample h;
+#if TL_SOAK_HEAP
+  const struct mallinfo2 mi = mallinfo2();
+  h.inUse = mi.uordblks + mi.hblkhd;
+  h.footprint = mi.arena + mi.hblkhd;
+#endif
+  return h;
+}
+
+int main() {
+#if TL_SOAK_HEAP
+  {   // the wrapper is live: a malloc on a flagged thread is counted
+    t_serverTask = true;
+    void* volatile p = malloc(24);
+    t_serverTask = false;
+    free(p);
+    CHECK(g_serverMallocs.exchange(0) == 1);
+  }
+#endif
+  const uint16_t port = freeLoopbackPort();
+  static HttpServer server(port);
+  g_server = &server;
+  server.setRoutes([](const char* path) { return kDispatch.find(path); });
+  server.onNotFound([] { t_serverTask = true; g_server->send(404, "text/plain", "not found"); });
+  if (!server.begin()) { printf("server did not start on %u\n", port); return 1; }
+
+  constexpr int kHours = 24, kPollsPerHour = 1800, kProbeEvery = 15, kSpectrumEvery = 30;   // in polls
+  static const char* const kProbes[] = { "/generate_204", "/hotspot-detect.html", "/connecttest.txt" };
+  printf("soak: %d h of traffic, %d polls + %d probes + %d spectra per hour\n",
+         kHours, kPollsPerHour, kPollsPerHour / kProbeEvery, kPollsPerHour / kSpectrumEvery);
+
+  std::string poll, probe, spectrum;
+  HttpClient* ui = nullptr;
+  uint32_t failures = 0, reconnects = 0, mallocsAfterWarmup = 0;
+  HeapSample lo, hi;
+  for (int hour = 0; hour < kHours; ++hour) {
+    const uint32_t mallocs0 = g_serverMallocs.load();
+    for (int i = 0; i < kPollsPerHour; ++i) {
+      if (!ui) { ui = new HttpClient(port); reconnects++; }
+      poll = "GET /sensor?imu=" + std::to_string(i % TL_IMU_MAX) + " HTTP/1.1\r\nHost: trailer.local\r\n\r\n";
+      HttpResponse r;
+      if (!ui->sendRaw(poll) || !ui->read(r) || r.status != 200) failures++;
+      if (r.header("Connection") != "keep-alive") { delete ui; ui = nullptr; }
+
+      if (i % kProbeEvery == 0) {
+        probe = std::string("GET ") + kProbes[i / kProbeEvery % 3] + " HTTP/1.1\r\nHost: connectivitycheck.example\r\n\r\n";
+        if (httpRequest(port, probe).status != 302) failures++;
+      }
+      if (i % kSpectrumEvery == 0) {
+        spectrum = "GET /spectrum?max_hz=" + std::to_string(1 + i % 20) + ".5 HTTP/1.1\r\n\r\n";
+        if (httpRequest(port, spectrum).status != 200) failures++;
+      }
+    }
+    const uint32_t mallocs = g_serverMallocs.load() - mallocs0;
+    const HeapSample h = heapNow();
+    if (hour == 0) lo = hi = h;
+    else {
+      mallocsAfterWarmup += mallocs;
+      lo.inUse = std::min(lo.inUse, h.inUse); hi.inUse = std::max(hi.inUse, h.inUse);
+      lo.footprint = std::min(lo.footprint, h.footprint); hi.footprint = std::max(hi.footprint, h.footprint);
+    }
+    if (hour % 6 == 0 || hour == kHours - 1)
+      printf("  hour %2d: heap in use %zu B, footprint %zu B, server-task mallocs %u\n", hour + 1, h.inUse, h.footprint, mallocs);
+  }
+  delete ui;
+
+  const RequestArena::Stats& ar = server.arena().stats();
+  const HttpServer::Stats& st = server.stats();
+  printf("  %u failures, %u UI reconnects, arena peak %zu of %zu B, %u overflows, %u spills\n",
+         failures, reconnects, ar.peak, server.arena().capacity(), ar.overflows, st.arenaSpills);
+  CHECK(failures == 0);
+  CHECK(reconnects >= kHours * kPollsPerHour / TL_HTTP_KEEPALIVE_MAX_REQUESTS);
+  CHECK(ar.overflows == 0 && st.arenaSpills == 0);
+#if TL_SOAK_HEAP
+  printf("  after warm-up: heap in use %zu..%zu B, footprint %zu..%zu B, server-task mallocs %u\n",
+         lo.inUse, hi.inUse, lo.footprint, hi.footprint, mallocsAfterWarmup);
+  CHECK(mallocsAfterWarmup == 0);
+  CHECK(hi.inUse - lo.inUse < 4096);
+  CHECK(hi.footprint == lo.footprint);
+#endif
+  return testExit();
+}
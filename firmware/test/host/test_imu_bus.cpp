@@ -0,0 +1,172 @@
+// test_imu_bus.cpp : ImuBus against the fake I2C bus in stubs/Wire.h
+// - Probe: a missing address stays absent and is never read; an index past
+//   TL_IMU_MAX reads as absent
+// - Samples: counts scaled by the full-scale factors read at begin(), trim
+//   folded into the scale
+// - Timing: per-device read time and skew at TL_I2C_CLOCK_HZ, one acquisition
+//   cycle well inside the TL_SAMPLE_HZ tick
+// - Errors: NACKed bursts are counted per device and leave the other alone
+// - configure(): registers written, scales re-read, bursts skipped while
+//   settling; a device that NACKs keeps scales matching its registers
+//
+// Sources: ../../src/imu_bus.cpp stubs/arduino_host.cpp
+
+#include "imu_bus.h"
+
+#include <algorithm>
+
+#include "host_test.h"
+
+static const uint8_t A0 = 0x68, A1 = 0x69;
+
+// Bus time of one burst: (address + register) write, then address + 14 bytes
+static constexpr double kBurstUs = (2 + 15) * 9 * 1e6 / TL_I2C_CLOCK_HZ;
+
+static void testProbe() {
+  printf("probe\n");
+  Wire.detach(A0); Wire.detach(A1);
+  Wire.attach(A0);
+  ImuBus bus(Wire);
+  CHECK(bus.begin() == 1);
+  CHECK(bus.present(0) && !bus.present(1) && !bus.present(TL_IMU_MAX) && !bus.present(255));
+  CHECK(Wire.regs(A0)[0x6B] == 0x01);   // woken by the library bring-up
+  bus.acquire();
+  CHECK(bus.device(0).reads == 1 && bus.device(1).reads == 0);
+  CHECK(bus.sample(0).ok && !bus.sample(1).ok);
+  CHECK(!bus.readOne(1) && !bus.readOne(TL_IMU_MAX));
+  CHECK(!bus.device(TL_IMU_MAX).present && bus.device(255).reads == 0 && !bus.sample(255).ok);   // out of range: absent
+}
+
+static void testSamples(ImuBus& bus) {
+  printf("samples\n");
+  const int16_t v0[7] = { 16384, -8192, 4096, 0, 1310, -655, 131 };
+  const int16_t v1[7] = { 0, 0, -16384, 0, 0, 0, -1310 };
+  Wire.setOutputs(A0, v0);
+  Wire.setOutputs(A1, v1);
+  bus.acquire();
+  const ImuSample& s0 = bus.sample(0);
+  const ImuSample& s1 = bus.sample(1);
+  CHECK(s0.ok && s1.ok);
+  CHECK(s0.raw[0] == 16384 && s0.raw[2] == 4096 && s0.raw[3] == 1310 && s0.raw[5] == 131);
+  CHECK_NEAR(s0.ax, 1.0, 1e-6); CHECK_NEAR(s0.ay, -0.5, 1e-6); CHECK_NEAR(s0.az, 0.25, 1e-6);
+  CHECK_NEAR(s0.gx, 10.0, 1e-4); CHECK_NEAR(s0.gy, -5.0, 1e-4); CHECK_NEAR(s0.gz, 1.0, 1e-4);
+  CHECK_NEAR(s1.az, -1.0, 1e-6); CHECK_NEAR(s1.gz, -10.0, 1e-4);
+
+  // a = M (u - b), folded: diagonal scale, cross term and offset
+  AccelTrim t;
+  t.m[0] = 1.02f; t.m[4] = 0.98f; t.m[8] = 1.01f;
+  t.m[1] = t.m[3] = 0.01f;
+  t.b[0] = 0.05f; t.b[1] = -0.02f; t.b[2] = 0.03f;
+  t.valid = t.cross = true;
+  bus.setAccelTrim(0, t);
+  bus.acquire();
+  const float u[3] = { 1.0f, -0.5f, 0.25f };
+  for (int r = 0; r < 3; ++r) {
+    double want = 0;
+    for (int c = 0; c < 3; ++c) want += t.m[3 * r + c] * (u[c] - t.b[c]);
+    const float got[3] = { s0.ax, s0.ay, s0.az };
+    CHECK_NEAR(got[r], want, 1e-5);
+  }
+  CHECK_NEAR(s1.az, -1.0, 1e-6);   // the other device keeps its own (identity) trim
+  bus.setAccelTrim(0, AccelTrim{});
+  bus.acquire();
+  CHECK_NEAR(s0.ax, 1.0, 1e-6); CHECK_NEAR(s0.az, 0.25, 1e-6);
+}
+
+static void testTiming(ImuBus& bus) {
+  printf("timing\n");
+  // Minimums over many cycles: the host can be preempted mid-burst, the bus cannot
+  uint32_t read0 = UINT32_MAX, read1 = UINT32_MAX, skew = UINT32_MAX, cycle = UINT32_MAX;
+  for (int i = 0; i < 200; ++i) {
+    bus.acquire();
+    read0 = std::min(read0, bus.device(0).lastReadUs);
+    read1 = std::min(read1, bus.device(1).lastReadUs);
+    skew = std::min(skew, bus.device(1).skewUs);
+    cycle = std::min(cycle, bus.lastCycleUs());
+    CHECK(bus.device(0).skewUs == 0);
+  }
+  printf("  read %u/%u us (bus %.0f us), skew %u us, cycle %u us of a %u us tick\n",
+         (unsigned)read0, (unsigned)read1, kBurstUs, (unsigned)skew, (unsigned)cycle, 1000000u / TL_SAMPLE_HZ);
+  CHECK(read0 >= (uint32_t)kBurstUs - 1 && read0 < kBurstUs + 200);
+  CHECK(read1 >= (uint32_t)kBurstUs - 1 && read1 < kBurstUs + 200);
+  CHECK(skew >= read0 && skew < read0 + 200);   // the second device starts right after the first
+  CHECK(cycle >= read0 + read1 && cycle < 2 * kBurstUs + 400);
+  CHECK(cycle < 1000000u / TL_SAMPLE_HZ / 4);
+  CHECK(bus.maxCycleUs() >= cycle && bus.device(0).maxReadUs >= read0);
+}
+
+static void testErrors(ImuBus& bus) {
+  printf("errors\n");
+  const ImuBus::Device& d0 = bus.device(0);
+  const ImuBus::Device& d1 = bus.device(1);
+  const uint32_t reads0 = d0.reads, reads1 = d1.reads, err0 = d0.errors;
+  Wire.fail(A1, 3);
+  for (int i = 0; i < 3; ++i) {
+    bus.acquire();
+    CHECK(d0.sample.ok && !d1.sample.ok);
+  }
+  CHECK(d1.errors == 3 && d0.errors == err0);
+  CHECK(d0.reads == reads0 + 3 && d1.reads == reads1 + 3);
+  bus.acquire();
+  CHECK(d1.sample.ok && d1.errors == 3);
+  CHECK_NEAR(d1.sample.az, -1.0, 1e-6);
+
+  Wire.fail(A0, 1);
+  CHECK(!bus.readOne(0) && d0.errors == err0 + 1);
+  CHECK(bus.readOne(0) && d0.sample.ok);
+}
+
+static void testConfigure(ImuBus& bus) {
+  printf("configure\n");
+  const ImuBus::Device& d0 = bus.device(0);
+  const ImuBus::Device& d1 = bus.device(1);
+  AccelTrim t;
+  t.m[0] = t.m[4] = t.m[8] = 2.0f;
+  t.valid = true;
+  bus.setAccelTrim(0, t);
+
+  CHECK(bus.configure(3, 9, 1, 2, 20));
+  for (uint8_t a : { A0, A1 }) {
+    const uint8_t* r = Wire.regs(a);
+    CHECK(r[0x1A] == 3 && r[0x19] == 9 && r[0x1B] == 0x08 && r[0x1C] == 0x10);
+  }
+  CHECK(d0.gyroLsbPerDps == 65.5f && d0.accLsbPerG == 4096.0f);
+  CHECK_NEAR(d0.accGain[0], 2.0 / 4096, 1e-9);   // trim refolded against the new scale
+
+  // Settling: no burst goes out, no sample comes back
+  const uint32_t reads = d0.reads, txns = Wire.transactions();
+  bus.acquire();
+  CHECK(d0.settling && d1.settling && !d0.sample.ok && !d1.sample.ok);
+  CHECK(d0.reads == reads && Wire.transactions() == txns);
+  delay(25);
+  bus.acquire();
+  CHECK(!d0.settling && d0.sample.ok && d1.sample.ok);
+  CHECK_NEAR(d0.sample.ax, 2.0 * 16384 / 4096, 1e-5);
+  CHECK_NEAR(d0.sample.gx, 1310 / 65.5, 1e-4);
+  CHECK_NEAR(d1.sample.az, -16384.0 / 4096, 1e-5);
+
+  // A NACK on the first write: registers untouched, the gyro scale read fails
+  // too, and what the device reports still matches what it holds
+  Wire.fail(A1, 2);
+  CHECK(!bus.configure(0, 0, 3, 3, 0));
+  CHECK(Wire.regs(A1)[0x1B] == 0x08 && Wire.regs(A1)[0x1C] == 0x10);
+  CHECK(d1.gyroLsbPerDps == 65.5f && d1.accLsbPerG == 4096.0f);
+  CHECK(Wire.regs(A0)[0x1B] == 0x18 && d0.gyroLsbPerDps == 16.4f && d0.accLsbPerG == 2048.0f);
+  bus.setAccelTrim(0, AccelTrim{});
+}
+
+int main() {
+  Wire.begin(-1, -1, TL_I2C_CLOCK_HZ);
+  testProbe();
+
+  Wire.attach(A0); Wire.attach(A1);
+  static ImuBus bus(Wire);
+  CHECK(bus.begin() == 2 && bus.found() == 2);
+  CHECK(bus.device(0).addr == A0 && bus.device(1).addr == A1);
+  CHECK(bus.device(0).accLsbPerG == 16384.0f && bus.device(1).gyroLsbPerDps == 131.0f);
+  testSamples(bus);
+  testTiming(bus);
+  testErrors(bus);
+  testConfigure(bus);
+  return testExit();
+}
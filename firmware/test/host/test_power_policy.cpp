@@ -0,0 +1,176 @@
+// test_power_policy.cpp : PowerPolicy presence detection and clock-state transitions
+// - Boot counts as presence; IDLE only after idleAfterMs with nobody around,
+//   measured from the last presence, not from the last transition
+// - Each presence source (AP client, subscriber, station link, a new HTTP
+//   request) returns to ACTIVE on the same update; an unchanged request
+//   counter is not presence
+// - The sense-load gate: the load is scaled to the idle clock, IDLE is
+//   refused (and counted) above senseMaxPct, and the hold-off restarts
+// - Decisions carry the configured clock, publish rate and loop period; the
+//   acquisition profile's publish rate applies at once only while ACTIVE
+// - Time per mode adds up, also across the millis() wrap
+//
+// Sources: ../../src/power_policy.cpp
+
+#include "power_policy.h"
+
+#include "host_test.h"
+
+static PowerPolicy::Inputs quiet(float sensePct = 8, uint16_t mhz = TL_PWR_ACTIVE_MHZ) {
+  PowerPolicy::Inputs in;
+  in.sensePct = sensePct;
+  in.cpuMhz = mhz;
+  return in;
+}
+
+static void testIdleAfterQuiet() {
+  printf("idle after quiet\n");
+  PowerPolicy p;
+  PowerPolicy::Inputs in = quiet();
+  const uint32_t t0 = 1000;
+  PowerPolicy::Decision d = p.update(in, t0);
+  CHECK(d.mode == PowerPolicy::ACTIVE && d.cpuMhz == TL_PWR_ACTIVE_MHZ);
+  CHECK(d.publishHz == TL_PUBLISH_HZ && d.loopMs == TL_PWR_ACTIVE_LOOP_MS);
+  CHECK(p.stats().toActive == 0 && p.sinceMs() == t0);   // boot is not a transition
+  CHECK(p.update(in, t0 + TL_PWR_IDLE_AFTER_MS - 1).mode == PowerPolicy::ACTIVE);
+  d = p.update(in, t0 + TL_PWR_IDLE_AFTER_MS);
+  CHECK(d.mode == PowerPolicy::IDLE && d.cpuMhz == TL_PWR_IDLE_MHZ);
+  CHECK(d.publishHz == TL_PWR_IDLE_PUBLISH_HZ && d.loopMs == TL_PWR_IDLE_LOOP_MS);
+  CHECK(p.stats().toIdle == 1 && p.sinceMs() == t0 + TL_PWR_IDLE_AFTER_MS);
+  CHECK(p.lastSeenMs() == t0);
+  // Staying idle is not a transition
+  CHECK(p.update(quiet(24, TL_PWR_IDLE_MHZ), t0 + 2 * TL_PWR_IDLE_AFTER_MS).mode == PowerPolicy::IDLE);
+  CHECK(p.stats().toIdle == 1);
+}
+
+static void testPresenceSources() {
+  printf("presence sources\n");
+  struct Source { const char* what; void (*set)(PowerPolicy::Inputs&); };
+  const Source sources[] = {
+    { "AP client",  [](PowerPolicy::Inputs& in) { in.apClients = 1; } },
+    { "subscriber", [](PowerPolicy::Inputs& in) { in.subscribers = 2; } },
+    { "station",    [](PowerPolicy::Inputs& in) { in.stationLinked = true; } },
+    { "request",    [](PowerPolicy::Inputs& in) { in.requests += 1; } },
+  };
+  for (const Source& s : sources) {
+    PowerPolicy p;
+    PowerPolicy::Inputs in = quiet();
+    in.requests = 40;
+    uint32_t t = 5000;
+    p.update(in, t);
+    t += TL_PWR_IDLE_AFTER_MS;
+    CHECK(p.update(in, t).mode == PowerPolicy::IDLE);
+
+    // Back to ACTIVE on the very update that sees it
+    in.cpuMhz = TL_PWR_IDLE_MHZ;
+    s.set(in);
+    t += 10;
+    const PowerPolicy::Decision d = p.update(in, t);
+    printf("  %-10s -> %s\n", s.what, d.mode == PowerPolicy::ACTIVE ? "ACTIVE" : "IDLE");
+    CHECK(d.mode == PowerPolicy::ACTIVE && d.cpuMhz == TL_PWR_ACTIVE_MHZ && d.publishHz == TL_PUBLISH_HZ);
+    CHECK(p.stats().toActive == 1 && p.lastSeenMs() == t && p.sinceMs() == t);
+
+    // A lasting source holds ACTIVE; the request counter only counts when it moves
+    in.cpuMhz = TL_PWR_ACTIVE_MHZ;
+    const bool lasting = in.apClients || in.subscribers || in.stationLinked;
+    t += 3 * TL_PWR_IDLE_AFTER_MS;
+    CHECK(p.update(in, t).mode == (lasting ? PowerPolicy::ACTIVE : PowerPolicy::IDLE));
+  }
+}
+
+static void testHoldOffFromLastPresence() {
+  printf("hold-off from last presence\n");
+  PowerPolicy p;
+  PowerPolicy::Inputs in = quiet();
+  uint32_t t = 0;
+  p.update(in, t);
+  in.apClients = 1;
+  p.update(in, t += 20000);                 // a client comes and goes while ACTIVE
+  in.apClients = 0;
+  p.update(in, t += 1000);
+  CHECK(p.lastSeenMs() == 20000);
+  CHECK(p.update(in, 20000 + TL_PWR_IDLE_AFTER_MS - 1).mode == PowerPolicy::ACTIVE);
+  CHECK(p.update(in, 20000 + TL_PWR_IDLE_AFTER_MS).mode == PowerPolicy::IDLE);
+  CHECK(p.stats().toActive == 0);          // never left ACTIVE before that
+}
+
+static void testSenseLoadGate() {
+  printf("sense load gate\n");
+  const float limit = TL_PWR_SENSE_MAX_PCT;
+  const float scale = (float)TL_PWR_ACTIVE_MHZ / TL_PWR_IDLE_MHZ;
+  PowerPolicy p;
+  uint32_t t = 0;
+  p.update(quiet(), t);
+
+  // Just over the limit once scaled to the idle clock: refused, and the hold-off restarts
+  PowerPolicy::Inputs heavy = quiet(limit / scale * 1.05f);
+  t += TL_PWR_IDLE_AFTER_MS;
+  CHECK(p.update(heavy, t).mode == PowerPolicy::ACTIVE);
+  CHECK(p.stats().refused == 1 && p.lastSeenMs() == t);
+  CHECK(p.update(heavy, t + 1).mode == PowerPolicy::ACTIVE && p.stats().refused == 1);
+
+  // Under it: allowed once the restarted hold-off runs out
+  PowerPolicy::Inputs light = quiet(limit / scale * 0.95f);
+  CHECK(p.update(light, t + TL_PWR_IDLE_AFTER_MS - 1).mode == PowerPolicy::ACTIVE);
+  CHECK(p.update(light, t + TL_PWR_IDLE_AFTER_MS).mode == PowerPolicy::IDLE);
+  CHECK(p.stats().refused == 1);
+
+  // The same load measured at the idle clock is not scaled again
+  CHECK(p.update(quiet(limit * 0.95f, TL_PWR_IDLE_MHZ), t + 2 * TL_PWR_IDLE_AFTER_MS).mode == PowerPolicy::IDLE);
+
+  // No clock reported: taken as measured
+  PowerPolicy q;
+  q.update(quiet(), 0);
+  CHECK(q.update(quiet(limit * 0.95f, 0), TL_PWR_IDLE_AFTER_MS).mode == PowerPolicy::IDLE);
+}
+
+static void testPublishRate() {
+  printf("publish rate\n");
+  PowerPolicy p;
+  PowerPolicy::Inputs in = quiet();
+  p.update(in, 0);
+  p.setActivePublishHz(25);
+  CHECK(p.decision().publishHz == 25);
+  CHECK(p.update(in, TL_PWR_IDLE_AFTER_MS).publishHz == TL_PWR_IDLE_PUBLISH_HZ);
+  p.setActivePublishHz(50);                 // while IDLE: kept for the next ACTIVE
+  CHECK(p.decision().publishHz == TL_PWR_IDLE_PUBLISH_HZ);
+  in.subscribers = 1;
+  CHECK(p.update(in, TL_PWR_IDLE_AFTER_MS + 5).publishHz == 50);
+
+  PowerPolicy::Config c;
+  c.idleMhz = 160; c.idlePublishHz = 2; c.idleLoopMs = 100; c.idleAfterMs = 1000;
+  PowerPolicy custom(c);
+  custom.update(quiet(), 0);
+  const PowerPolicy::Decision d = custom.update(quiet(), 1000);
+  CHECK(d.mode == PowerPolicy::IDLE && d.cpuMhz == 160 && d.publishHz == 2 && d.loopMs == 100);
+}
+
+static void testTimeAccounting() {
+  printf("time per mode\n");
+  PowerPolicy p;
+  PowerPolicy::Inputs in = quiet();
+  const uint32_t t0 = 0xFFFFFFFFu - 10000;   // millis() wraps 10 s in
+  p.update(in, t0);
+  p.update(in, t0 + TL_PWR_IDLE_AFTER_MS);   // ACTIVE until here, across the wrap
+  CHECK(p.decision().mode == PowerPolicy::IDLE);
+  p.update(quiet(8, TL_PWR_IDLE_MHZ), t0 + 100000);
+  in.apClients = 1;
+  p.update(in, t0 + 100500);
+  p.update(in, t0 + 160500);
+  const PowerPolicy::Stats& s = p.stats();
+  printf("  active %llu ms, idle %llu ms, %u to idle, %u to active\n",
+         (unsigned long long)s.activeMs, (unsigned long long)s.idleMs, (unsigned)s.toIdle, (unsigned)s.toActive);
+  CHECK(s.activeMs == TL_PWR_IDLE_AFTER_MS + 60000);
+  CHECK(s.idleMs == 100500 - TL_PWR_IDLE_AFTER_MS);
+  CHECK(s.toIdle == 1 && s.toActive == 1);
+}
+
+int main() {
+  testIdleAfterQuiet();
+  testPresenceSources();
+  testHoldOffFromLastPresence();
+  testSenseLoadGate();
+  testPublishRate();
+  testTimeAccounting();
+  return testExit();
+}
@@ -0,0 +1,174 @@
+// test_seqlock.cpp : SeqLock<T> under a writer and concurrent readers
+// - Snap mirrors SensorState's shape (64-bit clock, per-axle floats and
+//   flags, padding); every field is a function of the tick, so a copy mixing
+//   two publishes is caught field by field
+// - Before the first write: publish 0 and an all-zero copy
+// - Flat out: one writer publishing back to back against three readers; no
+//   torn copy, and no reader ever sees the publish number go backwards
+// - At the sense rate (TL_SAMPLE_HZ): the same checks; retries are counted
+//   and reported, they need two publishes within one copy
+// - Cost: uncontended write and read, and the writer's publish time while
+//   the readers hammer it (median and 99.9th percentile: it never waits for
+//   them, so the tail is host preemption). Host figures
+//
+// Sources:
+
+#include "seqlock.h"
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+
+struct Axle { float pitch_raw, roll_raw, pitch, roll, pitch_avg, roll_avg; bool present, ok; };
+struct Snap {
+  uint32_t tick, ms;
+  int64_t us;
+  Axle axle[TL_IMU_MAX];
+  float f[24];
+  uint16_t tau;
+};
+
+static void fill(Snap& s, uint32_t k) {
+  memset(&s, 0, sizeof s);
+  s.tick = k; s.ms = k * 10; s.us = (int64_t)k * 10000 + 7;
+  for (int a = 0; a < TL_IMU_MAX; ++a) {
+    float* v = &s.axle[a].pitch_raw;
+    for (int i = 0; i < 6; ++i) v[i] = k * 0.5f + a * 8 + i;
+    s.axle[a].present = (k >> a) & 1; s.axle[a].ok = (k >> (a + 1)) & 1;
+  }
+  for (int i = 0; i < 24; ++i) s.f[i] = k * 0.25f - i;
+  s.tau = (uint16_t)(k * 3);
+}
+
+static bool consistent(const Snap& s) {
+  Snap want;
+  fill(want, s.tick);
+  if (s.ms != want.ms || s.us != want.us || s.tau != want.tau) return false;
+  for (int a = 0; a < TL_IMU_MAX; ++a) {
+    const float* v = &s.axle[a].pitch_raw;
+    const float* w = &want.axle[a].pitch_raw;
+    for (int i = 0; i < 6; ++i) if (v[i] != w[i]) return false;
+    if (s.axle[a].present != want.axle[a].present || s.axle[a].ok != want.axle[a].ok) return false;
+  }
+  for (int i = 0; i < 24; ++i) if (s.f[i] != want.f[i]) return false;
+  return true;
+}
+
+static double nowNs() {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void testEmptyAndOracle() {
+  printf("before the first write\n");
+  SeqLock<Snap> q;
+  Snap s;
+  memset(&s, 0xA5, sizeof s);
+  CHECK(q.read(s) == 0 && q.version() == 0);
+  Snap zero;
+  memset(&zero, 0, sizeof zero);
+  CHECK(memcmp(&s, &zero, sizeof s) == 0);
+
+  // The checker itself: a copy spliced from two publishes is torn
+  Snap a, b;
+  fill(a, 100); fill(b, 101);
+  CHECK(consistent(a) && consistent(b));
+  memcpy(&a, &b, sizeof a / 2);
+  CHECK(!consistent(a));
+  q.write(b);
+  CHECK(q.read(s) == 1 && s.tick == 101 && consistent(s));
+}
+
+struct RunResult { uint64_t reads = 0, torn = 0, backwards = 0; uint32_t writes = 0, retries = 0; double writeNs = 0, writeTailNs = 0; };
+
+// One writer (this thread), three readers until the writer is done
+static RunResult run(SeqLock<Snap>& q, double seconds, uint32_t periodUs) {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> reads{0}, torn{0}, backwards{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r)
+    readers.emplace_back([&] {
+      Snap s;
+      uint32_t last = 0;
+      uint64_t n = 0, t = 0, b = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const uint32_t v = q.read(s);
+        if (v && !consistent(s)) t++;
+        if (v < last) b++;
+        last = v;
+        n++;
+      }
+      reads += n; torn += t; backwards += b;
+    });
+
+  RunResult r;
+  const uint32_t retries0 = q.stats().retries, base = q.version();
+  const double t0 = nowNs();
+  Snap s;
+  uint32_t k = base;
+  std::vector<float> writeNs;
+  writeNs.reserve(1 << 20);
+  while (nowNs() - t0 < seconds * 1e9) {
+    fill(s, ++k);
+    const double a = nowNs();
+    q.write(s);
+    if (writeNs.size() < writeNs.capacity()) writeNs.push_back((float)(nowNs() - a));
+    if (periodUs) std::this_thread::sleep_for(std::chrono::microseconds(periodUs));
+  }
+  stop = true;
+  for (auto& t : readers) t.join();
+  r.reads = reads; r.torn = torn; r.backwards = backwards;
+  r.writes = k - base;
+  r.retries = q.stats().retries - retries0;
+  auto at = [&](double f) { auto it = writeNs.begin() + (size_t)(f * (writeNs.size() - 1)); std::nth_element(writeNs.begin(), it, writeNs.end()); return *it; };
+  r.writeNs = at(0.5); r.writeTailNs = at(0.999);
+  return r;
+}
+
+static void testConcurrent() {
+  static SeqLock<Snap> q;
+  printf("flat-out writer, 3 readers\n");
+  RunResult r = run(q, 1.0, 0);
+  printf("  %u writes, %llu reads, %llu torn, %llu backwards, %u retries (%.2f%% of reads)\n",
+         r.writes, (unsigned long long)r.reads, (unsigned long long)r.torn, (unsigned long long)r.backwards,
+         r.retries, 100.0 * r.retries / (r.reads ? r.reads : 1));
+  printf("  write under load: median %.0f ns, 99.9%% %.0f ns\n", r.writeNs, r.writeTailNs);
+  CHECK(r.writes > 1000 && r.reads > 1000);
+  CHECK(r.torn == 0 && r.backwards == 0);
+  CHECK(q.stats().writes == q.version());
+
+  printf("%u Hz writer, 3 readers\n", (unsigned)TL_SAMPLE_HZ);
+  r = run(q, 1.0, 1000000 / TL_SAMPLE_HZ);
+  printf("  %u writes, %llu reads, %llu torn, %llu backwards, %u retries\n",
+         r.writes, (unsigned long long)r.reads, (unsigned long long)r.torn, (unsigned long long)r.backwards, r.retries);
+  CHECK(r.writes > TL_SAMPLE_HZ / 2 && r.reads > 1000);
+  CHECK(r.torn == 0 && r.backwards == 0);
+}
+
+static void testCost() {
+  printf("uncontended cost, %zu-byte snapshot\n", sizeof(Snap));
+  static SeqLock<Snap> q;
+  constexpr int kN = 1000000;
+  Snap s;
+  fill(s, 1);
+  double t0 = nowNs();
+  for (int i = 0; i < kN; ++i) { s.tick = i; q.write(s); }
+  const double writeNs = (nowNs() - t0) / kN;
+  uint64_t sum = 0;
+  t0 = nowNs();
+  for (int i = 0; i < kN; ++i) { q.read(s); sum += s.tick; }
+  const double readNs = (nowNs() - t0) / kN;
+  printf("  write %.1f ns, read %.1f ns (checksum %llu)\n", writeNs, readNs, (unsigned long long)sum);
+  CHECK(q.version() == (uint32_t)kN && q.stats().retries == 0);
+  CHECK(sum == (uint64_t)(kN - 1) * kN);
+}
+
+int main() {
+  testEmptyAndOracle();
+  testCost();
+  testConcurrent();
+  return testExit();
+}
@@ -0,0 +1,178 @@
+// test_spectrum.cpp : fft_kernel.h and SpectrumAnalyzer accuracy
+// - Kernel: fftBitReverse + fftRadix2 against a naive double DFT, and the
+//   real-pair split against the two signals transformed on their own
+// - Peaks: tones between bins come back at the right frequency and
+//   amplitude; at half a bin the raw bin reads ~15% low (Hann scalloping), so
+//   a regression in the two-bin interpolation or its correction shows up here
+// - Channels: the sway band ignores a stronger tone outside it, roll and yaw
+//   rate keep their own peaks, noise and an interferer do not move the peak
+// - A reader holding the result defers compute() instead of blocking it
+//
+// Sources: ../../src/spectrum.cpp stubs/arduino_host.cpp
+
+#include "spectrum.h"
+#include "fft_kernel.h"
+
+#include <atomic>
+#include <complex>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+
+using Signal = std::function<double(double)>;   // value at time t (s)
+
+static std::vector<std::complex<double>> naiveDft(const std::vector<std::complex<double>>& x) {
+  const size_t n = x.size();
+  std::vector<std::complex<double>> y(n);
+  for (size_t k = 0; k < n; ++k)
+    for (size_t i = 0; i < n; ++i) y[k] += x[i] * std::polar(1.0, -2.0 * M_PI * (double)(k * i % n) / (double)n);
+  return y;
+}
+
+static void testKernel() {
+  printf("kernel\n");
+  for (size_t n : { 8, 64, 512 }) {
+    std::vector<float> d(2 * n), tw(n);
+    std::vector<std::complex<double>> x(n);
+    fftTwiddles(tw.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+      d[2 * i] = sinf(0.7f * i) + 0.3f * i / n;
+      d[2 * i + 1] = cosf(1.3f * i) - 0.2f;
+      x[i] = { d[2 * i], d[2 * i + 1] };
+    }
+    const auto ref = naiveDft(x);
+    fftBitReverse(d.data(), n);
+    fftRadix2(d.data(), n, tw.data());
+    double err = 0, peak = 0;
+    for (size_t k = 0; k < n; ++k) {
+      err = std::max(err, std::abs(ref[k] - std::complex<double>(d[2 * k], d[2 * k + 1])));
+      peak = std::max(peak, std::abs(ref[k]));
+    }
+    printf("  n=%-4zu max error %.1e of peak %.1f\n", n, err, peak);
+    CHECK(err < 1e-5 * peak);
+  }
+
+  // Real pair: x in re, y in im, split back into |X| and |Y|
+  const size_t n = 256;
+  std::vector<float> d(2 * n), tw(n), mx(n / 2 + 1), my(n / 2 + 1);
+  std::vector<std::complex<double>> xs(n), ys(n);
+  fftTwiddles(tw.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    d[2 * i] = (float)(sin(2 * M_PI * 9.3 * i / n) + 0.5);
+    d[2 * i + 1] = (float)(0.4 * cos(2 * M_PI * 31.0 * i / n) + 0.1 * sin(0.05 * i * i));
+    xs[i] = d[2 * i]; ys[i] = d[2 * i + 1];
+  }
+  const auto X = naiveDft(xs), Y = naiveDft(ys);
+  fftBitReverse(d.data(), n);
+  fftRadix2(d.data(), n, tw.data());
+  fftSplitPair(d.data(), n, mx.data(), my.data());
+  double err = 0;
+  for (size_t k = 0; k <= n / 2; ++k)
+    err = std::max({ err, fabs(mx[k] - std::abs(X[k])), fabs(my[k] - std::abs(Y[k])) });
+  printf("  real pair n=%zu max magnitude error %.1e\n", n, err);
+  CHECK(err < 1e-4);
+}
+
+// Push samples at TL_SAMPLE_HZ until one spectrum is computed over the last TL_FFT_N
+static void feed(SpectrumAnalyzer& s, const Signal& lat, const Signal& roll, const Signal& yaw) {
+  const uint32_t runs = s.stats().runs;
+  for (int i = 0; s.stats().runs == runs; ++i) {
+    const double t = (double)i / TL_SAMPLE_HZ;
+    s.push((float)lat(t), (float)roll(t), (float)yaw(t));
+    if (s.due()) s.compute();
+  }
+}
+
+// A fresh analyzer per case. Like the firmware's, they are never destroyed
+// (the result mutex is not released), so they live in static storage
+static SpectrumAnalyzer& fresh() {
+  static SpectrumAnalyzer pool[8];
+  static size_t used = 0;
+  return pool[used++ % 8];
+}
+
+static Signal tone(double hz, double amp) { return [=](double t) { return amp * sin(2 * M_PI * hz * t + 0.3); }; }
+static const Signal kZero = [](double) { return 0.0; };
+
+static void testInterpolation() {
+  printf("peak interpolation\n");
+  const double bin = SpectrumAnalyzer::binHz(), amp = 0.1;
+  for (double d : { 0.0, 0.25, 0.5, 0.75 }) {
+    SpectrumAnalyzer& s = fresh();
+    CHECK(s.begin());
+    const double hz = (5 + d) * bin;
+    feed(s, tone(hz, amp), kZero, kZero);
+    const SpectrumAnalyzer::Peak p = s.sway();
+    const float* a = s.bins(SpectrumAnalyzer::LATERAL);
+    const double raw = std::max(a[5], a[6]);
+    printf("  %.3f Hz (bin 5%+.2f): %.4f Hz, amp %.4f, raw bin %.4f\n", hz, d, p.hz, p.amp, raw);
+    CHECK_NEAR(p.hz, hz, 0.01 * bin);
+    CHECK_NEAR(p.amp, amp, 0.01 * amp);
+    if (d == 0.5) CHECK(raw < 0.9 * amp);   // uncorrected scalloping loss is what the fit removes
+  }
+}
+
+static void testChannels() {
+  printf("channels\n");
+  SpectrumAnalyzer& s = fresh();
+  CHECK(s.begin());
+  unsigned seed = 1;
+  const Signal noisy = [&](double t) {
+    seed = seed * 1103515245 + 12345;
+    return 0.05 * sin(2 * M_PI * 1.23 * t) + 0.2 * sin(2 * M_PI * 5.0 * t)
+         + 0.01 * sin(2 * M_PI * 13.0 * t) + 0.002 * ((double)(seed >> 16 & 0x7FFF) / 16384.0 - 1.0);
+  };
+  feed(s, noisy, tone(2.46, 3.0), tone(0.7, 5.0));
+  const auto sway = s.sway(), lat = s.dominant(SpectrumAnalyzer::LATERAL);
+  const auto roll = s.dominant(SpectrumAnalyzer::ROLL_RATE), yaw = s.dominant(SpectrumAnalyzer::YAW_RATE);
+  printf("  sway %.3f Hz %.4f g, lateral %.3f Hz, roll %.3f Hz %.2f, yaw %.3f Hz %.2f\n",
+         sway.hz, sway.amp, lat.hz, roll.hz, roll.amp, yaw.hz, yaw.amp);
+  CHECK_NEAR(sway.hz, 1.23, 0.005); CHECK_NEAR(sway.amp, 0.05, 0.001);
+  CHECK_NEAR(lat.hz, 5.0, 0.005);   // stronger, but outside TL_SWAY_MIN_HZ..TL_SWAY_MAX_HZ
+  CHECK_NEAR(roll.hz, 2.46, 0.005); CHECK_NEAR(roll.amp, 3.0, 0.03);
+  CHECK_NEAR(yaw.hz, 0.7, 0.005);   CHECK_NEAR(yaw.amp, 5.0, 0.05);
+  CHECK(s.resultMs() > 0);
+
+  // Nothing in the band: no peak rather than a noise bin passed off as sway
+  SpectrumAnalyzer& q = fresh();
+  CHECK(q.begin());
+  feed(q, kZero, kZero, kZero);
+  CHECK(q.sway().hz == 0 && q.sway().amp == 0);
+}
+
+static void testDeferral() {
+  printf("reader deferral\n");
+  SpectrumAnalyzer& s = fresh();
+  CHECK(s.begin());
+  feed(s, tone(1.0, 0.1), kZero, kZero);
+  for (uint32_t i = 0; i < TL_SAMPLE_HZ / TL_SPECTRUM_HZ; ++i) s.push(0, 0, 0);
+  CHECK(s.due());
+
+  std::atomic<int> phase{0};
+  std::thread reader([&] {
+    if (!s.lockResult(100)) return;
+    phase = 1;
+    while (phase != 2) std::this_thread::yield();
+    s.unlockResult();
+    phase = 3;
+  });
+  while (phase != 1) std::this_thread::yield();
+  const uint32_t runs = s.stats().runs;
+  s.compute();
+  CHECK(s.stats().runs == runs && s.stats().deferred == 1 && s.due());
+  phase = 2;
+  while (phase != 3) std::this_thread::yield();
+  reader.join();
+  s.compute();
+  CHECK(s.stats().runs == runs + 1 && !s.due());
+}
+
+int main() {
+  testKernel();
+  testInterpolation();
+  testChannels();
+  testDeferral();
+  return testExit();
+}
@@ -0,0 +1,68 @@
+// tl_rec_dump.cpp : converts a flight-recorder capture (GET /recorder/capture) to CSV
+// - Layout per firmware/include/flight_recorder.h; parsed byte by byte so the
+//   tool does not depend on the firmware headers or the host's packing
+// - One row per sample: time relative to the trigger (s), device micros, then
+//   accel (g) and gyro (deg/s) of every IMU present, using the count scales
+//   recorded at the trigger
+// - Header summary goes to stderr
+//
+// Build:  g++ -O2 -std=c++17 tl_rec_dump.cpp -o tl_rec_dump
+// Run:    curl -o cap.bin http://192.168.4.1/recorder/capture && ./tl_rec_dump cap.bin > cap.csv
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+static float getf(const uint8_t* p) { uint32_t v = get32(p); float f; memcpy(&f, &v, 4); return f; }
+
+int main(int argc, char** argv) {
+  if (argc != 2) { fprintf(stderr, "usage: %s capture.bin\n", argv[0]); return 2; }
+  FILE* fp = fopen(argv[1], "rb");
+  if (!fp) { perror(argv[1]); return 1; }
+  std::vector<uint8_t> d;
+  uint8_t chunk[4096];
+  for (size_t n; (n = fread(chunk, 1, sizeof chunk, fp)) > 0;) d.insert(d.end(), chunk, chunk + n);
+  fclose(fp);
+
+  if (d.size() < 20 || memcmp(d.data(), "TLFR", 4) != 0 || get16(&d[4]) != 1) {
+    fprintf(stderr, "not a version 1 capture\n"); return 1;
+  }
+  const uint16_t sampleSize = get16(&d[6]);
+  if (sampleSize < 16 || (sampleSize - 4) % 12) { fprintf(stderr, "bad sample size %u\n", sampleSize); return 1; }
+  const int nImu = (sampleSize - 4) / 12;
+  const size_t hdrLen = 32 + 8 * nImu;
+  const uint32_t count = get32(&d[8]), trig = get32(&d[12]), trigMs = get32(&d[16]);
+  const uint16_t hz = get16(&d[20]);
+  const uint8_t kind = d[22], mask = d[23];
+  if (d.size() < hdrLen + (size_t)count * sampleSize) { fprintf(stderr, "truncated capture\n"); return 1; }
+  std::vector<float> acc(nImu), gyro(nImu);
+  for (int i = 0; i < nImu; ++i) { acc[i] = getf(&d[28 + 4 * i]); gyro[i] = getf(&d[28 + 4 * nImu + 4 * i]); }
+
+  static const char* const kinds[] = { "none", "accel", "sway", "manual" };
+  fprintf(stderr, "trigger %s (%.3f) at uptime %u ms, %u samples at %u Hz, trigger index %u, imu mask %u\n",
+          kinds[kind < 4 ? kind : 0], getf(&d[24]), trigMs, count, hz, trig, mask);
+
+  printf("t_s,us");
+  for (int i = 0; i < nImu; ++i)
+    if (mask & (1 << i)) printf(",ax%d,ay%d,az%d,gx%d,gy%d,gz%d", i, i, i, i, i, i);
+  printf("\n");
+  const uint8_t* s = d.data() + hdrLen;
+  const uint32_t trigUs = count ? get32(s + (size_t)trig * sampleSize) : 0;
+  for (uint32_t k = 0; k < count; ++k, s += sampleSize) {
+    const uint32_t us = get32(s);
+    printf("%.4f,%u", (double)(int32_t)(us - trigUs) / 1e6, us);
+    for (int i = 0; i < nImu; ++i) {
+      if (!(mask & (1 << i))) continue;
+      const uint8_t* r = s + 4 + 12 * i;
+      for (int a = 0; a < 6; ++a) {
+        const float scale = a < 3 ? acc[i] : gyro[i];
+        printf(",%.5f", scale > 0 ? (float)(int16_t)get16(r + 2 * a) / scale : 0.0f);
+      }
+    }
+    printf("\n");
+  }
+  return 0;
+}
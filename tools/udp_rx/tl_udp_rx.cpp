@@ -0,0 +1,102 @@
+// tl_udp_rx.cpp : Linux receiver for TrailerLevel multicast telemetry
+// - Joins TL_MCAST_GROUP:TL_MCAST_PORT (or -g/-p) and decodes telemetry_packet.h frames
+// - Once per second prints receive rate, sequence gaps (loss), duplicates /
+//   out-of-order frames, undecodable datagrams, worst inter-arrival gap and
+//   the latest pitch / roll / twist, and SWAY while the device's sway alert is up
+// - A device reboot (uptime going backwards) restarts the sequence tracking
+//
+// Build:  g++ -O2 -std=c++17 -I../../firmware/include tl_udp_rx.cpp -o tl_udp_rx
+// Run:    ./tl_udp_rx [-g group] [-p port] [-i local_if_ip]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "telemetry_packet.h"
+
+// Defaults mirror firmware/include/config.h
+static const char* kDefaultGroup = "239.255.76.76";
+static const int kDefaultPort = 47600;
+
+static double nowSec() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+  const char* group = kDefaultGroup;
+  const char* iface = "0.0.0.0";
+  int port = kDefaultPort;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "-g")) group = argv[i + 1];
+    else if (!strcmp(argv[i], "-p")) port = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-i")) iface = argv[i + 1];
+    else { fprintf(stderr, "usage: %s [-g group] [-p port] [-i local_if_ip]\n", argv[0]); return 2; }
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd < 0) { perror("socket"); return 1; }
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) { perror("bind"); return 1; }
+  ip_mreq mreq = {};
+  mreq.imr_multiaddr.s_addr = inet_addr(group);
+  mreq.imr_interface.s_addr = inet_addr(iface);
+  if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) { perror("IP_ADD_MEMBERSHIP"); return 1; }
+  timeval tv = { 0, 200000 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  printf("listening on %s:%d (if %s)\n", group, port, iface);
+
+  // Totals since start, and the per-second window
+  unsigned long long totRx = 0, totLost = 0, totDup = 0, totBad = 0;
+  unsigned winRx = 0, winLost = 0, winDup = 0, winBad = 0;
+  bool haveSeq = false;
+  uint32_t lastSeq = 0, lastMs = 0;
+  double lastArrival = 0, winMaxGap = 0, winStart = nowSec();
+  TelemetryPacket last;
+
+  for (;;) {
+    uint8_t buf[512];
+    const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    const double t = nowSec();
+    if (n > 0) {
+      TelemetryPacket pk;
+      if (!pk.decode(buf, (size_t)n)) { winBad++; totBad++; }
+      else {
+        if (haveSeq && pk.ms + 1000 < lastMs) { haveSeq = false; printf("-- device restarted\n"); }
+        if (!haveSeq) { haveSeq = true; lastSeq = pk.seq; }
+        else {
+          const int32_t d = (int32_t)(pk.seq - lastSeq);
+          if (d <= 0) { winDup++; totDup++; }
+          else { winLost += d - 1; totLost += d - 1; lastSeq = pk.seq; }
+        }
+        if (lastArrival > 0 && t - lastArrival > winMaxGap) winMaxGap = t - lastArrival;
+        lastArrival = t; lastMs = pk.ms; last = pk;
+        winRx++; totRx++;
+      }
+    }
+
+    if (t - winStart >= 1.0) {
+      const double span = t - winStart;
+      const unsigned expect = winRx + winLost;
+      printf("%6.1f Hz  lost %u (%.1f%%)  dup/ooo %u  bad %u  gap %5.1f ms | pitch %6.2f roll %6.2f",
+             winRx / span, winLost, expect ? 100.0 * winLost / expect : 0.0, winDup, winBad,
+             winMaxGap * 1000.0, last.pitch, last.roll);
+      if (last.flags & TelemetryPacket::FLAG_REAR) printf(" twist %6.2f", last.twist);
+      if (last.flags & TelemetryPacket::FLAG_SWAY) printf(" SWAY");
+      printf(" | total rx %llu lost %llu dup %llu bad %llu\n", totRx, totLost, totDup, totBad);
+      fflush(stdout);
+      winRx = winLost = winDup = winBad = 0; winMaxGap = 0; winStart = t;
+    }
+  }
+}